@@ -23,6 +23,10 @@
 		#define AK_ATOMIC_OS_OSX
 	#endif
 
+	#if defined(__linux__)
+		#define AK_ATOMIC_OS_LINUX
+	#endif
+
 	#if defined(__arm__)
 		#define AK_ATOMIC_CPU_ARM
 		#define AK_ATOMIC_PTR_SIZE 4
@@ -299,6 +303,57 @@ AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_u32) == 4);
 AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_u64) == 8);
 AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_ptr) == AK_ATOMIC_PTR_SIZE);
 
+/*Size used to keep data that is written by different threads on separate cache lines. x86 lines 
+  are 64 bytes, AArch64 uses 128 since Apple cores have 128 byte lines and other cores prefetch 
+  adjacent lines in pairs. AK_Get_Cache_Line_Size queries the running machine*/
+#ifndef AK_ATOMIC_CACHE_LINE_SIZE
+#if defined(AK_ATOMIC_CPU_AARCH64)
+#define AK_ATOMIC_CACHE_LINE_SIZE 128
+#else
+#define AK_ATOMIC_CACHE_LINE_SIZE 64
+#endif
+#endif
+
+/*Atomics padded out to a full cache line and aligned to one, so elements of an array (e.g. one 
+  slot per thread) never share a line. malloc only guarantees 16 bytes, so heap memory holding them 
+  (or structs that embed them) has to come from AK_Atomic_Aligned_Allocate*/
+#if defined(AK_ATOMIC_COMPILER_MSVC)
+#define AK_ATOMIC__CACHE_ALIGNED __declspec(align(AK_ATOMIC_CACHE_LINE_SIZE))
+#else
+#define AK_ATOMIC__CACHE_ALIGNED __attribute__((aligned(AK_ATOMIC_CACHE_LINE_SIZE)))
+#endif
+
+typedef struct AK_ATOMIC__CACHE_ALIGNED {
+	ak_atomic_u8 Value;
+	uint8_t 	 Padding[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u8)];
+} ak_atomic_u8_padded;
+
+typedef struct AK_ATOMIC__CACHE_ALIGNED {
+	ak_atomic_u16 Value;
+	uint8_t 	  Padding[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u16)];
+} ak_atomic_u16_padded;
+
+typedef struct AK_ATOMIC__CACHE_ALIGNED {
+	ak_atomic_u32 Value;
+	uint8_t 	  Padding[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u32)];
+} ak_atomic_u32_padded;
+
+typedef struct AK_ATOMIC__CACHE_ALIGNED {
+	ak_atomic_u64 Value;
+	uint8_t 	  Padding[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u64)];
+} ak_atomic_u64_padded;
+
+typedef struct AK_ATOMIC__CACHE_ALIGNED {
+	ak_atomic_ptr Value;
+	uint8_t 	  Padding[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_ptr)];
+} ak_atomic_ptr_padded;
+
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_u8_padded)  == AK_ATOMIC_CACHE_LINE_SIZE);
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_u16_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_u32_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_u64_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_atomic_ptr_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+
 typedef enum {
     AK_ATOMIC_MEMORY_ORDER_RELAXED,
     AK_ATOMIC_MEMORY_ORDER_ACQUIRE,
@@ -439,9 +494,11 @@ typedef struct {
 	ak_thread Base;
 	HANDLE    Handle;
 	DWORD 	  ID;
-	DWORD     Padding;
+	DWORD     Flags;
 } ak_win32_thread;
 
+typedef ak_win32_thread ak_thread_storage;
+
 typedef struct {
 	CRITICAL_SECTION CriticalSection;
 } ak_mutex;
@@ -465,8 +522,14 @@ typedef struct {
 typedef struct {
 	ak_thread Base;
 	pthread_t Thread;
+	uint64_t  AffinityMask;
+	uint32_t  Flags;
+	char 	  Name[16];
+	uint32_t  Padding;
 } ak_posix_thread;
 
+typedef ak_posix_thread ak_thread_storage;
+
 typedef struct {
 	pthread_mutex_t Mutex;
 } ak_mutex;
@@ -502,12 +565,37 @@ typedef struct {
 /*OS Primitives*/
 
 /*Threads*/
+
+/*Every field is optional and zero keeps the default. Bit N of the affinity mask allows the thread
+  to run on logical processor N (only the first 64 processors can be selected). Posix names are
+  truncated to 15 characters. When storage is provided the thread is created in it instead of
+  allocating, and it must stay alive until AK_Thread_Delete*/
+typedef struct {
+	uint64_t 		   AffinityMask;
+	uint32_t 		   StackSize;
+	uint32_t 		   Padding;
+	const char* 	   Name;
+	ak_thread_storage* Storage;
+} ak_thread_create_info;
+
 AKATOMICDEF ak_thread* AK_Thread_Create(ak_thread_callback_func* Callback, void* UserData);
+AKATOMICDEF ak_thread* AK_Thread_Create_Ex(ak_thread_callback_func* Callback, void* UserData, const ak_thread_create_info* CreateInfo);
 AKATOMICDEF void AK_Thread_Delete(ak_thread* Thread);
 AKATOMICDEF void AK_Thread_Wait(ak_thread* Thread);
 AKATOMICDEF uint64_t AK_Thread_Get_ID(ak_thread* Thread);
 AKATOMICDEF uint64_t AK_Thread_Get_Current_ID(void);
 AKATOMICDEF uint32_t AK_Get_Processor_Thread_Count(void);
+/*L1 data cache line size of the running machine, AK_ATOMIC_CACHE_LINE_SIZE if it can't be queried*/
+AKATOMICDEF uint32_t AK_Get_Cache_Line_Size(void);
+/*How many threads the process can actually run in parallel. This is the processor count limited by
+  the process' affinity mask and, on Linux, by cgroup v1/v2 cpu quotas (rounded up) so containers 
+  don't oversubscribe themselves*/
+AKATOMICDEF uint32_t AK_Get_Effective_Processor_Thread_Count(void);
+#if defined(AK_ATOMIC_OS_LINUX)
+/*Same as above but /proc and /sys/fs/cgroup are read relative to Root ("" for the real ones)*/
+AKATOMICDEF uint32_t AK_Get_Effective_Processor_Thread_Count_From_Root(const char* Root);
+#endif
+AKATOMICDEF void AK_Thread_Yield(void);
 
 /*Mutexes*/
 AKATOMICDEF int8_t AK_Mutex_Create(ak_mutex* Mutex);
@@ -536,6 +624,53 @@ AKATOMICDEF void AK_TLS_Delete(ak_tls* TLS);
 AKATOMICDEF void* AK_TLS_Get(ak_tls* TLS);
 AKATOMICDEF void AK_TLS_Set(ak_tls* TLS, void* Data);
 
+/*Address waiting (futex). Wait blocks while the value at Address equals CompareValue. Wakeups can 
+  be spurious so callers must re-check the value in a loop*/
+AKATOMICDEF void AK_Futex_Wait(ak_atomic_u32* Address, uint32_t CompareValue);
+AKATOMICDEF void AK_Futex_Wake_One(ak_atomic_u32* Address);
+AKATOMICDEF void AK_Futex_Wake_All(ak_atomic_u32* Address);
+
+/*Asymmetric fences for protocols where one side runs constantly and the other rarely (hazard 
+  pointer reads vs. scans, biased locks). A light fence on one thread paired with a heavy fence on 
+  another orders like two seq cst fences would. The light fence is only a compiler barrier where 
+  the operating system can serialize the whole process for the heavy side, membarrier 
+  (MEMBARRIER_CMD_PRIVATE_EXPEDITED) on Linux and FlushProcessWriteBuffers on Win32. Otherwise 
+  both are seq cst fences*/
+AKATOMICDEF void AK_Atomic_Fence_Light(void);
+AKATOMICDEF void AK_Atomic_Fence_Heavy(void);
+
+/*CPU topology. Every logical processor the os has online gets an entry. Core, package and cache
+  group indices are dense (0 to count-1) while the node index is the os numa node number. SMT index
+  is 0 for the first hardware thread of a core, so skipping processors with a non zero SMT index 
+  keeps threads off of hyperthread siblings*/
+typedef struct {
+	uint32_t ID;
+	uint32_t CoreIndex;
+	uint32_t SMTIndex;
+	uint32_t PackageIndex;
+	uint32_t NodeIndex;
+	uint32_t L2GroupIndex;
+	uint32_t L3GroupIndex;
+	uint32_t Padding;
+} ak_cpu_info;
+
+typedef struct {
+	ak_cpu_info* CPUs;
+	uint32_t 	 CPUCount;
+	uint32_t 	 CoreCount;
+	uint32_t 	 PackageCount;
+	uint32_t 	 NodeCount;
+	uint32_t 	 L2GroupCount;
+	uint32_t 	 L3GroupCount;
+} ak_cpu_topology;
+
+AKATOMICDEF int8_t AK_Get_CPU_Topology(ak_cpu_topology* Topology);
+AKATOMICDEF void AK_Free_CPU_Topology(ak_cpu_topology* Topology);
+#if defined(AK_ATOMIC_OS_LINUX)
+/*Same as AK_Get_CPU_Topology but reads from a different sysfs root (/sys/devices/system by default)*/
+AKATOMICDEF int8_t AK_Get_CPU_Topology_From_Path(ak_cpu_topology* Topology, const char* SysPath);
+#endif
+
 /*High resolution performance counters & timers*/
 AKATOMICDEF void AK_Sleep(uint32_t Milliseconds);
 AKATOMICDEF uint64_t AK_Query_Performance_Counter(void);
@@ -603,6 +738,594 @@ AKATOMICDEF void AK_RW_Unlock_Reader(ak_rw_lock* Lock);
 AKATOMICDEF void AK_RW_Lock_Writer(ak_rw_lock* Lock);
 AKATOMICDEF void AK_RW_Unlock_Writer(ak_rw_lock* Lock);
 
+/*Promises and futures. The future is a single atomic word that is either empty, the head of a 
+  lock free list of continuations and waiters, or ready. Promise and future storage is owned by 
+  the caller and the future must outlive any waiters. Continuations run on the thread that sets 
+  the value, or immediately on the calling thread if the value is already set*/
+#define AK_FUTURE_CALLBACK_DEFINE(name) void name(void* Value, void* UserData)
+typedef AK_FUTURE_CALLBACK_DEFINE(ak_future_callback_func);
+
+typedef struct {
+	ak_atomic_ptr State;
+	void* 		  Value;
+} ak_future;
+
+typedef struct {
+	ak_future Future;
+} ak_promise;
+
+AKATOMICDEF int8_t AK_Promise_Create(ak_promise* Promise);
+AKATOMICDEF void AK_Promise_Delete(ak_promise* Promise);
+AKATOMICDEF ak_future* AK_Promise_Get_Future(ak_promise* Promise);
+AKATOMICDEF void AK_Promise_Set_Value(ak_promise* Promise, void* Value);
+AKATOMICDEF void* AK_Future_Wait(ak_future* Future);
+AKATOMICDEF int8_t AK_Future_Try_Get(ak_future* Future, void** Value);
+AKATOMICDEF int8_t AK_Future_Then(ak_future* Future, ak_future_callback_func* Callback, void* UserData);
+
+/*Job system*/
+#ifndef AK_JOB_SYSTEM_DEFAULT_QUEUE_CAPACITY
+#define AK_JOB_SYSTEM_DEFAULT_QUEUE_CAPACITY 4096
+#endif
+
+typedef struct ak_job_system ak_job_system;
+#define AK_JOB_CALLBACK_DEFINE(name) void name(ak_job_system* JobSystem, void* UserData)
+typedef AK_JOB_CALLBACK_DEFINE(ak_job_callback_func);
+
+typedef struct {
+	ak_job_callback_func* Callback;
+	void* 				  UserData;
+} ak_job;
+
+/*A thread count of 0 spawns one worker per processor thread and a queue capacity of 0 uses 
+  AK_JOB_SYSTEM_DEFAULT_QUEUE_CAPACITY. Counters are incremented on submission and decremented 
+  once the job finishes, so a counter can be shared across many submissions and waited on*/
+AKATOMICDEF ak_job_system* AK_Job_System_Create(uint32_t ThreadCount, uint32_t QueueCapacity);
+
+/*Numa aware pools give every numa node its own job queue, pin each worker to the processors of 
+  its node, place queues and deques on the node's memory and have idle workers steal from their own 
+  node before crossing over. Workers are split between nodes by processor count. The topology 
+  defaults to AK_Get_CPU_Topology and can be overridden, e.g. to test multi node layouts on a 
+  single node machine. Affinity is only applied for processors with an id below 64*/
+#define AK_JOB_SYSTEM_FLAG_NUMA 1
+
+typedef struct {
+	uint32_t 			   ThreadCount;
+	uint32_t 			   QueueCapacity;
+	uint32_t 			   Flags;
+	uint32_t 			   Padding;
+	const ak_cpu_topology* Topology;
+} ak_job_system_create_info;
+
+AKATOMICDEF ak_job_system* AK_Job_System_Create_Ex(const ak_job_system_create_info* CreateInfo);
+AKATOMICDEF void AK_Job_System_Delete(ak_job_system* JobSystem);
+AKATOMICDEF void AK_Job_System_Submit(ak_job_system* JobSystem, ak_job_callback_func* Callback, void* UserData, ak_atomic_u32* Counter);
+AKATOMICDEF void AK_Job_System_Submit_Batch(ak_job_system* JobSystem, const ak_job* Jobs, uint32_t JobCount, ak_atomic_u32* Counter);
+AKATOMICDEF void AK_Job_System_Wait(ak_job_system* JobSystem, ak_atomic_u32* Counter);
+AKATOMICDEF uint32_t AK_Job_System_Get_Thread_Count(ak_job_system* JobSystem);
+
+/*Parallel for. The callback receives half open sub ranges [Begin, End) of at most Grain items. 
+  Ranges are only split in half when the calling worker has no queued work left for thieves to 
+  take (lazy binary splitting), so cheap loop bodies don't pay for a job per chunk while skewed 
+  loops still balance. A grain of 0 is treated as 1. Blocks until the whole range has run. At most 
+  AK_PARALLEL_FOR_MAX_PENDING_RANGES split off ranges can wait to be picked up at once, they live on
+  the caller's stack so a parallel for never allocates*/
+#ifndef AK_PARALLEL_FOR_MAX_PENDING_RANGES
+#define AK_PARALLEL_FOR_MAX_PENDING_RANGES 64
+#endif
+
+#define AK_PARALLEL_FOR_CALLBACK_DEFINE(name) void name(uint64_t Begin, uint64_t End, void* UserData)
+typedef AK_PARALLEL_FOR_CALLBACK_DEFINE(ak_parallel_for_callback_func);
+
+AKATOMICDEF void AK_Parallel_For(ak_job_system* JobSystem, uint64_t Begin, uint64_t End, uint64_t Grain, ak_parallel_for_callback_func* Callback, void* UserData);
+
+/*Task graph. A reusable DAG of jobs where each node only gets scheduled once all of its 
+  predecessors finished. All memory is allocated up front on creation and running a graph never
+  allocates, so a graph can be built once and run every frame. A graph must be acyclic and can't
+  be run on more than one thread at the same time*/
+#define AK_TASK_GRAPH_INVALID_NODE ((uint32_t)-1)
+
+typedef struct ak_task_graph ak_task_graph;
+
+AKATOMICDEF ak_task_graph* AK_Task_Graph_Create(uint32_t MaxNodeCount, uint32_t MaxEdgeCount);
+AKATOMICDEF void AK_Task_Graph_Delete(ak_task_graph* Graph);
+AKATOMICDEF void AK_Task_Graph_Clear(ak_task_graph* Graph);
+/*Returns AK_TASK_GRAPH_INVALID_NODE when the graph is full*/
+AKATOMICDEF uint32_t AK_Task_Graph_Add_Node(ak_task_graph* Graph, ak_job_callback_func* Callback, void* UserData);
+AKATOMICDEF int8_t AK_Task_Graph_Add_Edge(ak_task_graph* Graph, uint32_t Predecessor, uint32_t Successor);
+AKATOMICDEF void AK_Task_Graph_Run(ak_task_graph* Graph, ak_job_system* JobSystem);
+
+/*Per cpu counters and freelists. On x86-64 Linux (4.18+) updates run as restartable sequences, 
+  they only touch the current cpu's cache line and commit with a plain store, getting restarted 
+  by the kernel if the thread was preempted or migrated in the middle. When rseq is not available 
+  for the calling thread everything falls back to atomics on a shared word*/
+#if defined(AK_ATOMIC_OS_LINUX) && defined(AK_ATOMIC_CPU_X64) && defined(AK_ATOMIC_COMPILER_GCC) && !defined(AK_ATOMIC_NO_RSEQ)
+#define AK_ATOMIC_RSEQ
+#endif
+
+typedef struct {
+	ak_atomic_u64_padded* Cells;
+	void* 				  Memory;
+	uint32_t 			  CPUCount;
+	uint32_t 			  Padding;
+	ak_atomic_u64 		  Shared;
+} ak_percpu_counter;
+
+typedef struct ak_percpu_list_node {
+	struct ak_percpu_list_node* Next;
+} ak_percpu_list_node;
+
+/*A lifo list per cpu, mostly useful as a freelist cache. Pop only sees the nodes that were pushed 
+  on the cpu the caller currently runs on (and nodes pushed by threads without rseq), so an empty 
+  pop does not mean the whole list is empty*/
+typedef struct {
+	ak_atomic_u64_padded* Cells;
+	void* 				  Memory;
+	uint32_t 			  CPUCount;
+	ak_atomic_u32 		  SharedLock;
+	ak_atomic_ptr 		  SharedHead;
+} ak_percpu_list;
+
+/*Returns true if the calling thread commits through rseq instead of the atomic fallback*/
+AKATOMICDEF int8_t AK_PerCPU_Is_Accelerated(void);
+
+AKATOMICDEF int8_t AK_PerCPU_Counter_Create(ak_percpu_counter* Counter);
+AKATOMICDEF void AK_PerCPU_Counter_Delete(ak_percpu_counter* Counter);
+AKATOMICDEF void AK_PerCPU_Add_U64(ak_percpu_counter* Counter, uint64_t Addend);
+/*Sums every cpu. Concurrent adds may or may not be included*/
+AKATOMICDEF uint64_t AK_PerCPU_Counter_Load(ak_percpu_counter* Counter);
+
+AKATOMICDEF int8_t AK_PerCPU_List_Create(ak_percpu_list* List);
+AKATOMICDEF void AK_PerCPU_List_Delete(ak_percpu_list* List);
+AKATOMICDEF void AK_PerCPU_List_Push(ak_percpu_list* List, ak_percpu_list_node* Node);
+AKATOMICDEF ak_percpu_list_node* AK_PerCPU_List_Pop(ak_percpu_list* List);
+
+/*Sharded counters for hosts without rseq. Adds go to one of several cache line padded cells, 
+  picked by a per thread index, and loads sum every cell. A cell count of 0 uses the effective 
+  processor count, counts are rounded up to a power of two*/
+typedef struct {
+	ak_atomic_u64_padded* Cells;
+	void* 				  Memory;
+	uint32_t 			  CellMask;
+	uint32_t 			  Padding;
+} ak_sharded_counter;
+
+AKATOMICDEF int8_t AK_Sharded_Counter_Create(ak_sharded_counter* Counter, uint32_t CellCount);
+AKATOMICDEF void AK_Sharded_Counter_Delete(ak_sharded_counter* Counter);
+AKATOMICDEF void AK_Sharded_Counter_Add(ak_sharded_counter* Counter, uint64_t Addend);
+AKATOMICDEF uint64_t AK_Sharded_Counter_Load(ak_sharded_counter* Counter);
+
+/*Adaptive counters start out as a single word, which is the cheapest option as long as nobody 
+  else writes to it. Adds are a single fetch add, only every few adds per thread probe the word 
+  with a compare exchange instead. Once enough probes failed they inflate into a sharded counter 
+  and all later adds go to the shards. An inflate threshold of 0 uses the default*/
+#ifndef AK_ADAPTIVE_COUNTER_DEFAULT_INFLATE_THRESHOLD
+#define AK_ADAPTIVE_COUNTER_DEFAULT_INFLATE_THRESHOLD 64
+#endif
+
+typedef struct {
+	ak_atomic_u64 Value;
+	ak_atomic_ptr Shards;
+	ak_atomic_u32 FailureCount;
+	uint32_t 	  InflateThreshold;
+	uint32_t 	  CellCount;
+	uint32_t 	  Padding;
+} ak_adaptive_counter;
+
+AKATOMICDEF void AK_Adaptive_Counter_Create(ak_adaptive_counter* Counter, uint32_t CellCount, uint32_t InflateThreshold);
+AKATOMICDEF void AK_Adaptive_Counter_Delete(ak_adaptive_counter* Counter);
+AKATOMICDEF void AK_Adaptive_Counter_Add(ak_adaptive_counter* Counter, uint64_t Addend);
+AKATOMICDEF uint64_t AK_Adaptive_Counter_Load(ak_adaptive_counter* Counter);
+AKATOMICDEF int8_t AK_Adaptive_Counter_Is_Inflated(ak_adaptive_counter* Counter);
+
+/*Memory reclamation callback shared by hazard pointers, epochs and rcu. Called once it is safe to 
+  free a retired pointer*/
+#define AK_RECLAIM_CALLBACK_DEFINE(name) void name(void* Pointer)
+typedef AK_RECLAIM_CALLBACK_DEFINE(ak_reclaim_callback_func);
+
+/*Hazard pointers. Every thread gets AK_HAZARD_SLOT_COUNT slots on its first use. Protect publishes
+  the pointer currently stored in an atomic in a slot and rereads it until both agree, after which
+  the object can't be freed until the slot is cleared or reused. Retired pointers are kept in a per 
+  thread list and once that list reaches max(AK_HAZARD_RETIRE_THRESHOLD, 2 * total slots) all slots 
+  of all threads are scanned and every unprotected pointer is freed, so reclamation is amortized 
+  constant time. Threads should call AK_Hazard_Thread_Exit before they exit, which releases their
+  slots for reuse and hands pending retired pointers over to the next scan*/
+#ifndef AK_HAZARD_SLOT_COUNT
+#define AK_HAZARD_SLOT_COUNT 4
+#endif
+
+#ifndef AK_HAZARD_RETIRE_THRESHOLD
+#define AK_HAZARD_RETIRE_THRESHOLD 64
+#endif
+
+AKATOMICDEF void* AK_Hazard_Protect(uint32_t Slot, ak_atomic_ptr* Source);
+/*Protects a pointer the caller knows is still alive, e.g. one that is protected by another slot*/
+AKATOMICDEF void AK_Hazard_Set(uint32_t Slot, void* Pointer);
+AKATOMICDEF void AK_Hazard_Clear(uint32_t Slot);
+/*When there is no memory to defer the free, the pointer is freed right away if no slot protects it. 
+  Returns false only if that isn't possible either, the caller still owns the pointer then*/
+AKATOMICDEF int8_t AK_Hazard_Retire(void* Pointer, ak_reclaim_callback_func* Callback);
+/*Frees every retired pointer of the calling thread (and of exited threads) that is not protected*/
+AKATOMICDEF void AK_Hazard_Scan(void);
+AKATOMICDEF void AK_Hazard_Thread_Exit(void);
+
+/*Epoch based reclamation. Cheaper than hazard pointers for read heavy structures since a reader 
+  only announces the global epoch once per critical section instead of once per pointer. Any 
+  pointer loaded inside AK_Epoch_Enter/AK_Epoch_Exit stays valid until exit. Critical sections 
+  nest and cost one relaxed store plus a light fence. Retired pointers go into one of three per 
+  thread buckets by the epoch they were retired in. The epoch only advances once every thread in a 
+  critical section has announced the current one, so a bucket is freed as a batch once the global 
+  epoch is two ahead of it. Threads should call AK_Epoch_Thread_Exit outside of a critical section
+  before they exit*/
+#ifndef AK_EPOCH_RETIRE_THRESHOLD
+#define AK_EPOCH_RETIRE_THRESHOLD 64
+#endif
+
+AKATOMICDEF void AK_Epoch_Enter(void);
+AKATOMICDEF void AK_Epoch_Exit(void);
+AKATOMICDEF void AK_Epoch_Retire(void* Pointer, ak_reclaim_callback_func* Callback);
+/*Tries to advance the epoch and frees every retired pointer of the calling thread (and of exited 
+  threads) that is safe to free. Returns the current global epoch*/
+AKATOMICDEF uint64_t AK_Epoch_Collect(void);
+AKATOMICDEF void AK_Epoch_Thread_Exit(void);
+
+/*Quiescent state based rcu. Readers load shared pointers with AK_RCU_Dereference, which is a 
+  plain acquire load, and writers publish new versions with AK_RCU_Assign. Threads that read 
+  register with AK_RCU_Thread_Online and announce a quiescent state at points where they hold no 
+  rcu protected pointers, like the top of a worker loop. AK_RCU_Synchronize blocks until every 
+  online thread passed a quiescent state, after which old versions can be freed. AK_RCU_Call 
+  defers the free instead and batches retired pointers into grace periods of 
+  AK_RCU_CALL_THRESHOLD, which are reclaimed at later quiescent states or calls. Threads have to 
+  go offline before they block for a long time (or they stall every writer) and should call 
+  AK_RCU_Thread_Exit before they exit*/
+#ifndef AK_RCU_CALL_THRESHOLD
+#define AK_RCU_CALL_THRESHOLD 64
+#endif
+
+AKATOMICDEF void AK_RCU_Thread_Online(void);
+AKATOMICDEF void AK_RCU_Thread_Offline(void);
+AKATOMICDEF void AK_RCU_Quiescent_State(void);
+AKATOMICDEF void* AK_RCU_Dereference(ak_atomic_ptr* Pointer);
+AKATOMICDEF void AK_RCU_Assign(ak_atomic_ptr* Pointer, void* Value);
+AKATOMICDEF void AK_RCU_Synchronize(void);
+AKATOMICDEF void AK_RCU_Call(void* Pointer, ak_reclaim_callback_func* Callback);
+AKATOMICDEF void AK_RCU_Thread_Exit(void);
+
+/*Lock free open addressing hash map for integer and pointer keys. Keys and values live in one 
+  array of ak_atomic_u64 pairs probed linearly, keys are claimed with a cas and never move within 
+  a table, deletes leave a tombstone value behind. Growing allocates a new table and every 
+  operation that runs into the resize helps migrate a chunk of slots (readers only help with the 
+  slot they hit), so no thread ever waits on a lock. Old tables are freed through epoch based 
+  reclamation and every operation is its own epoch critical section, so a lookup costs an epoch 
+  announcement plus the probe. Key 0 is reserved and values have to be non zero and below 
+  AK_LF_HASHMAP_TOMBSTONE. Get, Put and Remove return 0 when the key wasn't present*/
+#define AK_LF_HASHMAP_TOMBSTONE 0x7FFFFFFFFFFFFFFFull
+
+typedef struct {
+	ak_atomic_ptr Table;
+	ak_atomic_u64 Size;
+} ak_lf_hashmap;
+
+AKATOMICDEF int8_t AK_LF_Hashmap_Create(ak_lf_hashmap* Map, uint32_t InitialCapacity);
+/*Not thread safe, no other thread may use the map anymore*/
+AKATOMICDEF void AK_LF_Hashmap_Delete(ak_lf_hashmap* Map);
+AKATOMICDEF uint64_t AK_LF_Hashmap_Get(ak_lf_hashmap* Map, uint64_t Key);
+/*Returns the previous value*/
+AKATOMICDEF uint64_t AK_LF_Hashmap_Put(ak_lf_hashmap* Map, uint64_t Key, uint64_t Value);
+/*Only inserts when the key is not present. Returns the existing value or 0 if the value got 
+  inserted*/
+AKATOMICDEF uint64_t AK_LF_Hashmap_Insert(ak_lf_hashmap* Map, uint64_t Key, uint64_t Value);
+/*Returns the removed value*/
+AKATOMICDEF uint64_t AK_LF_Hashmap_Remove(ak_lf_hashmap* Map, uint64_t Key);
+AKATOMICDEF uint64_t AK_LF_Hashmap_Size(ak_lf_hashmap* Map);
+
+/*Concurrent swiss table set of u64 keys. Keys are stored in groups of 16 slots with a control 
+  byte per slot holding 7 bits of the hash, so a lookup compares a whole group of control bytes at 
+  once (with sse2 when it is available, otherwise with a scalar loop which is also what C89 builds 
+  use) and only touches the keys whose control byte matched. Readers never write shared memory, 
+  they validate a per group version like a seqlock and retry if a writer modified the group in the 
+  meantime. Writers lock one group at a time with an ak_atomic_u8 spin lock. The set doesn't grow,
+  create it with the maximum number of keys it will hold. Removed keys leave tombstones in groups 
+  without an empty slot, once they take an eighth of the slots the next insert locks every group 
+  and rehashes the set in place to drop them*/
+#if !defined(AK_ATOMIC_NO_SSE2) && (defined(AK_ATOMIC_CPU_X64) || defined(__SSE2__)) && (defined(__cplusplus) || defined(AK_ATOMIC_COMPILER_MSVC) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L))
+#define AK_ATOMIC_SSE2
+#endif
+
+typedef struct ak_swiss_set__group ak_swiss_set__group;
+
+typedef struct {
+	ak_swiss_set__group* Groups;
+	void* 				 Memory;
+	uint64_t 			 GroupMask;
+	ak_atomic_u64 		 Count;
+	ak_atomic_u64 		 Deleted;
+	ak_atomic_u32 		 Generation;
+	ak_atomic_u32 		 IsPurging;
+} ak_swiss_set;
+
+AKATOMICDEF int8_t AK_Swiss_Set_Create(ak_swiss_set* Set, uint64_t Capacity);
+AKATOMICDEF void AK_Swiss_Set_Delete(ak_swiss_set* Set);
+AKATOMICDEF int8_t AK_Swiss_Set_Contains(ak_swiss_set* Set, uint64_t Key);
+/*Returns false if the key was already present*/
+AKATOMICDEF int8_t AK_Swiss_Set_Insert(ak_swiss_set* Set, uint64_t Key);
+/*Returns false if the key wasn't present*/
+AKATOMICDEF int8_t AK_Swiss_Set_Remove(ak_swiss_set* Set, uint64_t Key);
+AKATOMICDEF uint64_t AK_Swiss_Set_Count(ak_swiss_set* Set);
+
+/*Lock free skiplist ordered by u64 keys. Next pointers carry a mark in their low bit, a node is 
+  logically deleted once its level 0 pointer is marked and then unlinked from every level by the 
+  next search that walks past it. Unlinked nodes are freed through epoch based reclamation, every 
+  operation and every iteration is an epoch critical section. Iterators walk level 0 in key order 
+  and tolerate concurrent modification: they never see a key twice or out of order, skip nodes 
+  that are deleted and may or may not see keys inserted behind them. Long scans hold back 
+  reclamation for every other epoch user, so keep them short*/
+#define AK_LF_SKIPLIST_MAX_LEVEL 24
+
+typedef struct ak_lf_skiplist__node ak_lf_skiplist__node;
+
+typedef struct {
+	ak_lf_skiplist__node* Head;
+	ak_atomic_u64 		  Count;
+} ak_lf_skiplist;
+
+typedef struct {
+	ak_lf_skiplist__node* Node;
+	uint64_t 			  Key;
+	uint64_t 			  Value;
+} ak_lf_skiplist_iterator;
+
+AKATOMICDEF int8_t AK_LF_Skiplist_Create(ak_lf_skiplist* List);
+/*Not thread safe, no other thread may use the list anymore*/
+AKATOMICDEF void AK_LF_Skiplist_Delete(ak_lf_skiplist* List);
+AKATOMICDEF int8_t AK_LF_Skiplist_Find(ak_lf_skiplist* List, uint64_t Key, uint64_t* Value);
+/*Returns false if the key was already present*/
+AKATOMICDEF int8_t AK_LF_Skiplist_Insert(ak_lf_skiplist* List, uint64_t Key, uint64_t Value);
+/*Returns false if the key wasn't present*/
+AKATOMICDEF int8_t AK_LF_Skiplist_Remove(ak_lf_skiplist* List, uint64_t Key);
+AKATOMICDEF uint64_t AK_LF_Skiplist_Count(ak_lf_skiplist* List);
+
+/*Positions the iterator at the first key that is greater or equal to StartKey. Returns false when
+  there is no such key. AK_LF_Skiplist_Iterator_End has to be called either way*/
+AKATOMICDEF int8_t AK_LF_Skiplist_Iterator_Begin(ak_lf_skiplist* List, ak_lf_skiplist_iterator* Iterator, uint64_t StartKey);
+AKATOMICDEF int8_t AK_LF_Skiplist_Iterator_Next(ak_lf_skiplist_iterator* Iterator);
+AKATOMICDEF void AK_LF_Skiplist_Iterator_End(ak_lf_skiplist_iterator* Iterator);
+
+/*Concurrent B+tree for u64 keys with optimistic lock coupling (Leis et al.). Every node carries a 
+  version word whose low bit is the write lock. Readers never write to the tree, they read a node, 
+  validate its version afterwards and restart from the root when it changed. Writers only lock the 
+  nodes they modify and split full nodes on the way down, so a split never propagates upwards. 
+  Leaves are linked left to right for range scans. Removing keys doesn't merge nodes, so nodes are 
+  only freed when the tree is deleted and no reclamation scheme is needed. Both node kinds are sized
+  to AK_OLC_BTREE_NODE_SIZE and aligned to a cache line*/
+#ifndef AK_OLC_BTREE_NODE_SIZE
+#define AK_OLC_BTREE_NODE_SIZE 512
+#endif
+
+typedef struct {
+	ak_atomic_ptr Root;
+	ak_atomic_u64 Count;
+} ak_olc_btree;
+
+AKATOMICDEF int8_t AK_OLC_BTree_Create(ak_olc_btree* Tree);
+/*Not thread safe, no other thread may use the tree anymore*/
+AKATOMICDEF void AK_OLC_BTree_Delete(ak_olc_btree* Tree);
+AKATOMICDEF int8_t AK_OLC_BTree_Find(ak_olc_btree* Tree, uint64_t Key, uint64_t* Value);
+/*Returns false if the key was already present or a node couldn't be allocated*/
+AKATOMICDEF int8_t AK_OLC_BTree_Insert(ak_olc_btree* Tree, uint64_t Key, uint64_t Value);
+/*Returns false if the key wasn't present*/
+AKATOMICDEF int8_t AK_OLC_BTree_Remove(ak_olc_btree* Tree, uint64_t Key);
+AKATOMICDEF uint64_t AK_OLC_BTree_Count(ak_olc_btree* Tree);
+/*Copies up to MaxCount pairs whose key is greater or equal to StartKey into Keys and Values in key 
+  order and returns how many were copied. Only Values may be NULL, the scan continues from the last 
+  copied key so Keys is always written. Every leaf is copied consistently but the scan as a whole is 
+  not a snapshot, keys inserted or removed behind it may or may not show up*/
+AKATOMICDEF uint32_t AK_OLC_BTree_Scan(ak_olc_btree* Tree, uint64_t StartKey, uint64_t* Keys, uint64_t* Values, uint32_t MaxCount);
+
+/*Fixed size object pool. Every thread caches two magazines of objects in thread local storage and 
+  only touches the shared depot, two lock free stacks of full and empty magazines, when both are 
+  exhausted. A magazine is traded with the depot in a single CAS, so most allocations and frees 
+  never leave the thread even when objects are freed on a different thread than they were allocated
+  on. The depot heads are tagged pointers packed in a u64 (the tag takes the upper 16 bits on 64 
+  bit targets), which assumes user space pointers fit in 48 bits. Object sizes are rounded up to 16 
+  bytes and their memory is only returned to the system by AK_Object_Pool_Delete. The pool embeds 
+  padded atomics, so a pool on the heap has to be allocated with AK_Atomic_Aligned_Allocate*/
+#ifndef AK_OBJECT_POOL_MAGAZINE_SIZE
+#define AK_OBJECT_POOL_MAGAZINE_SIZE 64
+#endif
+
+typedef struct {
+	ak_atomic_u64_padded FullMagazines;
+	ak_atomic_u64_padded EmptyMagazines;
+	ak_atomic_ptr 		 Blocks;
+	ak_atomic_ptr 		 Magazines;
+	ak_atomic_ptr 		 Caches;
+	ak_tls 				 TLS;
+	size_t 				 ObjectSize;
+} ak_object_pool;
+
+AKATOMICDEF int8_t AK_Object_Pool_Create(ak_object_pool* Pool, size_t ObjectSize);
+/*Not thread safe, no other thread may use the pool anymore. Frees every object*/
+AKATOMICDEF void AK_Object_Pool_Delete(ak_object_pool* Pool);
+AKATOMICDEF void* AK_Object_Pool_Allocate(ak_object_pool* Pool);
+AKATOMICDEF void AK_Object_Pool_Free(ak_object_pool* Pool, void* Object);
+/*Hands the calling thread's magazines back to the depot. Threads should call this before they exit,
+  otherwise the objects cached by them can't be allocated again*/
+AKATOMICDEF void AK_Object_Pool_Thread_Exit(ak_object_pool* Pool);
+
+/*Allocates Size bytes from AK_ATOMIC_MALLOC aligned to Alignment, which has to be a power of two. 
+  Pass AK_ATOMIC_CACHE_LINE_SIZE for padded atomics and the structs that embed them. The memory has
+  to be freed with AK_Atomic_Aligned_Free*/
+AKATOMICDEF void* AK_Atomic_Aligned_Allocate(size_t Size, size_t Alignment);
+AKATOMICDEF void AK_Atomic_Aligned_Free(void* Memory);
+
+/*Page provider for large buffers. Regions are aligned to AK_PAGE_HUGE_SIZE and advised to use 
+  transparent huge pages (MADV_HUGEPAGE), with AK_ATOMIC_HUGETLB defined they are mapped from the 
+  hugetlb pool (MAP_HUGETLB, or MEM_LARGE_PAGES on Win32) first and fall back to regular pages when 
+  that fails. Sizes are rounded up to AK_PAGE_HUGE_SIZE and the memory is zeroed. The arena and slab
+  reservations get the same treatment*/
+#ifndef AK_PAGE_HUGE_SIZE
+#define AK_PAGE_HUGE_SIZE (2*1024*1024)
+#endif
+
+AKATOMICDEF void* AK_Page_Allocate(size_t Size);
+AKATOMICDEF void AK_Page_Free(void* Memory, size_t Size);
+/*Backs every page of the range up front (MADV_POPULATE_WRITE, or touching every page on kernels 
+  without it) so the first pass over a buffer doesn't take page faults. Works on any writable memory,
+  but the fallback rewrites every page so call it before other threads use the range*/
+AKATOMICDEF void AK_Page_Prefault(void* Memory, size_t Size);
+
+/*Allocation hook for large buffers (lock free hash map tables and swiss set groups). Buffers smaller
+  than AK_ATOMIC_LARGE_THRESHOLD still come from AK_ATOMIC_MALLOC*/
+#if !defined(AK_ATOMIC_LARGE_MALLOC) || !defined(AK_ATOMIC_LARGE_FREE)
+#define AK_ATOMIC_LARGE_MALLOC(size) AK_Page_Allocate(size)
+#define AK_ATOMIC_LARGE_FREE(memory, size) AK_Page_Free(memory, size)
+#endif
+
+#ifndef AK_ATOMIC_LARGE_THRESHOLD
+#define AK_ATOMIC_LARGE_THRESHOLD AK_PAGE_HUGE_SIZE
+#endif
+
+/*Bump allocator over one large reserved region for memory that is freed all at once (frames, 
+  requests). Threads carve AK_ARENA_CHUNK_SIZE chunks off a shared offset with a single fetch add 
+  and then allocate from their chunk, kept in thread local storage, without any atomic operation. 
+  Allocations that don't fit in a chunk go to the shared offset directly. Pages are only backed once
+  they are touched, so the reservation can be much larger than what is actually used. Like the 
+  object pool, an arena on the heap has to be aligned to AK_ATOMIC_CACHE_LINE_SIZE*/
+#ifndef AK_ARENA_CHUNK_SIZE
+#define AK_ARENA_CHUNK_SIZE (64*1024)
+#endif
+
+typedef struct {
+	ak_atomic_u64_padded Offset;
+	uint8_t* 			 Memory;
+	size_t 				 ReserveSize;
+	ak_atomic_u32 		 Generation;
+	uint32_t 			 Padding;
+	ak_atomic_ptr 		 Caches;
+	ak_tls 				 TLS;
+} ak_arena;
+
+AKATOMICDEF int8_t AK_Arena_Create(ak_arena* Arena, size_t ReserveSize);
+/*Not thread safe, no other thread may use the arena anymore*/
+AKATOMICDEF void AK_Arena_Delete(ak_arena* Arena);
+/*Alignment has to be a power of two. Returns NULL once the reservation is used up*/
+AKATOMICDEF void* AK_Arena_Allocate(ak_arena* Arena, size_t Size, size_t Alignment);
+/*Frees every allocation at once. No other thread may allocate while the arena resets and the next 
+  allocations have to be ordered after it, e.g. by the barrier that ends a frame*/
+AKATOMICDEF void AK_Arena_Reset(ak_arena* Arena);
+/*Bytes taken from the reservation, which includes the unused rest of every thread's chunk*/
+AKATOMICDEF size_t AK_Arena_Used(ak_arena* Arena);
+
+/*Slab allocator with size classes in the style of mimalloc. Every thread owns a heap with a list of
+  AK_SLAB_PAGE_SIZE pages per size class and allocates from a page's local free list without any 
+  atomic operation. A free on the owning thread goes back to that list, a free from any other thread 
+  is a single exchange onto the page's MPSC remote free queue, which the owner collects in batches 
+  once the local list runs dry. Pages come from one reservation and are found by masking the block 
+  address, so a free only needs the pointer. Blocks are 16 byte aligned. Sizes above 
+  AK_SLAB_MAX_SIZE are mapped directly from the OS. The slab never calls AK_ATOMIC_MALLOC or 
+  AK_ATOMIC_FREE, so those can be pointed at AK_Slab_Allocate and AK_Slab_Free. Every thread that 
+  allocated keeps at least one AK_SLAB_PAGE_SIZE page per size class it used until it calls 
+  AK_Slab_Thread_Exit, so with the slab behind the hooks short lived threads that never call it leak
+  their pages until AK_Slab_Delete. The slab itself has to be aligned to AK_ATOMIC_CACHE_LINE_SIZE,
+  so keep it in static storage or allocate it with AK_Atomic_Aligned_Allocate*/
+#ifndef AK_SLAB_PAGE_SIZE
+#define AK_SLAB_PAGE_SIZE (64*1024)
+#endif
+
+#define AK_SLAB_MAX_SIZE (AK_SLAB_PAGE_SIZE/8)
+
+typedef struct {
+	ak_atomic_u64_padded Offset;
+	ak_atomic_u64_padded FreePages;
+	ak_atomic_u64 		 AbandonedHeaps;
+	uint8_t* 			 Memory;
+	void* 				 Reservation;
+	size_t 				 ReserveSize;
+	ak_tls 				 TLS;
+} ak_slab;
+
+AKATOMICDEF int8_t AK_Slab_Create(ak_slab* Slab, size_t ReserveSize);
+/*Not thread safe, no other thread may use the slab anymore. Large allocations that are still alive 
+  are not released*/
+AKATOMICDEF void AK_Slab_Delete(ak_slab* Slab);
+AKATOMICDEF void* AK_Slab_Allocate(ak_slab* Slab, size_t Size);
+AKATOMICDEF void AK_Slab_Free(ak_slab* Slab, void* Memory);
+/*Hands the calling thread's heap over to the next thread that starts allocating. Threads should call
+  this before they exit, otherwise their pages are never reused*/
+AKATOMICDEF void AK_Slab_Thread_Exit(ak_slab* Slab);
+
+/*ID allocator over a bitmap of ak_atomic_u64 words, a set bit is an ID in use. Allocation finds a 
+  clear bit with a count trailing zeros and claims it with a single fetch or, a free is a fetch and. 
+  Every thread starts its search at its own hint word, kept in thread local storage, so threads don't
+  fight over the same words. Pools with at least AK_ID_POOL_SUMMARY_MIN_IDS IDs also keep a summary 
+  bitmap with one bit per full word, so finding a free word among millions of IDs only scans 1/64 
+  of the memory. IDs are handed out in no particular order*/
+#ifndef AK_ID_POOL_SUMMARY_MIN_IDS
+#define AK_ID_POOL_SUMMARY_MIN_IDS (64*64)
+#endif
+
+#define AK_ID_POOL_INVALID ((uint32_t)-1)
+
+typedef struct {
+	ak_atomic_u64* Words;
+	ak_atomic_u64* Summary;
+	uint32_t 	   WordCount;
+	uint32_t 	   SummaryCount;
+	uint32_t 	   Capacity;
+	ak_atomic_u32  NextHint;
+	ak_tls 		   TLS;
+} ak_id_pool;
+
+/*Capacity has to be less than AK_ID_POOL_INVALID*/
+AKATOMICDEF int8_t AK_ID_Pool_Create(ak_id_pool* Pool, uint32_t Capacity);
+/*Not thread safe, no other thread may use the pool anymore*/
+AKATOMICDEF void AK_ID_Pool_Delete(ak_id_pool* Pool);
+/*Returns AK_ID_POOL_INVALID when every ID is in use. Acquires the ID, so writes made before it was 
+  freed are visible*/
+AKATOMICDEF uint32_t AK_ID_Pool_Allocate(ak_id_pool* Pool);
+AKATOMICDEF void AK_ID_Pool_Free(ak_id_pool* Pool, uint32_t ID);
+AKATOMICDEF int8_t AK_ID_Pool_Is_Allocated(ak_id_pool* Pool, uint32_t ID);
+
+/*Fiber job system. Jobs run on pooled fibers so a job that waits on a counter parks its fiber and
+  the worker thread moves on to other work instead of blocking. Only implemented for x86-64 SysV
+  (Linux) for now since the context switch is hand written*/
+#if defined(AK_ATOMIC_OS_LINUX) && defined(AK_ATOMIC_CPU_X64) && defined(AK_ATOMIC_COMPILER_GCC) && !defined(AK_ATOMIC_NO_FIBERS)
+#define AK_ATOMIC_FIBERS
+#endif
+
+#ifdef AK_ATOMIC_FIBERS
+
+#ifndef AK_FIBER_JOB_SYSTEM_DEFAULT_FIBER_COUNT
+#define AK_FIBER_JOB_SYSTEM_DEFAULT_FIBER_COUNT 128
+#endif
+
+#ifndef AK_FIBER_JOB_SYSTEM_DEFAULT_STACK_SIZE
+#define AK_FIBER_JOB_SYSTEM_DEFAULT_STACK_SIZE (64*1024)
+#endif
+
+typedef struct ak_fiber_job_system ak_fiber_job_system;
+#define AK_FIBER_JOB_CALLBACK_DEFINE(name) void name(ak_fiber_job_system* JobSystem, void* UserData)
+typedef AK_FIBER_JOB_CALLBACK_DEFINE(ak_fiber_job_callback_func);
+
+typedef struct {
+	ak_fiber_job_callback_func* Callback;
+	void* 						UserData;
+} ak_fiber_job;
+
+/*Passing 0 for any parameter uses the default (processor thread count, 
+  AK_FIBER_JOB_SYSTEM_DEFAULT_FIBER_COUNT and AK_FIBER_JOB_SYSTEM_DEFAULT_STACK_SIZE)*/
+AKATOMICDEF ak_fiber_job_system* AK_Fiber_Job_System_Create(uint32_t ThreadCount, uint32_t FiberCount, uint32_t FiberStackSize);
+AKATOMICDEF void AK_Fiber_Job_System_Delete(ak_fiber_job_system* JobSystem);
+AKATOMICDEF void AK_Fiber_Job_System_Submit(ak_fiber_job_system* JobSystem, ak_fiber_job_callback_func* Callback, void* UserData, ak_atomic_u32* Counter);
+AKATOMICDEF void AK_Fiber_Job_System_Submit_Batch(ak_fiber_job_system* JobSystem, const ak_fiber_job* Jobs, uint32_t JobCount, ak_atomic_u32* Counter);
+AKATOMICDEF void AK_Fiber_Job_System_Wait(ak_fiber_job_system* JobSystem, ak_atomic_u32* Counter);
+
+/*Parked fibers are only woken when their counter is dropped to zero by a job or by this function,
+  so work tracked outside of the job system (io, other threads) must release counters through it*/
+AKATOMICDEF void AK_Fiber_Job_System_Decrement(ak_fiber_job_system* JobSystem, ak_atomic_u32* Counter);
+
+#endif
+
 #endif
 
 #ifdef AK_ATOMIC_IMPLEMENTATION
@@ -618,7 +1341,8 @@ AKATOMICDEF void AK_RW_Unlock_Writer(ak_rw_lock* Lock);
 #pragma clang diagnostic ignored "-Wswitch"
 #endif
 
-/*Custom allocators*/
+/*Custom allocators. Threads the library starts itself (job system workers) never call 
+  AK_Slab_Thread_Exit, so when these point at a slab their heaps stay alive as long as the slab*/
 #if !defined(AK_ATOMIC_MALLOC) || !defined(AK_ATOMIC_FREE)
 #include <stdlib.h>
 #define AK_ATOMIC_MALLOC(size) malloc(size)
@@ -642,6 +1366,32 @@ AKATOMICDEF void AK_RW_Unlock_Writer(ak_rw_lock* Lock);
 
 #define AK_ATOMIC__UNREFERENCED_PARAMETER(param) (void)(param)
 
+/*Keeps the compiler from moving memory accesses across it, the cpu still can*/
+#if defined(AK_ATOMIC_COMPILER_MSVC)
+#define AK_ATOMIC__COMPILER_BARRIER() _ReadWriteBarrier()
+#else
+#define AK_ATOMIC__COMPILER_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+/*Spin loop hint so hyperthreads and the memory pipeline are not starved while we busy wait*/
+#if defined(AK_ATOMIC_COMPILER_MSVC)
+#define AK_ATOMIC__SPIN_PAUSE() YieldProcessor()
+#elif defined(AK_ATOMIC_CPU_X86) || defined(AK_ATOMIC_CPU_X64)
+#define AK_ATOMIC__SPIN_PAUSE() __asm__ volatile("pause" ::: "memory")
+#elif defined(AK_ATOMIC_CPU_AARCH64) || (defined(AK_ATOMIC_CPU_ARM) && AK_ATOMIC_ARM_VERSION >= 7)
+#define AK_ATOMIC__SPIN_PAUSE() __asm__ volatile("yield" ::: "memory")
+#else
+#define AK_ATOMIC__SPIN_PAUSE() __asm__ volatile("" ::: "memory")
+#endif
+
+#define AK_Atomic__Align_Cache_Line(memory) (void*)(((size_t)(memory) + AK_ATOMIC_CACHE_LINE_SIZE-1) & ~((size_t)AK_ATOMIC_CACHE_LINE_SIZE-1))
+
+#if defined(AK_ATOMIC_COMPILER_MSVC)
+#define AK_ATOMIC__THREAD_LOCAL __declspec(thread)
+#else
+#define AK_ATOMIC__THREAD_LOCAL __thread
+#endif
+
 /*CPU and compiler specific architecture (all other atomics are built ontop of these)*/
 #if defined(AK_ATOMIC_C11)
 
@@ -9604,12 +10354,19 @@ AKATOMICDEF void* AK_Atomic_Exchange_Ptr(ak_atomic_ptr* Object, void* NewValue,
 	return (void*)AK_Atomic_Exchange_U64((ak_atomic_u64 *)Object, (uint64_t)NewValue, MemoryOrder);
 }
 
+/*Goes through a local so the failed value isn't written through an incompatible pointer type*/
 AKATOMICDEF int8_t AK_Atomic_Compare_Exchange_Strong_Ptr(ak_atomic_ptr* Object, void** OldValue, void* NewValue, ak_atomic_memory_order MemoryOrder) {
-	return AK_Atomic_Compare_Exchange_Strong_U64((ak_atomic_u64 *)Object, (uint64_t*)OldValue, (uint64_t)NewValue, MemoryOrder);
+	uint64_t Value = (uint64_t)*OldValue;
+	int8_t Result = AK_Atomic_Compare_Exchange_Strong_U64((ak_atomic_u64 *)Object, &Value, (uint64_t)NewValue, MemoryOrder);
+	*OldValue = (void*)Value;
+	return Result;
 }
 
 AKATOMICDEF int8_t AK_Atomic_Compare_Exchange_Weak_Ptr(ak_atomic_ptr* Object, void** OldValue, void* NewValue, ak_atomic_memory_order MemoryOrder) {
-	return AK_Atomic_Compare_Exchange_Weak_U64((ak_atomic_u64 *)Object, (uint64_t*)OldValue, (uint64_t)NewValue, MemoryOrder);
+	uint64_t Value = (uint64_t)*OldValue;
+	int8_t Result = AK_Atomic_Compare_Exchange_Weak_U64((ak_atomic_u64 *)Object, &Value, (uint64_t)NewValue, MemoryOrder);
+	*OldValue = (void*)Value;
+	return Result;
 }
 
 #else
@@ -9626,12 +10383,19 @@ AKATOMICDEF void* AK_Atomic_Exchange_Ptr(ak_atomic_ptr* Object, void* NewValue,
 	return (void*)AK_Atomic_Exchange_U32((ak_atomic_u32 *)Object, (uint32_t)NewValue, MemoryOrder);
 }
 
+/*Goes through a local so the failed value isn't written through an incompatible pointer type*/
 AKATOMICDEF int8_t AK_Atomic_Compare_Exchange_Strong_Ptr(ak_atomic_ptr* Object, void** OldValue, void* NewValue, ak_atomic_memory_order MemoryOrder) {
-	return AK_Atomic_Compare_Exchange_Strong_U32((ak_atomic_u32 *)Object, (uint32_t*)OldValue, (uint32_t)NewValue, MemoryOrder);
+	uint32_t Value = (uint32_t)*OldValue;
+	int8_t Result = AK_Atomic_Compare_Exchange_Strong_U32((ak_atomic_u32 *)Object, &Value, (uint32_t)NewValue, MemoryOrder);
+	*OldValue = (void*)Value;
+	return Result;
 }
 
 AKATOMICDEF int8_t AK_Atomic_Compare_Exchange_Weak_Ptr(ak_atomic_ptr* Object, void** OldValue, void* NewValue, ak_atomic_memory_order MemoryOrder) {
-	return AK_Atomic_Compare_Exchange_Weak_U32((ak_atomic_u32 *)Object, (uint32_t*)OldValue, (uint32_t)NewValue, MemoryOrder);
+	uint32_t Value = (uint32_t)*OldValue;
+	int8_t Result = AK_Atomic_Compare_Exchange_Weak_U32((ak_atomic_u32 *)Object, &Value, (uint32_t)NewValue, MemoryOrder);
+	*OldValue = (void*)Value;
+	return Result;
 }
 
 #endif
@@ -9639,6 +10403,251 @@ AKATOMICDEF int8_t AK_Atomic_Compare_Exchange_Weak_Ptr(ak_atomic_ptr* Object, vo
 /*Threading primitives built ontop of os primitives*/
 
 /*Lightweight Semaphore*/
+AKATOMICDEF int8_t AK_LW_Semaphore_Create_With_Spin_Count(ak_lw_semaphore* Semaphore, int32_t InitialCount, uint32_t SpinCount) {
+	AK_ATOMIC_ASSERT(InitialCount >= 0);
+	if(!AK_Semaphore_Create(&Semaphore->Semaphore, 0)) return ak_atomic_false;
+	AK_Atomic_Store_U32(&Semaphore->Count, (uint32_t)InitialCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Semaphore->MaxSpinCount = SpinCount;
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_LW_Semaphore_Create(ak_lw_semaphore* Semaphore, int32_t InitialCount) {
+	return AK_LW_Semaphore_Create_With_Spin_Count(Semaphore, InitialCount, 10000);
+}
+
+AKATOMICDEF void AK_LW_Semaphore_Delete(ak_lw_semaphore* Semaphore) {
+	AK_Semaphore_Delete(&Semaphore->Semaphore);
+}
+
+AKATOMICDEF void AK_LW_Semaphore_Increment(ak_lw_semaphore* Semaphore) {
+	AK_LW_Semaphore_Add(Semaphore, 1);
+}
+
+/*Count is treated as a signed integer. A negative count is the number of threads that are 
+  blocked on the os semaphore, so we only need to touch the os semaphore when we go negative*/
+AKATOMICDEF void AK_LW_Semaphore_Decrement(ak_lw_semaphore* Semaphore) {
+	uint32_t SpinCount = Semaphore->MaxSpinCount;
+	uint32_t OldCount;
+	while(SpinCount--) {
+		OldCount = AK_Atomic_Load_U32(&Semaphore->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if((int32_t)OldCount > 0 && AK_Atomic_Compare_Exchange_Weak_U32(&Semaphore->Count, &OldCount, OldCount-1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+			return;
+		}
+		AK_ATOMIC__SPIN_PAUSE();
+	}
+
+	OldCount = AK_Atomic_Fetch_Sub_U32(&Semaphore->Count, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if((int32_t)OldCount <= 0) {
+		AK_Semaphore_Decrement(&Semaphore->Semaphore);
+	}
+}
+
+AKATOMICDEF void AK_LW_Semaphore_Add(ak_lw_semaphore* Semaphore, int32_t Increment) {
+	int32_t OldCount, ReleaseCount;
+	AK_ATOMIC_ASSERT(Increment >= 0);
+	OldCount = (int32_t)AK_Atomic_Fetch_Add_U32(&Semaphore->Count, (uint32_t)Increment, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	ReleaseCount = -OldCount < Increment ? -OldCount : Increment;
+	if(ReleaseCount > 0) {
+		AK_Semaphore_Add(&Semaphore->Semaphore, ReleaseCount);
+	}
+}
+
+/*CPU topology*/
+static void AK_CPU_Topology__Init_Flat(ak_cpu_topology* Topology, ak_cpu_info* CPUs, uint32_t CPUCount) {
+	uint32_t i;
+	for(i = 0; i < CPUCount; i++) {
+		AK_ATOMIC_MEMORY_CLEAR(CPUs + i, sizeof(ak_cpu_info));
+		CPUs[i].ID = i;
+		CPUs[i].CoreIndex = i;
+		CPUs[i].PackageIndex = 0;
+		CPUs[i].L2GroupIndex = i;
+		CPUs[i].L3GroupIndex = 0;
+	}
+	Topology->CPUs = CPUs;
+	Topology->CPUCount = CPUCount;
+	Topology->CoreCount = CPUCount;
+	Topology->PackageCount = 1;
+	Topology->NodeCount = 1;
+	Topology->L2GroupCount = CPUCount;
+	Topology->L3GroupCount = 1;
+}
+
+/*Replaces every key with the index of its distinct value in first seen order and returns how many 
+  distinct values there are*/
+static uint32_t AK_CPU_Topology__Densify(uint64_t* Keys, uint64_t* Scratch, uint32_t Count) {
+	uint32_t i, j, DistinctCount = 0;
+	for(i = 0; i < Count; i++) {
+		for(j = 0; j < DistinctCount; j++) {
+			if(Scratch[j] == Keys[i]) break;
+		}
+		if(j == DistinctCount) Scratch[DistinctCount++] = Keys[i];
+		Keys[i] = j;
+	}
+	return DistinctCount;
+}
+
+/*Keys holds 5 arrays of CPUCount entries: package, core (unique per package), L2 and L3 keys 
+  followed by scratch space. Node indices are expected to already be filled in*/
+static void AK_CPU_Topology__Build(ak_cpu_topology* Topology, uint64_t* Keys) {
+	uint32_t i, j, CPUCount = Topology->CPUCount;
+	uint64_t* PackageKeys = Keys;
+	uint64_t* CoreKeys = Keys + CPUCount;
+	uint64_t* L2Keys = Keys + CPUCount*2;
+	uint64_t* L3Keys = Keys + CPUCount*3;
+	uint64_t* Scratch = Keys + CPUCount*4;
+
+	Topology->PackageCount = AK_CPU_Topology__Densify(PackageKeys, Scratch, CPUCount);
+	Topology->CoreCount = AK_CPU_Topology__Densify(CoreKeys, Scratch, CPUCount);
+	Topology->L2GroupCount = AK_CPU_Topology__Densify(L2Keys, Scratch, CPUCount);
+	Topology->L3GroupCount = AK_CPU_Topology__Densify(L3Keys, Scratch, CPUCount);
+	Topology->NodeCount = 0;
+
+	for(i = 0; i < CPUCount; i++) {
+		ak_cpu_info* CPU = Topology->CPUs + i;
+		CPU->PackageIndex = (uint32_t)PackageKeys[i];
+		CPU->CoreIndex = (uint32_t)CoreKeys[i];
+		CPU->L2GroupIndex = (uint32_t)L2Keys[i];
+		CPU->L3GroupIndex = (uint32_t)L3Keys[i];
+		CPU->SMTIndex = 0;
+		for(j = 0; j < i; j++) {
+			if(Topology->CPUs[j].CoreIndex == CPU->CoreIndex) CPU->SMTIndex++;
+		}
+		if(CPU->NodeIndex >= Topology->NodeCount) Topology->NodeCount = CPU->NodeIndex+1;
+	}
+}
+
+AKATOMICDEF void AK_Free_CPU_Topology(ak_cpu_topology* Topology) {
+	if(Topology->CPUs) AK_ATOMIC_FREE(Topology->CPUs);
+	AK_ATOMIC_MEMORY_CLEAR(Topology, sizeof(ak_cpu_topology));
+}
+
+/*Promise and future*/
+
+/*The future state is NULL while nothing is attached, a continuation list while the value is 
+  pending, or this sentinel once the value is set. Waiters are continuations without a callback 
+  that live on the waiting thread's stack*/
+#define AK_FUTURE__READY ((void*)(size_t)1)
+
+typedef struct ak_future_continuation ak_future_continuation;
+struct ak_future_continuation {
+	ak_future_continuation*  Next;
+	ak_future_callback_func* Callback;
+	void* 					 UserData;
+	ak_atomic_u32 			 IsSignaled;
+	uint32_t 				 Padding;
+};
+
+/*Pushes the continuation unless the value is already set*/
+static int8_t AK_Future__Attach(ak_future* Future, ak_future_continuation* Continuation) {
+	void* State = AK_Atomic_Load_Ptr(&Future->State, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	do {
+		if(State == AK_FUTURE__READY) return ak_atomic_false;
+		Continuation->Next = (ak_future_continuation*)State;
+	} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(&Future->State, &State, Continuation, AK_ATOMIC_MEMORY_ORDER_ACQ_REL));
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_Promise_Create(ak_promise* Promise) {
+	AK_Atomic_Store_Ptr(&Promise->Future.State, NULL, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Promise->Future.Value = NULL;
+	return ak_atomic_true;
+}
+
+/*Frees continuations of a promise that was never set. Nobody can be waiting on it at this point*/
+AKATOMICDEF void AK_Promise_Delete(ak_promise* Promise) {
+	void* State = AK_Atomic_Exchange_Ptr(&Promise->Future.State, NULL, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	ak_future_continuation* Continuation;
+	if(State == AK_FUTURE__READY) return;
+
+	Continuation = (ak_future_continuation*)State;
+	while(Continuation) {
+		ak_future_continuation* Next = Continuation->Next;
+		AK_ATOMIC_ASSERT(Continuation->Callback);
+		AK_ATOMIC_FREE(Continuation);
+		Continuation = Next;
+	}
+}
+
+AKATOMICDEF ak_future* AK_Promise_Get_Future(ak_promise* Promise) {
+	return &Promise->Future;
+}
+
+AKATOMICDEF void AK_Promise_Set_Value(ak_promise* Promise, void* Value) {
+	ak_future* Future = &Promise->Future;
+	ak_future_continuation* Continuation;
+	ak_future_continuation* Reversed = NULL;
+	void* State;
+
+	Future->Value = Value;
+	State = AK_Atomic_Exchange_Ptr(&Future->State, AK_FUTURE__READY, AK_ATOMIC_MEMORY_ORDER_ACQ_REL);
+	AK_ATOMIC_ASSERT(State != AK_FUTURE__READY);
+	if(State == AK_FUTURE__READY) return;
+
+	/*The list is a stack, flip it so continuations run in the order they were attached*/
+	Continuation = (ak_future_continuation*)State;
+	while(Continuation) {
+		ak_future_continuation* Next = Continuation->Next;
+		Continuation->Next = Reversed;
+		Reversed = Continuation;
+		Continuation = Next;
+	}
+
+	while(Reversed) {
+		ak_future_continuation* Next = Reversed->Next;
+		if(Reversed->Callback) {
+			Reversed->Callback(Value, Reversed->UserData);
+			AK_ATOMIC_FREE(Reversed);
+		} else {
+			/*A waiter may return and reuse its stack as soon as it sees the flag, so it must not be
+			  touched afterwards apart from the wake on its address*/
+			ak_atomic_u32* IsSignaled = &Reversed->IsSignaled;
+			AK_Atomic_Store_U32(IsSignaled, ak_atomic_true, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+			AK_Futex_Wake_One(IsSignaled);
+		}
+		Reversed = Next;
+	}
+}
+
+AKATOMICDEF void* AK_Future_Wait(ak_future* Future) {
+	ak_future_continuation Waiter;
+	Waiter.Callback = NULL;
+	Waiter.UserData = NULL;
+	AK_Atomic_Store_U32(&Waiter.IsSignaled, ak_atomic_false, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	if(AK_Future__Attach(Future, &Waiter)) {
+		while(!AK_Atomic_Load_U32(&Waiter.IsSignaled, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+			AK_Futex_Wait(&Waiter.IsSignaled, ak_atomic_false);
+		}
+	}
+	return Future->Value;
+}
+
+AKATOMICDEF int8_t AK_Future_Try_Get(ak_future* Future, void** Value) {
+	if(AK_Atomic_Load_Ptr(&Future->State, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != AK_FUTURE__READY) return ak_atomic_false;
+	if(Value) *Value = Future->Value;
+	return ak_atomic_true;
+}
+
+/*Returns false if the continuation could not be allocated*/
+AKATOMICDEF int8_t AK_Future_Then(ak_future* Future, ak_future_callback_func* Callback, void* UserData) {
+	ak_future_continuation* Continuation;
+	if(AK_Future_Try_Get(Future, NULL)) {
+		Callback(Future->Value, UserData);
+		return ak_atomic_true;
+	}
+
+	Continuation = (ak_future_continuation*)AK_ATOMIC_MALLOC(sizeof(ak_future_continuation));
+	AK_ATOMIC_ASSERT(Continuation);
+	if(!Continuation) return ak_atomic_false;
+
+	Continuation->Callback = Callback;
+	Continuation->UserData = UserData;
+	if(!AK_Future__Attach(Future, Continuation)) {
+		AK_ATOMIC_FREE(Continuation);
+		Callback(Future->Value, UserData);
+	}
+	return ak_atomic_true;
+}
 
 /*OS Primtive implementations*/
 #if defined(AK_ATOMIC_OS_WIN32) /*Win32*/
@@ -9649,19 +10658,68 @@ static DWORD CALLBACK AK_Win32_Thread_Callback(void* Parameter) {
 	return (DWORD)Thread->Callback(Thread, Thread->UserData);
 }
 
+#define AK_THREAD__USER_STORAGE 1
+
+typedef HRESULT WINAPI ak_win32_set_thread_description(HANDLE Thread, PCWSTR Description);
+
+/*SetThreadDescription only exists on Windows 10 1607 and later so it has to be loaded at runtime*/
+static void AK_Win32_Thread__Set_Name(HANDLE Handle, const char* Name) {
+	WCHAR WideName[64];
+	ak_win32_set_thread_description* SetThreadDescriptionFunc;
+	HMODULE Kernel32 = GetModuleHandleA("kernel32.dll");
+	if(!Kernel32) return;
+
+	SetThreadDescriptionFunc = (ak_win32_set_thread_description*)(void*)GetProcAddress(Kernel32, "SetThreadDescription");
+	if(!SetThreadDescriptionFunc) return;
+
+	if(MultiByteToWideChar(CP_UTF8, 0, Name, -1, WideName, 64) != 0) {
+		SetThreadDescriptionFunc(Handle, WideName);
+	}
+}
+
 AKATOMICDEF ak_thread* AK_Thread_Create(ak_thread_callback_func* Callback, void* UserData) {
-	ak_win32_thread* Thread = (ak_win32_thread*)AK_ATOMIC_MALLOC(sizeof(ak_win32_thread));
-	AK_ATOMIC_ASSERT(Thread);
-	if (!Thread) return NULL;
+	return AK_Thread_Create_Ex(Callback, UserData, NULL);
+}
+
+AKATOMICDEF ak_thread* AK_Thread_Create_Ex(ak_thread_callback_func* Callback, void* UserData, const ak_thread_create_info* CreateInfo) {
+	ak_win32_thread* Thread;
+	DWORD CreationFlags = CREATE_SUSPENDED;
+	SIZE_T StackSize = 0;
+
+	if(CreateInfo && CreateInfo->Storage) {
+		Thread = CreateInfo->Storage;
+		Thread->Flags = AK_THREAD__USER_STORAGE;
+	} else {
+		Thread = (ak_win32_thread*)AK_ATOMIC_MALLOC(sizeof(ak_win32_thread));
+		AK_ATOMIC_ASSERT(Thread);
+		if (!Thread) return NULL;
+		Thread->Flags = 0;
+	}
+
+	if(CreateInfo && CreateInfo->StackSize) {
+		StackSize = CreateInfo->StackSize;
+		CreationFlags |= STACK_SIZE_PARAM_IS_A_RESERVATION;
+	}
 
 	Thread->Base.Callback = Callback;
 	Thread->Base.UserData = UserData;
-	Thread->Handle = CreateThread(NULL, 0, AK_Win32_Thread_Callback, Thread, 0, &Thread->ID);
+	Thread->Handle = CreateThread(NULL, StackSize, AK_Win32_Thread_Callback, Thread, CreationFlags, &Thread->ID);
  	AK_ATOMIC_ASSERT(Thread->Handle != NULL);
 	if (Thread->Handle == NULL) {
-		AK_ATOMIC_FREE(Thread);
+		if(!(Thread->Flags & AK_THREAD__USER_STORAGE)) AK_ATOMIC_FREE(Thread);
 		return NULL;
 	}
+
+	/*The thread starts suspended so it never runs on the wrong processor*/
+	if(CreateInfo && CreateInfo->AffinityMask) {
+		SetThreadAffinityMask(Thread->Handle, (DWORD_PTR)CreateInfo->AffinityMask);
+	}
+
+	if(CreateInfo && CreateInfo->Name) {
+		AK_Win32_Thread__Set_Name(Thread->Handle, CreateInfo->Name);
+	}
+
+	ResumeThread(Thread->Handle);
 	return &Thread->Base;
 }
 
@@ -9675,9 +10733,12 @@ AKATOMICDEF void AK_Thread_Delete(ak_thread* Thread) {
 
 		if (Win32Thread->Handle) {
 			CloseHandle(Win32Thread->Handle);
+			Win32Thread->Handle = NULL;
 		}
 
-		AK_ATOMIC_FREE(Win32Thread);
+		if(!(Win32Thread->Flags & AK_THREAD__USER_STORAGE)) {
+			AK_ATOMIC_FREE(Win32Thread);
+		}
 	}
 }
 
@@ -9711,6 +10772,33 @@ AKATOMICDEF uint32_t AK_Get_Processor_Thread_Count(void) {
 	return SystemInfo.dwNumberOfProcessors;
 }
 
+AKATOMICDEF uint32_t AK_Get_Cache_Line_Size(void) {
+	SYSTEM_LOGICAL_PROCESSOR_INFORMATION* Infos = NULL;
+	DWORD i, Size = 0;
+	uint32_t Result = AK_ATOMIC_CACHE_LINE_SIZE;
+
+	GetLogicalProcessorInformation(NULL, &Size);
+	if(Size) Infos = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)AK_ATOMIC_MALLOC(Size);
+	if(!Infos) return Result;
+
+	if(GetLogicalProcessorInformation(Infos, &Size)) {
+		for(i = 0; i < Size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION); i++) {
+			if(Infos[i].Relationship == RelationCache && Infos[i].Cache.Level == 1 && 
+			   (Infos[i].Cache.Type == CacheData || Infos[i].Cache.Type == CacheUnified)) {
+				Result = Infos[i].Cache.LineSize;
+				break;
+			}
+		}
+	}
+
+	AK_ATOMIC_FREE(Infos);
+	return Result;
+}
+
+AKATOMICDEF void AK_Thread_Yield(void) {
+	SwitchToThread();
+}
+
 /*Win32 Mutexes*/
 AKATOMICDEF int8_t AK_Mutex_Create(ak_mutex* Mutex) {
 	InitializeCriticalSection(&Mutex->CriticalSection);
@@ -9819,6 +10907,194 @@ AKATOMICDEF void AK_TLS_Set(ak_tls* TLS, void* Data) {
 		TlsSetValue(TLS->Index, Data);
 }
 
+/*Win32 CPU topology*/
+static uint32_t AK_Win32__Lowest_Bit(ULONG_PTR Mask) {
+	uint32_t Index = 0;
+	if(!Mask) return 0;
+	while(!(Mask & 1)) {
+		Mask >>= 1;
+		Index++;
+	}
+	return Index;
+}
+
+/*GetLogicalProcessorInformation only reports the current processor group so at most 64 processors
+  are visible, which matches the affinity masks used everywhere else*/
+AKATOMICDEF int8_t AK_Get_CPU_Topology(ak_cpu_topology* Topology) {
+	SYSTEM_LOGICAL_PROCESSOR_INFORMATION* Infos = NULL;
+	DWORD Size = 0;
+	uint32_t i, j, InfoCount, CPUCount = 0, PackageCount = 0;
+	ak_cpu_info* CPUs;
+	uint64_t* Keys;
+	ULONG_PTR ProcessorMask = 0;
+
+	AK_ATOMIC_MEMORY_CLEAR(Topology, sizeof(ak_cpu_topology));
+	GetLogicalProcessorInformation(NULL, &Size);
+	if(Size) Infos = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)AK_ATOMIC_MALLOC(Size);
+	if(!Infos || !GetLogicalProcessorInformation(Infos, &Size)) {
+		if(Infos) AK_ATOMIC_FREE(Infos);
+		CPUCount = AK_Get_Processor_Thread_Count();
+		if(!CPUCount) CPUCount = 1;
+		CPUs = (ak_cpu_info*)AK_ATOMIC_MALLOC(sizeof(ak_cpu_info)*CPUCount);
+		AK_ATOMIC_ASSERT(CPUs);
+		if(!CPUs) return ak_atomic_false;
+		AK_CPU_Topology__Init_Flat(Topology, CPUs, CPUCount);
+		return ak_atomic_true;
+	}
+
+	InfoCount = Size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+	for(i = 0; i < InfoCount; i++) {
+		if(Infos[i].Relationship == RelationProcessorCore) ProcessorMask |= Infos[i].ProcessorMask;
+	}
+	for(i = 0; i < sizeof(ULONG_PTR)*8; i++) {
+		if(ProcessorMask & ((ULONG_PTR)1 << i)) CPUCount++;
+	}
+
+	CPUs = (ak_cpu_info*)AK_ATOMIC_MALLOC(sizeof(ak_cpu_info)*CPUCount);
+	Keys = (uint64_t*)AK_ATOMIC_MALLOC(sizeof(uint64_t)*CPUCount*5);
+	AK_ATOMIC_ASSERT(CPUs && Keys);
+	if(!CPUs || !Keys) {
+		if(CPUs) AK_ATOMIC_FREE(CPUs);
+		if(Keys) AK_ATOMIC_FREE(Keys);
+		AK_ATOMIC_FREE(Infos);
+		return ak_atomic_false;
+	}
+	AK_ATOMIC_MEMORY_CLEAR(CPUs, sizeof(ak_cpu_info)*CPUCount);
+	Topology->CPUs = CPUs;
+	Topology->CPUCount = CPUCount;
+
+	j = 0;
+	for(i = 0; i < sizeof(ULONG_PTR)*8; i++) {
+		if(ProcessorMask & ((ULONG_PTR)1 << i)) {
+			CPUs[j].ID = i;
+			Keys[j] = 0;
+			Keys[CPUCount*2+j] = i;
+			Keys[CPUCount*3+j] = (uint64_t)-1;
+			j++;
+		}
+	}
+
+	for(i = 0; i < InfoCount; i++) {
+		SYSTEM_LOGICAL_PROCESSOR_INFORMATION* Info = Infos + i;
+		uint64_t Key = AK_Win32__Lowest_Bit(Info->ProcessorMask);
+		for(j = 0; j < CPUCount; j++) {
+			if(!(Info->ProcessorMask & ((ULONG_PTR)1 << CPUs[j].ID))) continue;
+			switch(Info->Relationship) {
+				case RelationProcessorCore: Keys[CPUCount+j] = Key; break;
+				case RelationProcessorPackage: Keys[j] = PackageCount; break;
+				case RelationNumaNode: CPUs[j].NodeIndex = Info->NumaNode.NodeNumber; break;
+				case RelationCache: {
+					if(Info->Cache.Type != CacheInstruction) {
+						if(Info->Cache.Level == 2) Keys[CPUCount*2+j] = Key;
+						if(Info->Cache.Level == 3) Keys[CPUCount*3+j] = Key;
+					}
+				} break;
+				default: break;
+			}
+		}
+		if(Info->Relationship == RelationProcessorPackage) PackageCount++;
+	}
+
+	/*Core ids are only unique within a package*/
+	for(j = 0; j < CPUCount; j++) Keys[CPUCount+j] |= Keys[j] << 32;
+
+	AK_CPU_Topology__Build(Topology, Keys);
+	AK_ATOMIC_FREE(Keys);
+	AK_ATOMIC_FREE(Infos);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF uint32_t AK_Get_Effective_Processor_Thread_Count(void) {
+	DWORD_PTR ProcessMask, SystemMask;
+	uint32_t Result = 0;
+	if(GetProcessAffinityMask(GetCurrentProcess(), &ProcessMask, &SystemMask)) {
+		while(ProcessMask) {
+			ProcessMask &= ProcessMask-1;
+			Result++;
+		}
+	}
+	if(!Result) Result = AK_Get_Processor_Thread_Count();
+	return Result ? Result : 1;
+}
+
+/*Win32 Address waiting*/
+#ifdef AK_ATOMIC_COMPILER_MSVC
+#pragma comment(lib, "synchronization.lib")
+#endif
+
+AKATOMICDEF void AK_Futex_Wait(ak_atomic_u32* Address, uint32_t CompareValue) {
+	WaitOnAddress(Address, &CompareValue, sizeof(uint32_t), INFINITE);
+}
+
+AKATOMICDEF void AK_Futex_Wake_One(ak_atomic_u32* Address) {
+	WakeByAddressSingle(Address);
+}
+
+AKATOMICDEF void AK_Futex_Wake_All(ak_atomic_u32* Address) {
+	WakeByAddressAll(Address);
+}
+
+/*Win32 Asymmetric fences*/
+AKATOMICDEF void AK_Atomic_Fence_Light(void) {
+	AK_ATOMIC__COMPILER_BARRIER();
+}
+
+AKATOMICDEF void AK_Atomic_Fence_Heavy(void) {
+	AK_ATOMIC__COMPILER_BARRIER();
+	FlushProcessWriteBuffers();
+	AK_ATOMIC__COMPILER_BARRIER();
+}
+
+/*Win32 Numa memory*/
+static void* AK_OS__Allocate_Node_Memory(size_t Size, uint32_t NodeID) {
+	return VirtualAllocExNuma(GetCurrentProcess(), NULL, Size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE, NodeID);
+}
+
+static void AK_OS__Free_Node_Memory(void* Memory, size_t Size) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Size);
+	VirtualFree(Memory, 0, MEM_RELEASE);
+}
+
+/*Win32 Virtual memory. Reserved pages have to be committed before they are touched*/
+static void* AK_OS__Reserve_Memory(size_t Size) {
+	return VirtualAlloc(NULL, Size, MEM_RESERVE, PAGE_READWRITE);
+}
+
+static int8_t AK_OS__Commit_Memory(void* Memory, size_t Size) {
+	return VirtualAlloc(Memory, Size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+static void AK_OS__Release_Memory(void* Memory, size_t Size) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Size);
+	VirtualFree(Memory, 0, MEM_RELEASE);
+}
+
+/*Large pages need the lock memory privilege, without it the allocation fails and we fall back. 
+  Windows has no transparent huge pages*/
+static void* AK_OS__Allocate_Huge_Memory(size_t Size) {
+#ifdef AK_ATOMIC_HUGETLB
+	SIZE_T LargePageSize = GetLargePageMinimum();
+	if(LargePageSize && !(Size % LargePageSize)) {
+		void* Memory = VirtualAlloc(NULL, Size, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE);
+		if(Memory) return Memory;
+	}
+#endif
+	return VirtualAlloc(NULL, Size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void AK_OS__Advise_Huge_Pages(void* Memory, size_t Size) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Memory);
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Size);
+}
+
+static void AK_OS__Prefault_Memory(void* Memory, size_t Size) {
+	volatile uint8_t* At = (volatile uint8_t*)Memory;
+	SYSTEM_INFO SystemInfo;
+	size_t Offset;
+	GetSystemInfo(&SystemInfo);
+	for(Offset = 0; Offset < Size; Offset += SystemInfo.dwPageSize) At[Offset] = At[Offset];
+}
+
 /*Win32 High resolution performance counters & timers*/
 AKATOMICDEF void AK_Sleep(uint32_t Milliseconds) {
 	Sleep(Milliseconds);
@@ -9839,25 +11115,129 @@ AKATOMICDEF uint64_t AK_Query_Performance_Frequency(void) {
 #elif defined(AK_ATOMIC_OS_POSIX) /*Posix*/
 
 #include <unistd.h>
+#include <sched.h>
 #include <time.h>
+#include <limits.h>
+
+#if defined(AK_ATOMIC_OS_LINUX)
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#include <sys/mman.h>
+
+/*Strict ISO modes hide the Linux only flag*/
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS 0x20
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0x4000
+#endif
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+
+/*Linux 5.14+, older kernels fail with EINVAL*/
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+/*Strict ISO C modes hide the declaration*/
+#ifndef __cplusplus
+long syscall(long Number, ...);
+int madvise(void* Address, size_t Length, int Advice);
+#endif
+#endif
 
 /*Posix Threads*/
+#define AK_THREAD__USER_STORAGE 1
+#define AK_THREAD__HAS_NAME 2
+
+/*Affinity and names are applied by the new thread itself before the callback runs. The gnu only
+  pthread attribute and naming functions aren't visible in strict ISO modes, the raw interfaces 
+  used here always are*/
+static void AK_Thread__Apply_Settings(ak_posix_thread* Thread) {
+#if defined(AK_ATOMIC_OS_LINUX)
+	if(Thread->AffinityMask) {
+		unsigned long Mask[64/(8*sizeof(unsigned long))];
+		uint32_t i;
+		for(i = 0; i < sizeof(Mask)/sizeof(Mask[0]); i++) {
+			Mask[i] = (unsigned long)(Thread->AffinityMask >> (i*8*sizeof(unsigned long)));
+		}
+		syscall(SYS_sched_setaffinity, 0, sizeof(Mask), Mask);
+	}
+
+	if(Thread->Flags & AK_THREAD__HAS_NAME) {
+		prctl(PR_SET_NAME, (unsigned long)(size_t)Thread->Name, 0, 0, 0);
+	}
+#elif defined(AK_ATOMIC_OS_OSX)
+	if(Thread->Flags & AK_THREAD__HAS_NAME) {
+		pthread_setname_np(Thread->Name);
+	}
+#else
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Thread);
+#endif
+}
+
 static void* AK_Thread__Internal_Proc(void* Parameter) {
 	ak_thread* Thread = (ak_thread*)Parameter;
+	AK_Thread__Apply_Settings((ak_posix_thread*)Thread);
 	return (void*)(size_t)Thread->Callback(Thread, Thread->UserData);
 }
 
 AKATOMICDEF ak_thread* AK_Thread_Create(ak_thread_callback_func* Callback, void* UserData) {
-	ak_posix_thread* Thread = (ak_posix_thread*)AK_ATOMIC_MALLOC(sizeof(ak_posix_thread));
-	AK_ATOMIC_ASSERT(Thread);
-	if(!Thread) return NULL;
+	return AK_Thread_Create_Ex(Callback, UserData, NULL);
+}
+
+AKATOMICDEF ak_thread* AK_Thread_Create_Ex(ak_thread_callback_func* Callback, void* UserData, const ak_thread_create_info* CreateInfo) {
+	ak_posix_thread* Thread;
+	pthread_attr_t Attributes;
+	pthread_attr_t* AttributesPtr = NULL;
+	int ErrorCode;
+
+	if(CreateInfo && CreateInfo->Storage) {
+		Thread = CreateInfo->Storage;
+		Thread->Flags = AK_THREAD__USER_STORAGE;
+	} else {
+		Thread = (ak_posix_thread*)AK_ATOMIC_MALLOC(sizeof(ak_posix_thread));
+		AK_ATOMIC_ASSERT(Thread);
+		if(!Thread) return NULL;
+		Thread->Flags = 0;
+	}
 
 	Thread->Base.Callback = Callback;
 	Thread->Base.UserData = UserData;
-	int ErrorCode = pthread_create(&Thread->Thread, NULL, AK_Thread__Internal_Proc, Thread);
+	Thread->AffinityMask = CreateInfo ? CreateInfo->AffinityMask : 0;
+
+	if(CreateInfo && CreateInfo->Name) {
+		uint32_t i;
+		for(i = 0; i < sizeof(Thread->Name)-1 && CreateInfo->Name[i]; i++) {
+			Thread->Name[i] = CreateInfo->Name[i];
+		}
+		Thread->Name[i] = 0;
+		Thread->Flags |= AK_THREAD__HAS_NAME;
+	}
+
+	if(CreateInfo && CreateInfo->StackSize) {
+		size_t PageSize = (size_t)sysconf(_SC_PAGESIZE);
+		size_t StackSize = ((size_t)CreateInfo->StackSize + PageSize-1) & ~(PageSize-1);
+#ifdef PTHREAD_STACK_MIN
+		if(StackSize < (size_t)PTHREAD_STACK_MIN) StackSize = (size_t)PTHREAD_STACK_MIN;
+#endif
+		pthread_attr_init(&Attributes);
+		pthread_attr_setstacksize(&Attributes, StackSize);
+		AttributesPtr = &Attributes;
+	}
+
+	ErrorCode = pthread_create(&Thread->Thread, AttributesPtr, AK_Thread__Internal_Proc, Thread);
+	if(AttributesPtr) pthread_attr_destroy(AttributesPtr);
 	AK_ATOMIC_ASSERT(ErrorCode == 0);
 	if(ErrorCode != 0) {
-		AK_ATOMIC_FREE(Thread);
+		if(!(Thread->Flags & AK_THREAD__USER_STORAGE)) AK_ATOMIC_FREE(Thread);
 		return NULL;
 	}
 
@@ -9870,7 +11250,9 @@ AKATOMICDEF void AK_Thread_Delete(ak_thread* Thread) {
 
 	if(PosixThread) {
 		AK_Thread_Wait(Thread);
-		AK_ATOMIC_FREE(PosixThread);
+		if(!(PosixThread->Flags & AK_THREAD__USER_STORAGE)) {
+			AK_ATOMIC_FREE(PosixThread);
+		}
 	}
 }
 
@@ -9904,6 +11286,10 @@ AKATOMICDEF uint32_t AK_Get_Processor_Thread_Count(void) {
 	return Result;
 }
 
+AKATOMICDEF void AK_Thread_Yield(void) {
+	sched_yield();
+}
+
 /*Posix Mutexes*/
 AKATOMICDEF int8_t AK_Mutex_Create(ak_mutex* Mutex) {
 	int8_t ErrorCode = pthread_mutex_init(&Mutex->Mutex, NULL);
@@ -10008,7 +11394,7 @@ AKATOMICDEF void AK_Condition_Variable_Wake_All(ak_condition_variable* Condition
 
 /*Posix Thread Local Storage*/
 AKATOMICDEF int8_t AK_TLS_Create(ak_tls* TLS) {
-	int ErrorCode = pthread_key_create(&TLS->Key, NULL) == 0;
+	int ErrorCode = pthread_key_create(&TLS->Key, NULL);
 	AK_ATOMIC_ASSERT(ErrorCode == 0);
 	return ErrorCode == 0;
 } 
@@ -10025,6 +11411,558 @@ AKATOMICDEF void AK_TLS_Set(ak_tls* TLS, void* Data) {
 	pthread_setspecific(TLS->Key, Data);
 }
 
+/*Posix CPU topology*/
+#if defined(AK_ATOMIC_OS_LINUX)
+#include <fcntl.h>
+
+#define AK_SYS__MAX_PATH 256
+
+static uint32_t AK_Sys__Read_File(const char* Path, char* Buffer, uint32_t BufferSize) {
+	ssize_t Length;
+	int File = open(Path, O_RDONLY);
+	Buffer[0] = 0;
+	if(File < 0) return 0;
+	Length = read(File, Buffer, BufferSize-1);
+	close(File);
+	if(Length <= 0) return 0;
+	Buffer[Length] = 0;
+	return (uint32_t)Length;
+}
+
+static char* AK_Sys__Append_String(char* At, char* End, const char* String) {
+	while(*String && At < End) *At++ = *String++;
+	*At = 0;
+	return At;
+}
+
+static char* AK_Sys__Append_U32(char* At, char* End, uint32_t Value) {
+	char Digits[10];
+	uint32_t DigitCount = 0;
+	do {
+		Digits[DigitCount++] = (char)('0' + Value % 10);
+		Value /= 10;
+	} while(Value);
+	while(DigitCount && At < End) *At++ = Digits[--DigitCount];
+	*At = 0;
+	return At;
+}
+
+/*Builds Root/Part0<Index0>Part1<Index1>Part2. Pass a NULL part to stop early*/
+static const char* AK_Sys__Path(char* Buffer, const char* Root, const char* Part0, uint32_t Index0, const char* Part1, uint32_t Index1, const char* Part2) {
+	char* End = Buffer + AK_SYS__MAX_PATH-1;
+	char* At = AK_Sys__Append_String(Buffer, End, Root);
+	At = AK_Sys__Append_String(At, End, Part0);
+	if(Part1) {
+		At = AK_Sys__Append_U32(At, End, Index0);
+		At = AK_Sys__Append_String(At, End, Part1);
+		if(Part2) {
+			At = AK_Sys__Append_U32(At, End, Index1);
+			AK_Sys__Append_String(At, End, Part2);
+		}
+	}
+	return Buffer;
+}
+
+static const char* AK_Sys__Parse_U32(const char* At, uint32_t* Value) {
+	*Value = 0;
+	while(*At == ' ' || *At == '\t') At++;
+	if(*At < '0' || *At > '9') return NULL;
+	while(*At >= '0' && *At <= '9') *Value = *Value*10 + (uint32_t)(*At++ - '0');
+	return At;
+}
+
+/*Parses the next range of a cpu list like "0-3,8,10-11". Returns NULL once the list is done*/
+static const char* AK_Sys__Next_Range(const char* At, uint32_t* First, uint32_t* Last) {
+	if(!At) return NULL;
+	while(*At == ',') At++;
+	At = AK_Sys__Parse_U32(At, First);
+	if(!At) return NULL;
+	*Last = *First;
+	if(*At == '-') {
+		At = AK_Sys__Parse_U32(At+1, Last);
+		if(!At) return NULL;
+	}
+	return At;
+}
+
+static uint32_t AK_Sys__Read_U32(const char* Path, uint32_t Default) {
+	char Buffer[32];
+	uint32_t Value;
+	if(!AK_Sys__Read_File(Path, Buffer, sizeof(Buffer))) return Default;
+	if(!AK_Sys__Parse_U32(Buffer, &Value)) return Default;
+	return Value;
+}
+
+static uint32_t AK_Sys__First_CPU(const char* Path, uint32_t Default) {
+	char Buffer[1024];
+	uint32_t First, Last;
+	if(!AK_Sys__Read_File(Path, Buffer, sizeof(Buffer))) return Default;
+	if(!AK_Sys__Next_Range(Buffer, &First, &Last)) return Default;
+	return First;
+}
+
+AKATOMICDEF int8_t AK_Get_CPU_Topology_From_Path(ak_cpu_topology* Topology, const char* SysPath) {
+	char Path[AK_SYS__MAX_PATH];
+	char List[4096];
+	const char* At;
+	uint32_t First, Last, i, CPUCount = 0;
+	ak_cpu_info* CPUs;
+	uint64_t* Keys;
+
+	AK_ATOMIC_MEMORY_CLEAR(Topology, sizeof(ak_cpu_topology));
+
+	if(AK_Sys__Read_File(AK_Sys__Path(Path, SysPath, "/cpu/online", 0, NULL, 0, NULL), List, sizeof(List))) {
+		for(At = AK_Sys__Next_Range(List, &First, &Last); At; At = AK_Sys__Next_Range(At, &First, &Last)) {
+			if(Last >= First) CPUCount += Last-First+1;
+		}
+	}
+
+	if(!CPUCount) {
+		/*No sysfs, treat every processor as its own core*/
+		CPUCount = AK_Get_Processor_Thread_Count();
+		if(!CPUCount) CPUCount = 1;
+		CPUs = (ak_cpu_info*)AK_ATOMIC_MALLOC(sizeof(ak_cpu_info)*CPUCount);
+		AK_ATOMIC_ASSERT(CPUs);
+		if(!CPUs) return ak_atomic_false;
+		AK_CPU_Topology__Init_Flat(Topology, CPUs, CPUCount);
+		return ak_atomic_true;
+	}
+
+	CPUs = (ak_cpu_info*)AK_ATOMIC_MALLOC(sizeof(ak_cpu_info)*CPUCount);
+	Keys = (uint64_t*)AK_ATOMIC_MALLOC(sizeof(uint64_t)*CPUCount*5);
+	AK_ATOMIC_ASSERT(CPUs && Keys);
+	if(!CPUs || !Keys) {
+		if(CPUs) AK_ATOMIC_FREE(CPUs);
+		if(Keys) AK_ATOMIC_FREE(Keys);
+		return ak_atomic_false;
+	}
+	AK_ATOMIC_MEMORY_CLEAR(CPUs, sizeof(ak_cpu_info)*CPUCount);
+	Topology->CPUs = CPUs;
+	Topology->CPUCount = CPUCount;
+
+	i = 0;
+	for(At = AK_Sys__Next_Range(List, &First, &Last); At && i < CPUCount; At = AK_Sys__Next_Range(At, &First, &Last)) {
+		for(; First <= Last && i < CPUCount; First++) CPUs[i++].ID = First;
+	}
+
+	for(i = 0; i < CPUCount; i++) {
+		uint32_t ID = CPUs[i].ID;
+		uint32_t CacheIndex;
+		uint64_t Package = AK_Sys__Read_U32(AK_Sys__Path(Path, SysPath, "/cpu/cpu", ID, "/topology/physical_package_id", 0, NULL), 0);
+		uint64_t Core = AK_Sys__Read_U32(AK_Sys__Path(Path, SysPath, "/cpu/cpu", ID, "/topology/core_id", 0, NULL), ID);
+
+		Keys[i] = Package;
+		Keys[CPUCount+i] = (Package << 32) | Core;
+
+		/*Cache groups are keyed by the first processor sharing the cache. Processors without cache
+		  info get a private L2 and a shared L3*/
+		Keys[CPUCount*2+i] = ID;
+		Keys[CPUCount*3+i] = (uint64_t)-1;
+		for(CacheIndex = 0; CacheIndex < 8; CacheIndex++) {
+			uint32_t Level = AK_Sys__Read_U32(AK_Sys__Path(Path, SysPath, "/cpu/cpu", ID, "/cache/index", CacheIndex, "/level"), 0);
+			if(Level == 2 || Level == 3) {
+				char Type[32];
+				AK_Sys__Read_File(AK_Sys__Path(Path, SysPath, "/cpu/cpu", ID, "/cache/index", CacheIndex, "/type"), Type, sizeof(Type));
+				if(Type[0] != 'I') {
+					uint32_t Shared = AK_Sys__First_CPU(AK_Sys__Path(Path, SysPath, "/cpu/cpu", ID, "/cache/index", CacheIndex, "/shared_cpu_list"), ID);
+					Keys[CPUCount*(Level == 2 ? 2 : 3)+i] = Shared;
+				}
+			}
+		}
+	}
+
+	/*Nodes list their processors, not the other way around*/
+	if(AK_Sys__Read_File(AK_Sys__Path(Path, SysPath, "/node/online", 0, NULL, 0, NULL), List, sizeof(List))) {
+		uint32_t NodeFirst, NodeLast;
+		const char* NodeAt;
+		char* NodeList = List;
+		char CPUList[4096];
+		for(NodeAt = AK_Sys__Next_Range(NodeList, &NodeFirst, &NodeLast); NodeAt; NodeAt = AK_Sys__Next_Range(NodeAt, &NodeFirst, &NodeLast)) {
+			for(; NodeFirst <= NodeLast; NodeFirst++) {
+				if(!AK_Sys__Read_File(AK_Sys__Path(Path, SysPath, "/node/node", NodeFirst, "/cpulist", 0, NULL), CPUList, sizeof(CPUList))) continue;
+				for(At = AK_Sys__Next_Range(CPUList, &First, &Last); At; At = AK_Sys__Next_Range(At, &First, &Last)) {
+					for(i = 0; i < CPUCount; i++) {
+						if(CPUs[i].ID >= First && CPUs[i].ID <= Last) CPUs[i].NodeIndex = NodeFirst;
+					}
+				}
+			}
+		}
+	}
+
+	AK_CPU_Topology__Build(Topology, Keys);
+	AK_ATOMIC_FREE(Keys);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_Get_CPU_Topology(ak_cpu_topology* Topology) {
+	return AK_Get_CPU_Topology_From_Path(Topology, "/sys/devices/system");
+}
+
+/*Posix effective parallelism*/
+/*Returns the cpu limit of a single cgroup directory or 0 when it has none*/
+static uint32_t AK_CGroup__Read_Limit(const char* Directory, int8_t IsV2) {
+	char Path[AK_SYS__MAX_PATH];
+	char Buffer[64];
+	char* End = Path + AK_SYS__MAX_PATH-1;
+	uint32_t Quota, Period;
+	const char* At;
+
+	if(IsV2) {
+		/*cpu.max is "<quota> <period>" or "max <period>"*/
+		AK_Sys__Append_String(AK_Sys__Append_String(Path, End, Directory), End, "/cpu.max");
+		if(!AK_Sys__Read_File(Path, Buffer, sizeof(Buffer))) return 0;
+		At = AK_Sys__Parse_U32(Buffer, &Quota);
+		if(!At || !AK_Sys__Parse_U32(At, &Period)) return 0;
+	} else {
+		/*An unlimited quota is -1 which fails to parse as unsigned*/
+		AK_Sys__Append_String(AK_Sys__Append_String(Path, End, Directory), End, "/cpu.cfs_quota_us");
+		if(!AK_Sys__Read_File(Path, Buffer, sizeof(Buffer)) || !AK_Sys__Parse_U32(Buffer, &Quota)) return 0;
+		AK_Sys__Append_String(AK_Sys__Append_String(Path, End, Directory), End, "/cpu.cfs_period_us");
+		if(!AK_Sys__Read_File(Path, Buffer, sizeof(Buffer)) || !AK_Sys__Parse_U32(Buffer, &Period)) return 0;
+	}
+
+	if(!Quota || !Period) return 0;
+	return (Quota + Period-1) / Period;
+}
+
+/*Limits of every ancestor apply as well, so walk up from the process' cgroup to the mount root
+  and keep the smallest one. Containers usually only see their own cgroup as the root*/
+static uint32_t AK_CGroup__Read_Hierarchy_Limit(const char* Root, const char* Mount, const char* CGroupPath, uint32_t CGroupPathLength, int8_t IsV2) {
+	char Directory[AK_SYS__MAX_PATH];
+	char* End = Directory + AK_SYS__MAX_PATH-1;
+	char* MountEnd;
+	uint32_t Result = 0;
+
+	MountEnd = AK_Sys__Append_String(AK_Sys__Append_String(Directory, End, Root), End, Mount);
+	for(;;) {
+		char* At = MountEnd;
+		uint32_t i, Limit;
+		for(i = 0; i < CGroupPathLength && At < End; i++) *At++ = CGroupPath[i];
+		*At = 0;
+
+		if(!access(Directory, F_OK)) {
+			Limit = AK_CGroup__Read_Limit(Directory, IsV2);
+			if(Limit && (!Result || Limit < Result)) Result = Limit;
+		}
+
+		if(!CGroupPathLength) break;
+		while(CGroupPathLength && CGroupPath[CGroupPathLength-1] != '/') CGroupPathLength--;
+		if(CGroupPathLength) CGroupPathLength--;
+	}
+
+	return Result;
+}
+
+static uint32_t AK_CGroup__Get_CPU_Limit(const char* Root) {
+	char Path[AK_SYS__MAX_PATH];
+	char Buffer[4096];
+	char* End = Path + AK_SYS__MAX_PATH-1;
+	const char* Line;
+	uint32_t Result = 0;
+
+	AK_Sys__Append_String(AK_Sys__Append_String(Path, End, Root), End, "/proc/self/cgroup");
+	if(!AK_Sys__Read_File(Path, Buffer, sizeof(Buffer))) return 0;
+
+	/*Each line is "<id>:<controllers>:<path>". v2 has an empty controller list*/
+	for(Line = Buffer; *Line; ) {
+		const char* Controllers = Line;
+		const char* CGroupPath;
+		const char* LineEnd;
+		uint32_t Limit = 0;
+
+		while(*Controllers && *Controllers != ':' && *Controllers != '\n') Controllers++;
+		if(*Controllers != ':') break;
+		Controllers++;
+		CGroupPath = Controllers;
+		while(*CGroupPath && *CGroupPath != ':' && *CGroupPath != '\n') CGroupPath++;
+		if(*CGroupPath != ':') break;
+		LineEnd = ++CGroupPath;
+		while(*LineEnd && *LineEnd != '\n') LineEnd++;
+
+		if(CGroupPath-Controllers == 1) {
+			Limit = AK_CGroup__Read_Hierarchy_Limit(Root, "/sys/fs/cgroup", CGroupPath, (uint32_t)(LineEnd-CGroupPath), ak_atomic_true);
+			if(!Limit) Limit = AK_CGroup__Read_Hierarchy_Limit(Root, "/sys/fs/cgroup/unified", CGroupPath, (uint32_t)(LineEnd-CGroupPath), ak_atomic_true);
+		} else {
+			/*Look for "cpu" as a whole entry of the comma separated controller list*/
+			const char* At = Controllers;
+			int8_t HasCPU = ak_atomic_false;
+			while(At < CGroupPath-1) {
+				const char* EntryEnd = At;
+				while(EntryEnd < CGroupPath-1 && *EntryEnd != ',') EntryEnd++;
+				if(EntryEnd-At == 3 && At[0] == 'c' && At[1] == 'p' && At[2] == 'u') HasCPU = ak_atomic_true;
+				At = EntryEnd+1;
+			}
+
+			if(HasCPU) {
+				static const char* Mounts[] = {"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpuacct,cpu"};
+				uint32_t i;
+				for(i = 0; i < sizeof(Mounts)/sizeof(Mounts[0]) && !Limit; i++) {
+					Limit = AK_CGroup__Read_Hierarchy_Limit(Root, Mounts[i], CGroupPath, (uint32_t)(LineEnd-CGroupPath), ak_atomic_false);
+				}
+			}
+		}
+
+		if(Limit && (!Result || Limit < Result)) Result = Limit;
+		Line = *LineEnd ? LineEnd+1 : LineEnd;
+	}
+
+	return Result;
+}
+
+static uint32_t AK_Thread__Get_Affinity_Count(void) {
+	unsigned long Mask[1024/(8*sizeof(unsigned long))];
+	long Size = syscall(SYS_sched_getaffinity, 0, sizeof(Mask), Mask);
+	uint32_t Result = 0;
+	long i;
+	if(Size <= 0) return 0;
+	for(i = 0; i < Size/(long)sizeof(unsigned long); i++) {
+		unsigned long Bits = Mask[i];
+		while(Bits) {
+			Bits &= Bits-1;
+			Result++;
+		}
+	}
+	return Result;
+}
+
+AKATOMICDEF uint32_t AK_Get_Effective_Processor_Thread_Count_From_Root(const char* Root) {
+	uint32_t Result = AK_Thread__Get_Affinity_Count();
+	uint32_t Limit = AK_CGroup__Get_CPU_Limit(Root);
+	if(!Result) Result = AK_Get_Processor_Thread_Count();
+	if(Limit && Limit < Result) Result = Limit;
+	return Result ? Result : 1;
+}
+
+AKATOMICDEF uint32_t AK_Get_Effective_Processor_Thread_Count(void) {
+	return AK_Get_Effective_Processor_Thread_Count_From_Root("");
+}
+#else
+AKATOMICDEF int8_t AK_Get_CPU_Topology(ak_cpu_topology* Topology) {
+	uint32_t CPUCount = AK_Get_Processor_Thread_Count();
+	ak_cpu_info* CPUs;
+	if(!CPUCount) CPUCount = 1;
+	CPUs = (ak_cpu_info*)AK_ATOMIC_MALLOC(sizeof(ak_cpu_info)*CPUCount);
+	AK_ATOMIC_ASSERT(CPUs);
+	if(!CPUs) return ak_atomic_false;
+	AK_CPU_Topology__Init_Flat(Topology, CPUs, CPUCount);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF uint32_t AK_Get_Effective_Processor_Thread_Count(void) {
+	uint32_t Result = AK_Get_Processor_Thread_Count();
+	return Result ? Result : 1;
+}
+#endif
+
+AKATOMICDEF uint32_t AK_Get_Cache_Line_Size(void) {
+	long Result = 0;
+#if defined(_SC_LEVEL1_DCACHE_LINESIZE)
+	Result = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+#if defined(AK_ATOMIC_OS_LINUX)
+	/*glibc only knows the size on some architectures (it returns 0 on arm64), sysfs always does*/
+	if(Result <= 0) Result = (long)AK_Sys__Read_U32("/sys/devices/system/cpu/cpu0/cache/index0/coherency_line_size", 0);
+#endif
+	return Result > 0 ? (uint32_t)Result : AK_ATOMIC_CACHE_LINE_SIZE;
+}
+
+/*Posix Address waiting*/
+#if defined(AK_ATOMIC_OS_LINUX)
+#include <linux/futex.h>
+
+AKATOMICDEF void AK_Futex_Wait(ak_atomic_u32* Address, uint32_t CompareValue) {
+	syscall(SYS_futex, Address, FUTEX_WAIT_PRIVATE, CompareValue, NULL, NULL, 0);
+}
+
+AKATOMICDEF void AK_Futex_Wake_One(ak_atomic_u32* Address) {
+	syscall(SYS_futex, Address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+AKATOMICDEF void AK_Futex_Wake_All(ak_atomic_u32* Address) {
+	syscall(SYS_futex, Address, FUTEX_WAKE_PRIVATE, 0x7FFFFFFF, NULL, NULL, 0);
+}
+#else
+/*No futex available, so we just back off until the value changes*/
+AKATOMICDEF void AK_Futex_Wait(ak_atomic_u32* Address, uint32_t CompareValue) {
+	uint32_t i;
+	for(i = 0; i < 64; i++) {
+		if(AK_Atomic_Load_U32(Address, AK_ATOMIC_MEMORY_ORDER_RELAXED) != CompareValue) return;
+		AK_ATOMIC__SPIN_PAUSE();
+	}
+	AK_Thread_Yield();
+}
+
+AKATOMICDEF void AK_Futex_Wake_One(ak_atomic_u32* Address) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Address);
+}
+
+AKATOMICDEF void AK_Futex_Wake_All(ak_atomic_u32* Address) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Address);
+}
+#endif
+
+/*Posix Asymmetric fences*/
+#if defined(AK_ATOMIC_OS_LINUX) && defined(SYS_membarrier)
+#define AK_MEMBARRIER__CMD_PRIVATE_EXPEDITED 8
+#define AK_MEMBARRIER__CMD_REGISTER_PRIVATE_EXPEDITED 16
+
+#define AK_MEMBARRIER__STATE_UNKNOWN 0
+#define AK_MEMBARRIER__STATE_AVAILABLE 1
+#define AK_MEMBARRIER__STATE_UNAVAILABLE 2
+
+/*The process has to register before it can use expedited membarriers. Light fences only drop to a
+  compiler barrier once registration succeeded, and from then on every heavy fence is a membarrier,
+  so a light fence that skipped the hardware fence is always paired with a real process wide one*/
+static ak_atomic_u32 AK_Membarrier__State;
+
+static uint32_t AK_Membarrier__Get_State(void) {
+	uint32_t State = AK_Atomic_Load_U32(&AK_Membarrier__State, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(State == AK_MEMBARRIER__STATE_UNKNOWN) {
+		State = syscall(SYS_membarrier, AK_MEMBARRIER__CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0 ? 
+				AK_MEMBARRIER__STATE_AVAILABLE : AK_MEMBARRIER__STATE_UNAVAILABLE;
+		AK_Atomic_Store_U32(&AK_Membarrier__State, State, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	}
+	return State;
+}
+
+AKATOMICDEF void AK_Atomic_Fence_Light(void) {
+	if(AK_Atomic_Load_U32(&AK_Membarrier__State, AK_ATOMIC_MEMORY_ORDER_RELAXED) != AK_MEMBARRIER__STATE_AVAILABLE) {
+		AK_Membarrier__Get_State();
+		AK_Atomic_Fence_Seq_Cst();
+	}
+	AK_ATOMIC__COMPILER_BARRIER();
+}
+
+AKATOMICDEF void AK_Atomic_Fence_Heavy(void) {
+	AK_ATOMIC__COMPILER_BARRIER();
+	if(AK_Membarrier__Get_State() == AK_MEMBARRIER__STATE_AVAILABLE) {
+		syscall(SYS_membarrier, AK_MEMBARRIER__CMD_PRIVATE_EXPEDITED, 0);
+	} else {
+		AK_Atomic_Fence_Seq_Cst();
+	}
+	AK_ATOMIC__COMPILER_BARRIER();
+}
+#else
+AKATOMICDEF void AK_Atomic_Fence_Light(void) {
+	AK_Atomic_Fence_Seq_Cst();
+}
+
+AKATOMICDEF void AK_Atomic_Fence_Heavy(void) {
+	AK_Atomic_Fence_Seq_Cst();
+}
+#endif
+
+/*Posix Virtual memory. The reservation isn't charged against the commit limit, pages are backed 
+  on first touch*/
+#if !defined(AK_ATOMIC_OS_LINUX)
+#include <sys/mman.h>
+#endif
+
+static void* AK_OS__Reserve_Memory(size_t Size) {
+	int Flags = MAP_PRIVATE|MAP_ANONYMOUS;
+	void* Memory;
+#ifdef MAP_NORESERVE
+	Flags |= MAP_NORESERVE;
+#endif
+	Memory = mmap(NULL, Size, PROT_READ|PROT_WRITE, Flags, -1, 0);
+	return Memory == MAP_FAILED ? NULL : Memory;
+}
+
+static int8_t AK_OS__Commit_Memory(void* Memory, size_t Size) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Memory);
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Size);
+	return ak_atomic_true;
+}
+
+static void AK_OS__Release_Memory(void* Memory, size_t Size) {
+	munmap(Memory, Size);
+}
+
+/*Transparent huge pages only back ranges that are aligned to the huge page size*/
+static void AK_OS__Advise_Huge_Pages(void* Memory, size_t Size) {
+#if defined(AK_ATOMIC_OS_LINUX)
+	size_t Begin = ((size_t)Memory + AK_PAGE_HUGE_SIZE-1) & ~((size_t)AK_PAGE_HUGE_SIZE-1);
+	size_t End = ((size_t)Memory + Size) & ~((size_t)AK_PAGE_HUGE_SIZE-1);
+	if(Begin < End) madvise((void*)Begin, End-Begin, MADV_HUGEPAGE);
+#else
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Memory);
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Size);
+#endif
+}
+
+/*Over reserves by a huge page and trims the mapping so it starts on a huge page boundary. Size is a
+  multiple of AK_PAGE_HUGE_SIZE. MAP_HUGETLB fails right away when the pool is too small, as long as
+  MAP_NORESERVE isn't passed*/
+static void* AK_OS__Allocate_Huge_Memory(size_t Size) {
+	uint8_t* Memory;
+	size_t Head;
+#if defined(AK_ATOMIC_OS_LINUX) && defined(AK_ATOMIC_HUGETLB)
+	Memory = (uint8_t*)mmap(NULL, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if(Memory != (uint8_t*)MAP_FAILED) return Memory;
+#endif
+
+	Memory = (uint8_t*)mmap(NULL, Size+AK_PAGE_HUGE_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if(Memory == (uint8_t*)MAP_FAILED) return NULL;
+
+	Head = (((size_t)Memory + AK_PAGE_HUGE_SIZE-1) & ~((size_t)AK_PAGE_HUGE_SIZE-1)) - (size_t)Memory;
+	/*Head is always less than a huge page, so there is always a tail left to trim*/
+	if(Head) munmap(Memory, Head);
+	munmap(Memory+Head+Size, AK_PAGE_HUGE_SIZE-Head);
+	Memory += Head;
+
+	AK_OS__Advise_Huge_Pages(Memory, Size);
+	return Memory;
+}
+
+static void AK_OS__Prefault_Memory(void* Memory, size_t Size) {
+	volatile uint8_t* At = (volatile uint8_t*)Memory;
+	size_t Offset, PageSize;
+#if defined(AK_ATOMIC_OS_LINUX)
+	if(madvise(Memory, Size, MADV_POPULATE_WRITE) == 0) return;
+#endif
+	PageSize = (size_t)sysconf(_SC_PAGESIZE);
+	for(Offset = 0; Offset < Size; Offset += PageSize) At[Offset] = At[Offset];
+}
+
+/*Posix Numa memory*/
+#if defined(AK_ATOMIC_OS_LINUX)
+#define AK_OS__MPOL_PREFERRED 1
+#define AK_OS__MAX_NODE_COUNT 64
+
+/*The node is only a preference, the kernel falls back to other nodes when it runs out of memory. 
+  If mbind is not supported (no numa kernel or a seccomp filter) the pages are placed on first touch, 
+  and since the memory is first touched by the creating thread the placement is just not guaranteed*/
+static void* AK_OS__Allocate_Node_Memory(size_t Size, uint32_t NodeID) {
+	void* Memory = mmap(NULL, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if(Memory == MAP_FAILED) return NULL;
+
+	if(NodeID < AK_OS__MAX_NODE_COUNT) {
+		unsigned long NodeMask[AK_OS__MAX_NODE_COUNT/(8*sizeof(unsigned long))];
+		uint32_t BitsPerLong = 8*sizeof(unsigned long);
+		AK_ATOMIC_MEMORY_CLEAR(NodeMask, sizeof(NodeMask));
+		NodeMask[NodeID / BitsPerLong] = 1ul << (NodeID % BitsPerLong);
+		syscall(SYS_mbind, Memory, Size, AK_OS__MPOL_PREFERRED, NodeMask, AK_OS__MAX_NODE_COUNT+1, 0);
+	}
+
+	AK_OS__Advise_Huge_Pages(Memory, Size);
+	return Memory;
+}
+
+static void AK_OS__Free_Node_Memory(void* Memory, size_t Size) {
+	munmap(Memory, Size);
+}
+#else
+static void* AK_OS__Allocate_Node_Memory(size_t Size, uint32_t NodeID) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(NodeID);
+	return AK_ATOMIC_MALLOC(Size);
+}
+
+static void AK_OS__Free_Node_Memory(void* Memory, size_t Size) {
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Size);
+	AK_ATOMIC_FREE(Memory);
+}
+#endif
+
 /*Posix High resolution performance counters & timers*/
 AKATOMICDEF void AK_Sleep(uint32_t Milliseconds) {
     struct timespec Time;
@@ -10064,14 +12002,4654 @@ AKATOMICDEF uint64_t AK_Query_Performance_Counter() {
     return Result;
 }
 
+/*Strict c modes (e.g. -std=c11) don't define the monotonic clocks, the counter then comes from 
+  gettimeofday which only has microseconds*/
 AKATOMICDEF uint64_t AK_Query_Performance_Frequency() {
+#ifdef AK__MONOTONIC_TIME
     return AK__NS_PER_SECOND;
+#else
+    return AK__US_PER_SECOND;
+#endif
 }
 
 #else
 #error "Not Implemented!"
 #endif
 
+/*Aligned allocation. The pointer returned by AK_ATOMIC_MALLOC is stored right in front of the 
+  aligned block*/
+AKATOMICDEF void* AK_Atomic_Aligned_Allocate(size_t Size, size_t Alignment) {
+	void* Memory;
+	void** Result;
+	size_t Extra;
+
+	AK_ATOMIC_ASSERT(Alignment && !(Alignment & (Alignment-1)));
+	if(Alignment < sizeof(void*)) Alignment = sizeof(void*);
+	Extra = Alignment-1+sizeof(void*);
+	if(Size > (size_t)-1-Extra) return NULL;
+
+	Memory = AK_ATOMIC_MALLOC(Size+Extra);
+	if(!Memory) return NULL;
+	Result = (void**)(((size_t)Memory+Extra) & ~(Alignment-1));
+	Result[-1] = Memory;
+	return Result;
+}
+
+AKATOMICDEF void AK_Atomic_Aligned_Free(void* Memory) {
+	if(Memory) AK_ATOMIC_FREE(((void**)Memory)[-1]);
+}
+
+/*Page provider*/
+AKATOMICDEF void* AK_Page_Allocate(size_t Size) {
+	Size = (Size+AK_PAGE_HUGE_SIZE-1) & ~((size_t)AK_PAGE_HUGE_SIZE-1);
+	if(!Size) return NULL;
+	return AK_OS__Allocate_Huge_Memory(Size);
+}
+
+AKATOMICDEF void AK_Page_Free(void* Memory, size_t Size) {
+	if(!Memory) return;
+	Size = (Size+AK_PAGE_HUGE_SIZE-1) & ~((size_t)AK_PAGE_HUGE_SIZE-1);
+	AK_OS__Release_Memory(Memory, Size);
+}
+
+AKATOMICDEF void AK_Page_Prefault(void* Memory, size_t Size) {
+	if(Memory && Size) AK_OS__Prefault_Memory(Memory, Size);
+}
+
+static void* AK_Atomic__Large_Allocate(size_t Size) {
+	if(Size < AK_ATOMIC_LARGE_THRESHOLD) return AK_ATOMIC_MALLOC(Size);
+	return AK_ATOMIC_LARGE_MALLOC(Size);
+}
+
+static void AK_Atomic__Large_Free(void* Memory, size_t Size) {
+	if(Size < AK_ATOMIC_LARGE_THRESHOLD) AK_ATOMIC_FREE(Memory);
+	else AK_ATOMIC_LARGE_FREE(Memory, Size);
+}
+
+/*Job system*/
+typedef struct {
+	ak_job_callback_func* Callback;
+	void* 				  UserData;
+	ak_atomic_u32* 		  Counter;
+} ak_job_entry;
+
+/*Chase-Lev work stealing deque. The owning worker pushes and pops from the bottom while any
+  other thread steals from the top. Top and bottom live on separate cache lines since the owner
+  writes bottom constantly while thieves hammer top*/
+typedef struct {
+	ak_atomic_u32 Top;
+	uint8_t 	  Padding0[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u32)];
+	ak_atomic_u32 Bottom;
+	uint8_t 	  Padding1[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u32)];
+	ak_job_entry* Entries;
+	uint32_t 	  Mask;
+	int32_t 	  NodeID;
+} ak_job_deque;
+
+/*Bounded multi-producer/multi-consumer queue (Vyukov) used for jobs submitted from threads that
+  are not workers of the job system*/
+typedef struct {
+	ak_atomic_u32 Sequence;
+	uint32_t 	  Padding;
+	ak_job_entry  Entry;
+} ak_job_queue_cell;
+
+typedef struct {
+	ak_atomic_u32 	   EnqueueIndex;
+	uint8_t 		   Padding0[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u32)];
+	ak_atomic_u32 	   DequeueIndex;
+	uint8_t 		   Padding1[AK_ATOMIC_CACHE_LINE_SIZE-sizeof(ak_atomic_u32)];
+	ak_job_queue_cell* Cells;
+	uint32_t 		   Mask;
+	int32_t 		   NodeID;
+} ak_job_queue;
+
+/*Workers are grouped by numa node and every node has its own queue, so submissions and steals stay
+  on the node whenever possible. Pools that aren't numa aware have a single node*/
+typedef struct {
+	ak_job_queue Queue;
+	uint32_t 	 FirstWorker;
+	uint32_t 	 WorkerCount;
+	uint64_t 	 AffinityMask;
+} ak_job_node;
+
+typedef struct {
+	ak_job_deque   Deque;
+	ak_job_system* JobSystem;
+	ak_thread* 	   Thread;
+	uint32_t 	   Index;
+	uint32_t 	   RandomState;
+	uint32_t 	   NodeIndex;
+	uint32_t 	   Padding;
+} ak_job_worker;
+
+struct ak_job_system {
+	ak_job_node* 	Nodes;
+	uint32_t 		NodeCount;
+	ak_atomic_u32 	NextNode;
+	ak_lw_semaphore Semaphore;
+	ak_atomic_u32 	IsRunning;
+	uint32_t 		WorkerCount;
+	ak_atomic_u32 	WaiterCount;
+	uint32_t 		Padding;
+	ak_job_worker* 	Workers;
+	ak_tls 			WorkerTLS;
+};
+
+typedef enum {
+	AK_JOB_STEAL_EMPTY,
+	AK_JOB_STEAL_ABORT,
+	AK_JOB_STEAL_SUCCESS
+} ak_job_steal_result;
+
+static uint32_t AK_Job_System__Round_Capacity(uint32_t Capacity) {
+	uint32_t Result = 1;
+	while(Result < Capacity) Result <<= 1;
+	return Result;
+}
+
+static int8_t AK_Job_Deque__Push(ak_job_deque* Deque, const ak_job_entry* Entry) {
+	uint32_t Bottom = AK_Atomic_Load_U32(&Deque->Bottom, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t Top = AK_Atomic_Load_U32(&Deque->Top, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(Bottom-Top > Deque->Mask) return ak_atomic_false;
+
+	Deque->Entries[Bottom & Deque->Mask] = *Entry;
+	AK_Atomic_Store_U32(&Deque->Bottom, Bottom+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	return ak_atomic_true;
+}
+
+static int8_t AK_Job_Deque__Pop(ak_job_deque* Deque, ak_job_entry* Entry) {
+	int8_t Result = ak_atomic_false;
+	uint32_t Bottom = AK_Atomic_Load_U32(&Deque->Bottom, AK_ATOMIC_MEMORY_ORDER_RELAXED)-1;
+	uint32_t Top;
+	AK_Atomic_Store_U32(&Deque->Bottom, Bottom, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	/*The bottom store must be visible before we read top, otherwise a thief and the owner can both
+	  take the last entry*/
+	{ AK_Atomic_Fence_Seq_Cst(); }
+	Top = AK_Atomic_Load_U32(&Deque->Top, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	if((int32_t)(Bottom-Top) >= 0) {
+		*Entry = Deque->Entries[Bottom & Deque->Mask];
+		Result = ak_atomic_true;
+		if(Top == Bottom) {
+			/*Last entry, race any thieves for it*/
+			if(!AK_Atomic_Compare_Exchange_Strong_U32(&Deque->Top, &Top, Top+1, AK_ATOMIC_MEMORY_ORDER_SEQ_CST)) {
+				Result = ak_atomic_false;
+			}
+			AK_Atomic_Store_U32(&Deque->Bottom, Bottom+1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+	} else {
+		AK_Atomic_Store_U32(&Deque->Bottom, Bottom+1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+
+	return Result;
+}
+
+static ak_job_steal_result AK_Job_Deque__Steal(ak_job_deque* Deque, ak_job_entry* Entry) {
+	uint32_t Top = AK_Atomic_Load_U32(&Deque->Top, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	uint32_t Bottom;
+	{ AK_Atomic_Fence_Seq_Cst(); }
+	Bottom = AK_Atomic_Load_U32(&Deque->Bottom, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+
+	if((int32_t)(Bottom-Top) <= 0) return AK_JOB_STEAL_EMPTY;
+
+	/*Entry can be overwritten by the owner if top is stale, but then the CAS fails and we discard it*/
+	*Entry = Deque->Entries[Top & Deque->Mask];
+	if(!AK_Atomic_Compare_Exchange_Strong_U32(&Deque->Top, &Top, Top+1, AK_ATOMIC_MEMORY_ORDER_SEQ_CST)) {
+		return AK_JOB_STEAL_ABORT;
+	}
+
+	return AK_JOB_STEAL_SUCCESS;
+}
+
+/*A node id of -1 uses the large buffer allocator, anything else places the memory on that numa 
+  node. Both back big rings with huge pages*/
+static void* AK_Job__Allocate(size_t Size, int32_t NodeID) {
+	if(NodeID < 0) return AK_Atomic__Large_Allocate(Size);
+	return AK_OS__Allocate_Node_Memory(Size, (uint32_t)NodeID);
+}
+
+static void AK_Job__Free(void* Memory, size_t Size, int32_t NodeID) {
+	if(NodeID < 0) AK_Atomic__Large_Free(Memory, Size);
+	else AK_OS__Free_Node_Memory(Memory, Size);
+}
+
+static int8_t AK_Job_Queue__Create(ak_job_queue* Queue, uint32_t Capacity, int32_t NodeID) {
+	uint32_t i;
+	Queue->Cells = (ak_job_queue_cell*)AK_Job__Allocate(sizeof(ak_job_queue_cell)*Capacity, NodeID);
+	AK_ATOMIC_ASSERT(Queue->Cells);
+	if(!Queue->Cells) return ak_atomic_false;
+
+	Queue->Mask = Capacity-1;
+	Queue->NodeID = NodeID;
+	for(i = 0; i < Capacity; i++) {
+		AK_Atomic_Store_U32(&Queue->Cells[i].Sequence, i, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	AK_Atomic_Store_U32(&Queue->EnqueueIndex, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Queue->DequeueIndex, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+static void AK_Job_Queue__Delete(ak_job_queue* Queue) {
+	if(Queue->Cells) {
+		AK_Job__Free(Queue->Cells, sizeof(ak_job_queue_cell)*(Queue->Mask+1), Queue->NodeID);
+		Queue->Cells = NULL;
+	}
+}
+
+static int8_t AK_Job_Deque__Create(ak_job_deque* Deque, uint32_t Capacity, int32_t NodeID) {
+	Deque->Entries = (ak_job_entry*)AK_Job__Allocate(sizeof(ak_job_entry)*Capacity, NodeID);
+	AK_ATOMIC_ASSERT(Deque->Entries);
+	if(!Deque->Entries) return ak_atomic_false;
+	Deque->Mask = Capacity-1;
+	Deque->NodeID = NodeID;
+	AK_Atomic_Store_U32(&Deque->Top, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Deque->Bottom, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+static void AK_Job_Deque__Delete(ak_job_deque* Deque) {
+	if(Deque->Entries) {
+		AK_Job__Free(Deque->Entries, sizeof(ak_job_entry)*(Deque->Mask+1), Deque->NodeID);
+		Deque->Entries = NULL;
+	}
+}
+
+static int8_t AK_Job_Queue__Enqueue(ak_job_queue* Queue, const ak_job_entry* Entry) {
+	ak_job_queue_cell* Cell;
+	uint32_t Index = AK_Atomic_Load_U32(&Queue->EnqueueIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(;;) {
+		uint32_t Sequence;
+		int32_t Difference;
+		Cell = Queue->Cells + (Index & Queue->Mask);
+		Sequence = AK_Atomic_Load_U32(&Cell->Sequence, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		Difference = (int32_t)(Sequence-Index);
+		if(Difference == 0) {
+			if(AK_Atomic_Compare_Exchange_Weak_U32(&Queue->EnqueueIndex, &Index, Index+1, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+				break;
+			}
+		} else if(Difference < 0) {
+			return ak_atomic_false;
+		} else {
+			Index = AK_Atomic_Load_U32(&Queue->EnqueueIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+	}
+
+	Cell->Entry = *Entry;
+	AK_Atomic_Store_U32(&Cell->Sequence, Index+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	return ak_atomic_true;
+}
+
+static int8_t AK_Job_Queue__Dequeue(ak_job_queue* Queue, ak_job_entry* Entry) {
+	ak_job_queue_cell* Cell;
+	uint32_t Index = AK_Atomic_Load_U32(&Queue->DequeueIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(;;) {
+		uint32_t Sequence;
+		int32_t Difference;
+		Cell = Queue->Cells + (Index & Queue->Mask);
+		Sequence = AK_Atomic_Load_U32(&Cell->Sequence, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		Difference = (int32_t)(Sequence-(Index+1));
+		if(Difference == 0) {
+			if(AK_Atomic_Compare_Exchange_Weak_U32(&Queue->DequeueIndex, &Index, Index+1, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+				break;
+			}
+		} else if(Difference < 0) {
+			return ak_atomic_false;
+		} else {
+			Index = AK_Atomic_Load_U32(&Queue->DequeueIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+	}
+
+	*Entry = Cell->Entry;
+	AK_Atomic_Store_U32(&Cell->Sequence, Index+Queue->Mask+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	return ak_atomic_true;
+}
+
+static uint32_t AK_Job_Worker__Random(ak_job_worker* Worker) {
+	/*Xorshift32*/
+	uint32_t X = Worker->RandomState;
+	X ^= X << 13;
+	X ^= X >> 17;
+	X ^= X << 5;
+	Worker->RandomState = X;
+	return X;
+}
+
+/*Steals from a random worker of the node, retrying as long as some steal lost a race*/
+static int8_t AK_Job_Node__Steal(ak_job_node* Node, ak_job_worker* Workers, ak_job_worker* Worker, uint32_t StartIndex, ak_job_entry* Entry) {
+	uint32_t i;
+	int8_t ShouldRetry;
+	if(!Node->WorkerCount) return ak_atomic_false;
+
+	do {
+		ShouldRetry = ak_atomic_false;
+		for(i = 0; i < Node->WorkerCount; i++) {
+			ak_job_worker* Victim = Workers + Node->FirstWorker + ((StartIndex+i) % Node->WorkerCount);
+			if(Victim != Worker) {
+				ak_job_steal_result StealResult = AK_Job_Deque__Steal(&Victim->Deque, Entry);
+				if(StealResult == AK_JOB_STEAL_SUCCESS) return ak_atomic_true;
+				if(StealResult == AK_JOB_STEAL_ABORT) ShouldRetry = ak_atomic_true;
+			}
+		}
+	} while(ShouldRetry);
+
+	return ak_atomic_false;
+}
+
+/*Worker is NULL when called from a thread that does not belong to the job system. The local deque
+  is checked first for cache locality, then the node's queue, then we steal from a random victim on
+  the same node. Only once the home node is dry do we move on to the other nodes*/
+static int8_t AK_Job__Get_Entry(ak_job_node* Nodes, uint32_t NodeCount, ak_job_worker* Workers, ak_job_worker* Worker, ak_job_entry* Entry) {
+	uint32_t i, StartIndex, HomeNode = Worker ? Worker->NodeIndex : 0;
+
+	if(Worker && AK_Job_Deque__Pop(&Worker->Deque, Entry)) return ak_atomic_true;
+
+	StartIndex = Worker ? AK_Job_Worker__Random(Worker) : (uint32_t)AK_Query_Performance_Counter();
+	for(i = 0; i < NodeCount; i++) {
+		ak_job_node* Node = Nodes + ((HomeNode+i) % NodeCount);
+		if(AK_Job_Queue__Dequeue(&Node->Queue, Entry)) return ak_atomic_true;
+		if(AK_Job_Node__Steal(Node, Workers, Worker, StartIndex, Entry)) return ak_atomic_true;
+	}
+
+	return ak_atomic_false;
+}
+
+/*Outside threads that run out of jobs to help with park on the counter itself instead of spinning. 
+  Both the waiter count and the counter are accessed sequentially consistent, so either the waiter 
+  sees the counter reach zero or the thread that dropped it to zero sees the waiter and wakes it*/
+static void AK_Job__Park(ak_atomic_u32* WaiterCount, ak_atomic_u32* Counter) {
+	uint32_t Value;
+	AK_Atomic_Increment_U32(WaiterCount, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+	Value = AK_Atomic_Load_U32(Counter, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+	if(Value) AK_Futex_Wait(Counter, Value);
+	AK_Atomic_Decrement_U32(WaiterCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+/*Returns true when the counter reached zero*/
+static int8_t AK_Job__Decrement_Counter(ak_atomic_u32* WaiterCount, ak_atomic_u32* Counter) {
+	if(AK_Atomic_Decrement_U32(Counter, AK_ATOMIC_MEMORY_ORDER_SEQ_CST) != 0) return ak_atomic_false;
+	if(AK_Atomic_Load_U32(WaiterCount, AK_ATOMIC_MEMORY_ORDER_SEQ_CST)) AK_Futex_Wake_All(Counter);
+	return ak_atomic_true;
+}
+
+static int8_t AK_Job_System__Get_Job(ak_job_system* JobSystem, ak_job_worker* Worker, ak_job_entry* Entry) {
+	return AK_Job__Get_Entry(JobSystem->Nodes, JobSystem->NodeCount, JobSystem->Workers, Worker, Entry);
+}
+
+static void AK_Job_System__Execute(ak_job_system* JobSystem, const ak_job_entry* Entry) {
+	Entry->Callback(JobSystem, Entry->UserData);
+	if(Entry->Counter) {
+		AK_Job__Decrement_Counter(&JobSystem->WaiterCount, Entry->Counter);
+	}
+}
+
+/*Returns true if the entry was queued, false if there was no room and the caller should run it*/
+static int8_t AK_Job_System__Push(ak_job_system* JobSystem, ak_job_worker* Worker, const ak_job_entry* Entry) {
+	uint32_t NodeIndex = 0;
+	if(Worker) {
+		if(AK_Job_Deque__Push(&Worker->Deque, Entry)) return ak_atomic_true;
+		NodeIndex = Worker->NodeIndex;
+	} else if(JobSystem->NodeCount > 1) {
+		/*Outside threads spread their jobs over the nodes*/
+		NodeIndex = AK_Atomic_Increment_U32(&JobSystem->NextNode, AK_ATOMIC_MEMORY_ORDER_RELAXED) % JobSystem->NodeCount;
+	}
+	return AK_Job_Queue__Enqueue(&JobSystem->Nodes[NodeIndex].Queue, Entry);
+}
+
+/*The semaphore count is always at least the number of queued jobs. Every queued job increments it
+  once and workers decrement it once per attempt to grab a job, so a worker can only go to sleep
+  when no job is left that it could have grabbed*/
+static AK_THREAD_CALLBACK_DEFINE(AK_Job_System__Worker_Proc) {
+	ak_job_worker* Worker = (ak_job_worker*)UserData;
+	ak_job_system* JobSystem = Worker->JobSystem;
+	ak_job_entry Entry;
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Thread);
+
+	AK_TLS_Set(&JobSystem->WorkerTLS, Worker);
+	for(;;) {
+		AK_LW_Semaphore_Decrement(&JobSystem->Semaphore);
+		if(!AK_Atomic_Load_U32(&JobSystem->IsRunning, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) break;
+		if(AK_Job_System__Get_Job(JobSystem, Worker, &Entry)) {
+			AK_Job_System__Execute(JobSystem, &Entry);
+		}
+	}
+
+	return 0;
+}
+
+AKATOMICDEF ak_job_system* AK_Job_System_Create(uint32_t ThreadCount, uint32_t QueueCapacity) {
+	ak_job_system_create_info CreateInfo;
+	AK_ATOMIC_MEMORY_CLEAR(&CreateInfo, sizeof(ak_job_system_create_info));
+	CreateInfo.ThreadCount = ThreadCount;
+	CreateInfo.QueueCapacity = QueueCapacity;
+	return AK_Job_System_Create_Ex(&CreateInfo);
+}
+
+/*Groups the topology's processors into the nodes that actually have processors, hands out workers 
+  to nodes proportionally to their processor count and builds each node's affinity mask*/
+static uint32_t AK_Job_System__Layout_Nodes(ak_job_node* Nodes, int32_t* NodeIDs, const ak_cpu_topology* Topology, uint32_t ThreadCount) {
+	uint32_t i, j, NodeCount = 0, AssignedCount = 0;
+
+	for(i = 0; i < Topology->CPUCount; i++) {
+		const ak_cpu_info* CPU = Topology->CPUs + i;
+		for(j = 0; j < NodeCount; j++) {
+			if(NodeIDs[j] == (int32_t)CPU->NodeIndex) break;
+		}
+		if(j == NodeCount) {
+			NodeIDs[NodeCount++] = (int32_t)CPU->NodeIndex;
+		}
+		/*FirstWorker temporarily counts the node's processors*/
+		Nodes[j].FirstWorker++;
+		if(CPU->ID < 64) Nodes[j].AffinityMask |= (uint64_t)1 << CPU->ID;
+	}
+
+	for(i = 0; i < NodeCount; i++) {
+		Nodes[i].WorkerCount = (uint32_t)(((uint64_t)ThreadCount*Nodes[i].FirstWorker) / Topology->CPUCount);
+		AssignedCount += Nodes[i].WorkerCount;
+	}
+
+	for(i = 0; AssignedCount < ThreadCount; i = (i+1) % NodeCount) {
+		Nodes[i].WorkerCount++;
+		AssignedCount++;
+	}
+
+	AssignedCount = 0;
+	for(i = 0; i < NodeCount; i++) {
+		Nodes[i].FirstWorker = AssignedCount;
+		AssignedCount += Nodes[i].WorkerCount;
+	}
+
+	return NodeCount;
+}
+
+/*Frees everything besides the semaphore, the tls slot and the threads. Queues and deques are only 
+  visited once the node and worker counts are set, which happens after their arrays were cleared*/
+static void AK_Job_System__Release(ak_job_system* JobSystem) {
+	uint32_t i;
+	if(JobSystem->Nodes) {
+		for(i = 0; i < JobSystem->NodeCount; i++) AK_Job_Queue__Delete(&JobSystem->Nodes[i].Queue);
+		AK_ATOMIC_FREE(JobSystem->Nodes);
+	}
+	if(JobSystem->Workers) {
+		for(i = 0; i < JobSystem->WorkerCount; i++) AK_Job_Deque__Delete(&JobSystem->Workers[i].Deque);
+		AK_ATOMIC_FREE(JobSystem->Workers);
+	}
+	AK_ATOMIC_FREE(JobSystem);
+}
+
+AKATOMICDEF ak_job_system* AK_Job_System_Create_Ex(const ak_job_system_create_info* CreateInfo) {
+	ak_job_system* JobSystem;
+	ak_cpu_topology SystemTopology;
+	const ak_cpu_topology* Topology = NULL;
+	uint32_t i, j, NodeCount = 1, MaxNodeCount = 1;
+	uint32_t ThreadCount = CreateInfo->ThreadCount;
+	uint32_t QueueCapacity = CreateInfo->QueueCapacity;
+	int8_t IsNUMA = (CreateInfo->Flags & AK_JOB_SYSTEM_FLAG_NUMA) != 0;
+	int32_t* NodeIDs;
+	int8_t IsValid;
+
+	if(!ThreadCount) ThreadCount = AK_Get_Effective_Processor_Thread_Count();
+	if(!ThreadCount) ThreadCount = 1;
+	if(!QueueCapacity) QueueCapacity = AK_JOB_SYSTEM_DEFAULT_QUEUE_CAPACITY;
+	QueueCapacity = AK_Job_System__Round_Capacity(QueueCapacity);
+
+	AK_ATOMIC_MEMORY_CLEAR(&SystemTopology, sizeof(ak_cpu_topology));
+	if(IsNUMA) {
+		Topology = CreateInfo->Topology;
+		if(!Topology && AK_Get_CPU_Topology(&SystemTopology)) Topology = &SystemTopology;
+		if(Topology && Topology->CPUCount) MaxNodeCount = Topology->CPUCount;
+		else IsNUMA = ak_atomic_false;
+	}
+
+	JobSystem = (ak_job_system*)AK_ATOMIC_MALLOC(sizeof(ak_job_system));
+	AK_ATOMIC_ASSERT(JobSystem);
+	if(!JobSystem) {
+		AK_Free_CPU_Topology(&SystemTopology);
+		return NULL;
+	}
+	AK_ATOMIC_MEMORY_CLEAR(JobSystem, sizeof(ak_job_system));
+
+	JobSystem->Workers = (ak_job_worker*)AK_ATOMIC_MALLOC(sizeof(ak_job_worker)*ThreadCount);
+	JobSystem->Nodes = (ak_job_node*)AK_ATOMIC_MALLOC(sizeof(ak_job_node)*MaxNodeCount);
+	NodeIDs = (int32_t*)AK_ATOMIC_MALLOC(sizeof(int32_t)*MaxNodeCount);
+	IsValid = JobSystem->Workers && JobSystem->Nodes && NodeIDs;
+
+	if(IsValid) {
+		AK_ATOMIC_MEMORY_CLEAR(JobSystem->Workers, sizeof(ak_job_worker)*ThreadCount);
+		AK_ATOMIC_MEMORY_CLEAR(JobSystem->Nodes, sizeof(ak_job_node)*MaxNodeCount);
+		if(IsNUMA) {
+			NodeCount = AK_Job_System__Layout_Nodes(JobSystem->Nodes, NodeIDs, Topology, ThreadCount);
+		} else {
+			JobSystem->Nodes[0].WorkerCount = ThreadCount;
+			NodeIDs[0] = -1;
+		}
+		JobSystem->NodeCount = NodeCount;
+		JobSystem->WorkerCount = ThreadCount;
+
+		/*Queues and deques are placed on the memory of the node whose workers own them*/
+		for(i = 0; i < NodeCount && IsValid; i++) {
+			ak_job_node* Node = JobSystem->Nodes + i;
+			IsValid = AK_Job_Queue__Create(&Node->Queue, QueueCapacity, NodeIDs[i]);
+			for(j = 0; j < Node->WorkerCount && IsValid; j++) {
+				ak_job_worker* Worker = JobSystem->Workers + Node->FirstWorker + j;
+				Worker->JobSystem = JobSystem;
+				Worker->Index = Node->FirstWorker + j;
+				Worker->NodeIndex = i;
+				Worker->RandomState = 0x9E3779B9u*(Worker->Index+1);
+				IsValid = AK_Job_Deque__Create(&Worker->Deque, QueueCapacity, NodeIDs[i]);
+			}
+		}
+	}
+
+	if(NodeIDs) AK_ATOMIC_FREE(NodeIDs);
+	AK_Free_CPU_Topology(&SystemTopology);
+
+	if(!IsValid) {
+		AK_ATOMIC_ASSERT(!"Failed to allocate job system");
+		AK_Job_System__Release(JobSystem);
+		return NULL;
+	}
+
+	if(!AK_LW_Semaphore_Create(&JobSystem->Semaphore, 0)) {
+		AK_ATOMIC_ASSERT(!"Failed to create the job system semaphore");
+		AK_Job_System__Release(JobSystem);
+		return NULL;
+	}
+
+	if(!AK_TLS_Create(&JobSystem->WorkerTLS)) {
+		AK_ATOMIC_ASSERT(!"Failed to create the job system tls");
+		AK_LW_Semaphore_Delete(&JobSystem->Semaphore);
+		AK_Job_System__Release(JobSystem);
+		return NULL;
+	}
+
+	AK_Atomic_Store_U32(&JobSystem->IsRunning, ak_atomic_true, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	/*Workers can steal from each other immediately so every deque must exist before any thread starts*/
+	for(i = 0; i < ThreadCount; i++) {
+		ak_job_worker* Worker = JobSystem->Workers + i;
+		ak_thread_create_info ThreadInfo;
+		AK_ATOMIC_MEMORY_CLEAR(&ThreadInfo, sizeof(ak_thread_create_info));
+		if(IsNUMA) ThreadInfo.AffinityMask = JobSystem->Nodes[Worker->NodeIndex].AffinityMask;
+		Worker->Thread = AK_Thread_Create_Ex(AK_Job_System__Worker_Proc, Worker, &ThreadInfo);
+		if(!Worker->Thread) {
+			/*Delete only joins the threads that were actually started*/
+			AK_ATOMIC_ASSERT(!"Failed to create job system thread");
+			AK_Job_System_Delete(JobSystem);
+			return NULL;
+		}
+	}
+
+	return JobSystem;
+}
+
+AKATOMICDEF void AK_Job_System_Delete(ak_job_system* JobSystem) {
+	uint32_t i;
+	AK_ATOMIC_ASSERT(JobSystem);
+	if(!JobSystem) return;
+
+	AK_Atomic_Store_U32(&JobSystem->IsRunning, ak_atomic_false, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	AK_LW_Semaphore_Add(&JobSystem->Semaphore, (int32_t)JobSystem->WorkerCount);
+
+	for(i = 0; i < JobSystem->WorkerCount; i++) {
+		ak_job_worker* Worker = JobSystem->Workers + i;
+		if(Worker->Thread) AK_Thread_Delete(Worker->Thread);
+	}
+
+	AK_TLS_Delete(&JobSystem->WorkerTLS);
+	AK_LW_Semaphore_Delete(&JobSystem->Semaphore);
+	AK_Job_System__Release(JobSystem);
+}
+
+AKATOMICDEF void AK_Job_System_Submit(ak_job_system* JobSystem, ak_job_callback_func* Callback, void* UserData, ak_atomic_u32* Counter) {
+	ak_job_worker* Worker = (ak_job_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+	ak_job_entry Entry;
+	Entry.Callback = Callback;
+	Entry.UserData = UserData;
+	Entry.Counter = Counter;
+
+	if(Counter) AK_Atomic_Increment_U32(Counter, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(AK_Job_System__Push(JobSystem, Worker, &Entry)) {
+		AK_LW_Semaphore_Increment(&JobSystem->Semaphore);
+	} else {
+		AK_Job_System__Execute(JobSystem, &Entry);
+	}
+}
+
+AKATOMICDEF void AK_Job_System_Submit_Batch(ak_job_system* JobSystem, const ak_job* Jobs, uint32_t JobCount, ak_atomic_u32* Counter) {
+	ak_job_worker* Worker = (ak_job_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+	uint32_t i, QueuedCount = 0;
+	ak_job_entry Entry;
+
+	if(!JobCount) return;
+	if(Counter) AK_Atomic_Fetch_Add_U32(Counter, JobCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	Entry.Counter = Counter;
+	for(i = 0; i < JobCount; i++) {
+		Entry.Callback = Jobs[i].Callback;
+		Entry.UserData = Jobs[i].UserData;
+		if(AK_Job_System__Push(JobSystem, Worker, &Entry)) {
+			QueuedCount++;
+		} else {
+			/*Queues are full. Wake everyone up for what was queued so far and run the rest inline*/
+			if(QueuedCount) {
+				AK_LW_Semaphore_Add(&JobSystem->Semaphore, (int32_t)QueuedCount);
+				QueuedCount = 0;
+			}
+			AK_Job_System__Execute(JobSystem, &Entry);
+		}
+	}
+
+	if(QueuedCount) AK_LW_Semaphore_Add(&JobSystem->Semaphore, (int32_t)QueuedCount);
+}
+
+/*Waiting threads help execute jobs instead of blocking so a worker waiting on its own children
+  can never deadlock the pool. Once there is nothing left to help with, workers yield while outside
+  threads park until the counter reaches zero*/
+AKATOMICDEF void AK_Job_System_Wait(ak_job_system* JobSystem, ak_atomic_u32* Counter) {
+	ak_job_worker* Worker = (ak_job_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+	uint32_t IdleCount = 0;
+	ak_job_entry Entry;
+
+	while(AK_Atomic_Load_U32(Counter, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != 0) {
+		if(AK_Job_System__Get_Job(JobSystem, Worker, &Entry)) {
+			AK_Job_System__Execute(JobSystem, &Entry);
+			IdleCount = 0;
+		} else if(++IdleCount < 64) {
+			AK_ATOMIC__SPIN_PAUSE();
+		} else if(Worker) {
+			AK_Thread_Yield();
+		} else {
+			AK_Job__Park(&JobSystem->WaiterCount, Counter);
+			IdleCount = 0;
+		}
+	}
+}
+
+AKATOMICDEF uint32_t AK_Job_System_Get_Thread_Count(ak_job_system* JobSystem) {
+	return JobSystem->WorkerCount;
+}
+
+/*Parallel for*/
+typedef struct ak_parallel_for ak_parallel_for;
+
+typedef struct {
+	ak_parallel_for* ParallelFor;
+	uint64_t 		 Begin;
+	uint64_t 		 End;
+	ak_atomic_u32 	 IsUsed;
+	uint32_t 		 Padding;
+} ak_parallel_for_range;
+
+/*Split ranges are handed out of a fixed array so splitting never allocates. A range is given back
+  as soon as its job starts running, so the array only has to cover ranges that are still queued. 
+  While every range is in use the work just isn't split any further*/
+struct ak_parallel_for {
+	ak_job_system* 				   JobSystem;
+	ak_parallel_for_callback_func* Callback;
+	void* 						   UserData;
+	uint64_t 					   Grain;
+	ak_atomic_u32 				   NextRange;
+	ak_atomic_u32 				   Counter;
+	ak_parallel_for_range 		   Ranges[AK_PARALLEL_FOR_MAX_PENDING_RANGES];
+};
+
+/*A thief is only around when our queued work has been taken. Workers check their own deque, 
+  outside threads check the node queues they push into*/
+static int8_t AK_Parallel_For__Should_Split(ak_job_system* JobSystem, ak_job_worker* Worker) {
+	uint32_t Top, Bottom;
+	if(Worker) {
+		Bottom = AK_Atomic_Load_U32(&Worker->Deque.Bottom, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Top = AK_Atomic_Load_U32(&Worker->Deque.Top, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	} else {
+		uint32_t i;
+		for(i = 0; i < JobSystem->NodeCount; i++) {
+			Bottom = AK_Atomic_Load_U32(&JobSystem->Nodes[i].Queue.EnqueueIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			Top = AK_Atomic_Load_U32(&JobSystem->Nodes[i].Queue.DequeueIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			if((int32_t)(Bottom-Top) > 0) return ak_atomic_false;
+		}
+		return ak_atomic_true;
+	}
+	return (int32_t)(Bottom-Top) <= 0;
+}
+
+static AK_JOB_CALLBACK_DEFINE(AK_Parallel_For__Job);
+
+static int8_t AK_Parallel_For__Spawn(ak_parallel_for* ParallelFor, ak_job_worker* Worker, uint64_t Begin, uint64_t End) {
+	ak_parallel_for_range* Range = NULL;
+	ak_job_entry Entry;
+	uint32_t i, Index;
+
+	/*Spawners start at different ranges so they don't all fight over the first free one*/
+	Index = AK_Atomic_Fetch_Add_U32(&ParallelFor->NextRange, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < AK_PARALLEL_FOR_MAX_PENDING_RANGES && !Range; i++) {
+		ak_parallel_for_range* Candidate = ParallelFor->Ranges + (Index+i) % AK_PARALLEL_FOR_MAX_PENDING_RANGES;
+		uint32_t IsUsed = 0;
+		if(!AK_Atomic_Load_U32(&Candidate->IsUsed, AK_ATOMIC_MEMORY_ORDER_RELAXED) &&
+		   AK_Atomic_Compare_Exchange_Strong_U32(&Candidate->IsUsed, &IsUsed, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+			Range = Candidate;
+		}
+	}
+	if(!Range) return ak_atomic_false;
+
+	Range->ParallelFor = ParallelFor;
+	Range->Begin = Begin;
+	Range->End = End;
+
+	Entry.Callback = AK_Parallel_For__Job;
+	Entry.UserData = Range;
+	Entry.Counter = &ParallelFor->Counter;
+
+	AK_Atomic_Increment_U32(&ParallelFor->Counter, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(!AK_Job_System__Push(ParallelFor->JobSystem, Worker, &Entry)) {
+		AK_Atomic_Decrement_U32(&ParallelFor->Counter, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U32(&Range->IsUsed, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		return ak_atomic_false;
+	}
+
+	AK_LW_Semaphore_Increment(&ParallelFor->JobSystem->Semaphore);
+	return ak_atomic_true;
+}
+
+static void AK_Parallel_For__Run(ak_parallel_for* ParallelFor, ak_job_worker* Worker, uint64_t Begin, uint64_t End) {
+	uint64_t Grain = ParallelFor->Grain;
+	while(Begin < End) {
+		uint64_t ChunkEnd;
+		if(End-Begin > Grain && AK_Parallel_For__Should_Split(ParallelFor->JobSystem, Worker)) {
+			uint64_t Middle = Begin + (End-Begin)/2;
+			if(AK_Parallel_For__Spawn(ParallelFor, Worker, Middle, End)) {
+				End = Middle;
+				continue;
+			}
+		}
+
+		ChunkEnd = (End-Begin > Grain) ? Begin+Grain : End;
+		ParallelFor->Callback(Begin, ChunkEnd, ParallelFor->UserData);
+		Begin = ChunkEnd;
+	}
+}
+
+static AK_JOB_CALLBACK_DEFINE(AK_Parallel_For__Job) {
+	ak_parallel_for_range* Range = (ak_parallel_for_range*)UserData;
+	ak_job_worker* Worker = (ak_job_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+	ak_parallel_for* ParallelFor = Range->ParallelFor;
+	uint64_t Begin = Range->Begin;
+	uint64_t End = Range->End;
+
+	/*The parallel for itself stays alive until our job is counted as done, only the range is reused*/
+	AK_Atomic_Store_U32(&Range->IsUsed, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	AK_Parallel_For__Run(ParallelFor, Worker, Begin, End);
+}
+
+AKATOMICDEF void AK_Parallel_For(ak_job_system* JobSystem, uint64_t Begin, uint64_t End, uint64_t Grain, ak_parallel_for_callback_func* Callback, void* UserData) {
+	ak_parallel_for ParallelFor;
+	uint32_t i;
+
+	if(Begin >= End) return;
+	if(!Grain) Grain = 1;
+
+	/*Nothing to split, skip the bookkeeping. Comparing against the grain instead of rounding up a 
+	  chunk count can't overflow for ranges close to the full 64 bits*/
+	if(End-Begin <= Grain) {
+		Callback(Begin, End, UserData);
+		return;
+	}
+
+	ParallelFor.JobSystem = JobSystem;
+	ParallelFor.Callback = Callback;
+	ParallelFor.UserData = UserData;
+	ParallelFor.Grain = Grain;
+	AK_Atomic_Store_U32(&ParallelFor.NextRange, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&ParallelFor.Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < AK_PARALLEL_FOR_MAX_PENDING_RANGES; i++) {
+		AK_Atomic_Store_U32(&ParallelFor.Ranges[i].IsUsed, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+
+	AK_Parallel_For__Run(&ParallelFor, (ak_job_worker*)AK_TLS_Get(&JobSystem->WorkerTLS), Begin, End);
+	AK_Job_System_Wait(JobSystem, &ParallelFor.Counter);
+}
+
+/*Task graph*/
+typedef struct {
+	ak_task_graph* 		  Graph;
+	ak_job_callback_func* Callback;
+	void* 				  UserData;
+	ak_atomic_u32 		  PendingCount;
+	uint32_t 			  PredecessorCount;
+	uint32_t 			  SuccessorIndex;
+	uint32_t 			  SuccessorCount;
+} ak_task_graph_node;
+
+typedef struct {
+	uint32_t Predecessor;
+	uint32_t Successor;
+} ak_task_graph_edge;
+
+/*Edges are kept as added and only turned into per node successor lists when the graph changed
+  since the last run*/
+struct ak_task_graph {
+	ak_task_graph_node* Nodes;
+	ak_task_graph_edge* Edges;
+	uint32_t* 			Successors;
+	uint32_t* 			Roots;
+	uint32_t 			NodeCount;
+	uint32_t 			MaxNodeCount;
+	uint32_t 			EdgeCount;
+	uint32_t 			MaxEdgeCount;
+	uint32_t 			RootCount;
+	int8_t 				IsDirty;
+	int8_t 				Padding[3];
+	ak_atomic_u32 		Counter;
+	uint32_t 			Padding2;
+};
+
+AKATOMICDEF ak_task_graph* AK_Task_Graph_Create(uint32_t MaxNodeCount, uint32_t MaxEdgeCount) {
+	ak_task_graph* Graph = (ak_task_graph*)AK_ATOMIC_MALLOC(sizeof(ak_task_graph));
+	AK_ATOMIC_ASSERT(Graph);
+	if(!Graph) return NULL;
+	AK_ATOMIC_MEMORY_CLEAR(Graph, sizeof(ak_task_graph));
+
+	Graph->Nodes = (ak_task_graph_node*)AK_ATOMIC_MALLOC(sizeof(ak_task_graph_node)*(MaxNodeCount ? MaxNodeCount : 1));
+	Graph->Roots = (uint32_t*)AK_ATOMIC_MALLOC(sizeof(uint32_t)*(MaxNodeCount ? MaxNodeCount : 1));
+	Graph->Edges = (ak_task_graph_edge*)AK_ATOMIC_MALLOC(sizeof(ak_task_graph_edge)*(MaxEdgeCount ? MaxEdgeCount : 1));
+	Graph->Successors = (uint32_t*)AK_ATOMIC_MALLOC(sizeof(uint32_t)*(MaxEdgeCount ? MaxEdgeCount : 1));
+	if(!Graph->Nodes || !Graph->Roots || !Graph->Edges || !Graph->Successors) {
+		AK_ATOMIC_ASSERT(!"Failed to allocate task graph");
+		AK_Task_Graph_Delete(Graph);
+		return NULL;
+	}
+
+	Graph->MaxNodeCount = MaxNodeCount;
+	Graph->MaxEdgeCount = MaxEdgeCount;
+	return Graph;
+}
+
+AKATOMICDEF void AK_Task_Graph_Delete(ak_task_graph* Graph) {
+	AK_ATOMIC_ASSERT(Graph);
+	if(!Graph) return;
+	if(Graph->Successors) AK_ATOMIC_FREE(Graph->Successors);
+	if(Graph->Edges) AK_ATOMIC_FREE(Graph->Edges);
+	if(Graph->Roots) AK_ATOMIC_FREE(Graph->Roots);
+	if(Graph->Nodes) AK_ATOMIC_FREE(Graph->Nodes);
+	AK_ATOMIC_FREE(Graph);
+}
+
+AKATOMICDEF void AK_Task_Graph_Clear(ak_task_graph* Graph) {
+	Graph->NodeCount = 0;
+	Graph->EdgeCount = 0;
+	Graph->RootCount = 0;
+	Graph->IsDirty = ak_atomic_false;
+}
+
+AKATOMICDEF uint32_t AK_Task_Graph_Add_Node(ak_task_graph* Graph, ak_job_callback_func* Callback, void* UserData) {
+	ak_task_graph_node* Node;
+	AK_ATOMIC_ASSERT(Graph->NodeCount < Graph->MaxNodeCount);
+	if(Graph->NodeCount >= Graph->MaxNodeCount) return AK_TASK_GRAPH_INVALID_NODE;
+
+	Node = Graph->Nodes + Graph->NodeCount;
+	Node->Graph = Graph;
+	Node->Callback = Callback;
+	Node->UserData = UserData;
+	Graph->IsDirty = ak_atomic_true;
+	return Graph->NodeCount++;
+}
+
+AKATOMICDEF int8_t AK_Task_Graph_Add_Edge(ak_task_graph* Graph, uint32_t Predecessor, uint32_t Successor) {
+	ak_task_graph_edge* Edge;
+	AK_ATOMIC_ASSERT(Predecessor < Graph->NodeCount && Successor < Graph->NodeCount && Predecessor != Successor);
+	AK_ATOMIC_ASSERT(Graph->EdgeCount < Graph->MaxEdgeCount);
+	if(Predecessor >= Graph->NodeCount || Successor >= Graph->NodeCount || Predecessor == Successor) return ak_atomic_false;
+	if(Graph->EdgeCount >= Graph->MaxEdgeCount) return ak_atomic_false;
+
+	Edge = Graph->Edges + Graph->EdgeCount++;
+	Edge->Predecessor = Predecessor;
+	Edge->Successor = Successor;
+	Graph->IsDirty = ak_atomic_true;
+	return ak_atomic_true;
+}
+
+static void AK_Task_Graph__Compile(ak_task_graph* Graph) {
+	uint32_t i, SuccessorIndex = 0;
+
+	for(i = 0; i < Graph->NodeCount; i++) {
+		Graph->Nodes[i].PredecessorCount = 0;
+		Graph->Nodes[i].SuccessorCount = 0;
+	}
+
+	for(i = 0; i < Graph->EdgeCount; i++) {
+		Graph->Nodes[Graph->Edges[i].Predecessor].SuccessorCount++;
+		Graph->Nodes[Graph->Edges[i].Successor].PredecessorCount++;
+	}
+
+	/*Successor count doubles as the fill cursor while the lists are written*/
+	Graph->RootCount = 0;
+	for(i = 0; i < Graph->NodeCount; i++) {
+		ak_task_graph_node* Node = Graph->Nodes + i;
+		Node->SuccessorIndex = SuccessorIndex;
+		SuccessorIndex += Node->SuccessorCount;
+		Node->SuccessorCount = 0;
+		if(!Node->PredecessorCount) Graph->Roots[Graph->RootCount++] = i;
+	}
+
+	for(i = 0; i < Graph->EdgeCount; i++) {
+		ak_task_graph_node* Node = Graph->Nodes + Graph->Edges[i].Predecessor;
+		Graph->Successors[Node->SuccessorIndex + Node->SuccessorCount++] = Graph->Edges[i].Successor;
+	}
+
+	AK_ATOMIC_ASSERT(!Graph->NodeCount || Graph->RootCount);
+	Graph->IsDirty = ak_atomic_false;
+}
+
+/*Runs the node and releases its successors. All ready successors but one are submitted, the last
+  one runs right here so a chain of nodes never goes through the queues*/
+static AK_JOB_CALLBACK_DEFINE(AK_Task_Graph__Job) {
+	ak_task_graph_node* Node = (ak_task_graph_node*)UserData;
+	ak_task_graph* Graph = Node->Graph;
+
+	while(Node) {
+		ak_task_graph_node* Next = NULL;
+		uint32_t i;
+
+		Node->Callback(JobSystem, Node->UserData);
+
+		for(i = 0; i < Node->SuccessorCount; i++) {
+			ak_task_graph_node* Successor = Graph->Nodes + Graph->Successors[Node->SuccessorIndex+i];
+			if(AK_Atomic_Fetch_Sub_U32(&Successor->PendingCount, 1, AK_ATOMIC_MEMORY_ORDER_ACQ_REL) == 1) {
+				if(Next) AK_Job_System_Submit(JobSystem, AK_Task_Graph__Job, Next, &Graph->Counter);
+				Next = Successor;
+			}
+		}
+
+		Node = Next;
+	}
+}
+
+AKATOMICDEF void AK_Task_Graph_Run(ak_task_graph* Graph, ak_job_system* JobSystem) {
+	uint32_t i;
+	if(Graph->IsDirty) AK_Task_Graph__Compile(Graph);
+	if(!Graph->NodeCount) return;
+
+	for(i = 0; i < Graph->NodeCount; i++) {
+		ak_task_graph_node* Node = Graph->Nodes + i;
+		AK_Atomic_Store_U32(&Node->PendingCount, Node->PredecessorCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	AK_Atomic_Store_U32(&Graph->Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	/*Submission publishes the pending counts to the workers*/
+	for(i = 0; i < Graph->RootCount; i++) {
+		AK_Job_System_Submit(JobSystem, AK_Task_Graph__Job, Graph->Nodes + Graph->Roots[i], &Graph->Counter);
+	}
+	AK_Job_System_Wait(JobSystem, &Graph->Counter);
+}
+
+/*Per cpu operations*/
+#ifdef AK_ATOMIC_RSEQ
+#include <stddef.h>
+
+#ifndef SYS_rseq
+#define SYS_rseq 334
+#endif
+
+/*Every abort handler has to be preceded by this signature, glibc registers with the same value*/
+#define AK_RSEQ__SIGNATURE 0x53053053
+#define AK_RSEQ__CPU_ID_UNINITIALIZED ((uint32_t)-1)
+
+/*Layout of the kernel's struct rseq. CPUID is at offset 4 and CriticalSection at offset 8, the
+  critical sections below depend on that*/
+typedef struct {
+	uint32_t CPUIDStart;
+	uint32_t CPUID;
+	uint64_t CriticalSection;
+	uint32_t Flags;
+	uint32_t Padding[3];
+} ak_rseq;
+
+/*Since glibc 2.35 every thread is already registered and only one registration per thread is 
+  allowed, so we use glibc's area when it exists and register our own otherwise*/
+AK_ATOMIC_EXTERN_C const ptrdiff_t __rseq_offset __attribute__((weak));
+AK_ATOMIC_EXTERN_C const unsigned int __rseq_size __attribute__((weak));
+
+static AK_ATOMIC__THREAD_LOCAL ak_rseq AK_RSeq__Thread_Area __attribute__((aligned(32)));
+static AK_ATOMIC__THREAD_LOCAL ak_rseq* AK_RSeq__Area;
+
+static ak_rseq* AK_RSeq__Get_Area(void) {
+	ak_rseq* Area = AK_RSeq__Area;
+	if(!Area) {
+		if(&__rseq_size && __rseq_size) {
+			char* ThreadPointer;
+			__asm__("movq %%fs:0, %0" : "=r"(ThreadPointer));
+			Area = (ak_rseq*)(ThreadPointer + __rseq_offset);
+		} else {
+			/*If registration fails the cpu id stays invalid and every operation takes the fallback*/
+			Area = &AK_RSeq__Thread_Area;
+			Area->CPUID = AK_RSEQ__CPU_ID_UNINITIALIZED;
+			syscall(SYS_rseq, Area, sizeof(ak_rseq), 0, AK_RSEQ__SIGNATURE);
+		}
+		AK_RSeq__Area = Area;
+	}
+	return Area;
+}
+
+/*Shared pieces of every critical section. Label 3 is the descriptor, 0 arms it, 1 and 2 bound the
+  restartable region and 4 is the abort handler which simply starts over. The cpu id is read inside
+  the region so it can't be stale by the time the single instruction at the end commits. Cpus that 
+  are out of range jump to 5 so the caller takes the fallback*/
+#define AK_RSEQ__BEGIN \
+	".pushsection __rseq_cs, \"aw\"\n\t" \
+	".balign 32\n\t" \
+	"3:\n\t" \
+	".long 0, 0\n\t" \
+	".quad 1f, 2f-1f, 4f\n\t" \
+	".popsection\n\t" \
+	"0:\n\t" \
+	"leaq 3b(%%rip), %%rax\n\t" \
+	"movq %%rax, 8(%[Area])\n\t" \
+	"1:\n\t" \
+	"movl 4(%[Area]), %%eax\n\t" \
+	"cmpl %[CPUCount], %%eax\n\t" \
+	"jae 5f\n\t" \
+	"imulq %[CellSize], %%rax, %%rax\n\t" \
+	"addq %[Cells], %%rax\n\t"
+
+#define AK_RSEQ__END \
+	"2:\n\t" \
+	"movl $1, %k[Status]\n\t" \
+	"jmp 6f\n\t" \
+	".pushsection __rseq_failure, \"ax\"\n\t" \
+	".byte 0x0f, 0xb9, 0x3d\n\t" \
+	".long 0x53053053\n\t" \
+	"4:\n\t" \
+	"jmp 0b\n\t" \
+	".popsection\n\t" \
+	"5:\n\t" \
+	"xorl %k[Status], %k[Status]\n\t" \
+	"6:\n\t"
+
+static int8_t AK_RSeq__Add_U64(ak_rseq* Area, ak_atomic_u64_padded* Cells, uint32_t CPUCount, uint64_t Addend) {
+	uint32_t Status;
+	__asm__ __volatile__(
+		AK_RSEQ__BEGIN
+		"addq %[Addend], (%%rax)\n\t"
+		AK_RSEQ__END
+		: [Status] "=&r"(Status)
+		: [Area] "r"(Area), [Cells] "r"(Cells), [CPUCount] "r"(CPUCount), 
+		  [CellSize] "i"(sizeof(ak_atomic_u64_padded)), [Addend] "r"(Addend)
+		: "rax", "memory", "cc");
+	return (int8_t)Status;
+}
+
+static int8_t AK_RSeq__Push(ak_rseq* Area, ak_atomic_u64_padded* Cells, uint32_t CPUCount, ak_percpu_list_node* Node) {
+	uint32_t Status;
+	__asm__ __volatile__(
+		AK_RSEQ__BEGIN
+		"movq (%%rax), %%rcx\n\t"
+		"movq %%rcx, (%[Node])\n\t"
+		"movq %[Node], (%%rax)\n\t"
+		AK_RSEQ__END
+		: [Status] "=&r"(Status)
+		: [Area] "r"(Area), [Cells] "r"(Cells), [CPUCount] "r"(CPUCount), 
+		  [CellSize] "i"(sizeof(ak_atomic_u64_padded)), [Node] "r"(Node)
+		: "rax", "rcx", "memory", "cc");
+	return (int8_t)Status;
+}
+
+/*Nothing else can touch this cpu's head while we are in the region, so reading the next pointer 
+  of the head can't race with another pop (no ABA)*/
+static int8_t AK_RSeq__Pop(ak_rseq* Area, ak_atomic_u64_padded* Cells, uint32_t CPUCount, ak_percpu_list_node** Node) {
+	uint32_t Status;
+	ak_percpu_list_node* Head;
+	__asm__ __volatile__(
+		AK_RSEQ__BEGIN
+		"movq (%%rax), %[Head]\n\t"
+		"testq %[Head], %[Head]\n\t"
+		"jz 2f\n\t"
+		"movq (%[Head]), %%rcx\n\t"
+		"movq %%rcx, (%%rax)\n\t"
+		AK_RSEQ__END
+		: [Status] "=&r"(Status), [Head] "=&r"(Head)
+		: [Area] "r"(Area), [Cells] "r"(Cells), [CPUCount] "r"(CPUCount), 
+		  [CellSize] "i"(sizeof(ak_atomic_u64_padded))
+		: "rax", "rcx", "memory", "cc");
+	*Node = Head;
+	return (int8_t)Status;
+}
+#endif
+
+/*Cells are aligned to a cache line so neighbouring cpus never share one*/
+static ak_atomic_u64_padded* AK_PerCPU__Allocate_Cells(void** Memory, uint32_t* CPUCount) {
+	ak_atomic_u64_padded* Cells;
+	size_t Size;
+	*Memory = NULL;
+	*CPUCount = 0;
+
+#ifdef AK_ATOMIC_RSEQ
+	{
+		long ConfiguredCount = sysconf(_SC_NPROCESSORS_CONF);
+		if(ConfiguredCount > 0) *CPUCount = (uint32_t)ConfiguredCount;
+	}
+#endif
+	if(!*CPUCount) return NULL;
+
+	Size = sizeof(ak_atomic_u64_padded)*(*CPUCount);
+	*Memory = AK_ATOMIC_MALLOC(Size+AK_ATOMIC_CACHE_LINE_SIZE);
+	if(!*Memory) {
+		*CPUCount = 0;
+		return NULL;
+	}
+
+	Cells = (ak_atomic_u64_padded*)AK_Atomic__Align_Cache_Line(*Memory);
+	AK_ATOMIC_MEMORY_CLEAR(Cells, Size);
+	return Cells;
+}
+
+AKATOMICDEF int8_t AK_PerCPU_Is_Accelerated(void) {
+#ifdef AK_ATOMIC_RSEQ
+	/*The kernel uses -1 for unregistered threads and -2 for failed registrations*/
+	uint32_t CPUID = *(volatile uint32_t*)&AK_RSeq__Get_Area()->CPUID;
+	return CPUID < AK_RSEQ__CPU_ID_UNINITIALIZED-1;
+#else
+	return ak_atomic_false;
+#endif
+}
+
+AKATOMICDEF int8_t AK_PerCPU_Counter_Create(ak_percpu_counter* Counter) {
+	AK_ATOMIC_MEMORY_CLEAR(Counter, sizeof(ak_percpu_counter));
+	/*Without cells every add simply goes to the shared word*/
+	Counter->Cells = AK_PerCPU__Allocate_Cells(&Counter->Memory, &Counter->CPUCount);
+	AK_Atomic_Store_U64(&Counter->Shared, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_PerCPU_Counter_Delete(ak_percpu_counter* Counter) {
+	if(Counter->Memory) AK_ATOMIC_FREE(Counter->Memory);
+	AK_ATOMIC_MEMORY_CLEAR(Counter, sizeof(ak_percpu_counter));
+}
+
+AKATOMICDEF void AK_PerCPU_Add_U64(ak_percpu_counter* Counter, uint64_t Addend) {
+#ifdef AK_ATOMIC_RSEQ
+	if(Counter->Cells && AK_RSeq__Add_U64(AK_RSeq__Get_Area(), Counter->Cells, Counter->CPUCount, Addend)) return;
+#endif
+	AK_Atomic_Fetch_Add_U64(&Counter->Shared, Addend, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+AKATOMICDEF uint64_t AK_PerCPU_Counter_Load(ak_percpu_counter* Counter) {
+	uint32_t i;
+	uint64_t Result = AK_Atomic_Load_U64(&Counter->Shared, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < Counter->CPUCount; i++) {
+		Result += AK_Atomic_Load_U64(&Counter->Cells[i].Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	return Result;
+}
+
+AKATOMICDEF int8_t AK_PerCPU_List_Create(ak_percpu_list* List) {
+	AK_ATOMIC_MEMORY_CLEAR(List, sizeof(ak_percpu_list));
+	List->Cells = AK_PerCPU__Allocate_Cells(&List->Memory, &List->CPUCount);
+	AK_Atomic_Store_U32(&List->SharedLock, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_Ptr(&List->SharedHead, NULL, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_PerCPU_List_Delete(ak_percpu_list* List) {
+	if(List->Memory) AK_ATOMIC_FREE(List->Memory);
+	AK_ATOMIC_MEMORY_CLEAR(List, sizeof(ak_percpu_list));
+}
+
+/*The fallback list is a plain spin locked list, a lock free stack would need a tagged pointer to 
+  avoid ABA*/
+static void AK_PerCPU_List__Lock(ak_percpu_list* List) {
+	while(AK_Atomic_Exchange_U32(&List->SharedLock, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+		while(AK_Atomic_Load_U32(&List->SharedLock, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+			AK_ATOMIC__SPIN_PAUSE();
+		}
+	}
+}
+
+static void AK_PerCPU_List__Unlock(ak_percpu_list* List) {
+	AK_Atomic_Store_U32(&List->SharedLock, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF void AK_PerCPU_List_Push(ak_percpu_list* List, ak_percpu_list_node* Node) {
+#ifdef AK_ATOMIC_RSEQ
+	if(List->Cells && AK_RSeq__Push(AK_RSeq__Get_Area(), List->Cells, List->CPUCount, Node)) return;
+#endif
+	AK_PerCPU_List__Lock(List);
+	Node->Next = (ak_percpu_list_node*)AK_Atomic_Load_Ptr(&List->SharedHead, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_Ptr(&List->SharedHead, Node, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_PerCPU_List__Unlock(List);
+}
+
+AKATOMICDEF ak_percpu_list_node* AK_PerCPU_List_Pop(ak_percpu_list* List) {
+	ak_percpu_list_node* Node = NULL;
+#ifdef AK_ATOMIC_RSEQ
+	if(List->Cells && AK_RSeq__Pop(AK_RSeq__Get_Area(), List->Cells, List->CPUCount, &Node) && Node) return Node;
+#endif
+	if(!AK_Atomic_Load_Ptr(&List->SharedHead, AK_ATOMIC_MEMORY_ORDER_RELAXED)) return NULL;
+
+	AK_PerCPU_List__Lock(List);
+	Node = (ak_percpu_list_node*)AK_Atomic_Load_Ptr(&List->SharedHead, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(Node) AK_Atomic_Store_Ptr(&List->SharedHead, Node->Next, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_PerCPU_List__Unlock(List);
+	return Node;
+}
+
+/*Sharded counters*/
+/*Threads get sequential indices on first use so up to cell count threads never share a cell*/
+static ak_atomic_u32 AK_Sharded_Counter__Next_Thread_Index;
+static AK_ATOMIC__THREAD_LOCAL uint32_t AK_Sharded_Counter__Thread_Index;
+
+static uint32_t AK_Sharded_Counter__Get_Thread_Index(void) {
+	uint32_t Index = AK_Sharded_Counter__Thread_Index;
+	if(!Index) {
+		Index = AK_Atomic_Increment_U32(&AK_Sharded_Counter__Next_Thread_Index, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(!Index) Index = AK_Atomic_Increment_U32(&AK_Sharded_Counter__Next_Thread_Index, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Sharded_Counter__Thread_Index = Index;
+	}
+	return Index;
+}
+
+AKATOMICDEF int8_t AK_Sharded_Counter_Create(ak_sharded_counter* Counter, uint32_t CellCount) {
+	uint32_t Count = 1;
+	if(!CellCount) CellCount = AK_Get_Effective_Processor_Thread_Count();
+	while(Count < CellCount && Count < 0x80000000u) Count <<= 1;
+
+	AK_ATOMIC_MEMORY_CLEAR(Counter, sizeof(ak_sharded_counter));
+	Counter->Memory = AK_ATOMIC_MALLOC(sizeof(ak_atomic_u64_padded)*Count + AK_ATOMIC_CACHE_LINE_SIZE);
+	AK_ATOMIC_ASSERT(Counter->Memory);
+	if(!Counter->Memory) return ak_atomic_false;
+
+	Counter->Cells = (ak_atomic_u64_padded*)AK_Atomic__Align_Cache_Line(Counter->Memory);
+	Counter->CellMask = Count-1;
+	AK_ATOMIC_MEMORY_CLEAR(Counter->Cells, sizeof(ak_atomic_u64_padded)*Count);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_Sharded_Counter_Delete(ak_sharded_counter* Counter) {
+	if(Counter->Memory) AK_ATOMIC_FREE(Counter->Memory);
+	AK_ATOMIC_MEMORY_CLEAR(Counter, sizeof(ak_sharded_counter));
+}
+
+AKATOMICDEF void AK_Sharded_Counter_Add(ak_sharded_counter* Counter, uint64_t Addend) {
+	ak_atomic_u64_padded* Cell = Counter->Cells + (AK_Sharded_Counter__Get_Thread_Index() & Counter->CellMask);
+	AK_Atomic_Fetch_Add_U64(&Cell->Value, Addend, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+AKATOMICDEF uint64_t AK_Sharded_Counter_Load(ak_sharded_counter* Counter) {
+	uint32_t i;
+	uint64_t Result = 0;
+	for(i = 0; i <= Counter->CellMask; i++) {
+		Result += AK_Atomic_Load_U64(&Counter->Cells[i].Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	return Result;
+}
+
+AKATOMICDEF void AK_Adaptive_Counter_Create(ak_adaptive_counter* Counter, uint32_t CellCount, uint32_t InflateThreshold) {
+	AK_ATOMIC_MEMORY_CLEAR(Counter, sizeof(ak_adaptive_counter));
+	AK_Atomic_Store_U64(&Counter->Value, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_Ptr(&Counter->Shards, NULL, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Counter->FailureCount, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Counter->InflateThreshold = InflateThreshold ? InflateThreshold : AK_ADAPTIVE_COUNTER_DEFAULT_INFLATE_THRESHOLD;
+	Counter->CellCount = CellCount;
+}
+
+AKATOMICDEF void AK_Adaptive_Counter_Delete(ak_adaptive_counter* Counter) {
+	ak_sharded_counter* Shards = (ak_sharded_counter*)AK_Atomic_Load_Ptr(&Counter->Shards, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(Shards) {
+		AK_Sharded_Counter_Delete(Shards);
+		AK_ATOMIC_FREE(Shards);
+	}
+	AK_ATOMIC_MEMORY_CLEAR(Counter, sizeof(ak_adaptive_counter));
+}
+
+/*Racing threads may both build shards, the loser frees its copy. If the allocation fails the 
+  counter stays a single word for now*/
+static int8_t AK_Adaptive_Counter__Inflate(ak_adaptive_counter* Counter) {
+	void* OldShards = NULL;
+	ak_sharded_counter* Shards = (ak_sharded_counter*)AK_ATOMIC_MALLOC(sizeof(ak_sharded_counter));
+	if(!Shards) return ak_atomic_false;
+	if(!AK_Sharded_Counter_Create(Shards, Counter->CellCount)) {
+		AK_ATOMIC_FREE(Shards);
+		return ak_atomic_false;
+	}
+
+	if(!AK_Atomic_Compare_Exchange_Strong_Ptr(&Counter->Shards, &OldShards, Shards, AK_ATOMIC_MEMORY_ORDER_RELEASE)) {
+		AK_Sharded_Counter_Delete(Shards);
+		AK_ATOMIC_FREE(Shards);
+	}
+	return ak_atomic_true;
+}
+
+/*One in every AK_ADAPTIVE_COUNTER__SAMPLE_MASK+1 adds of a thread probes for contention*/
+#define AK_ADAPTIVE_COUNTER__SAMPLE_MASK 15
+static AK_ATOMIC__THREAD_LOCAL uint32_t AK_Adaptive_Counter__Thread_Add_Count;
+
+AKATOMICDEF void AK_Adaptive_Counter_Add(ak_adaptive_counter* Counter, uint64_t Addend) {
+	uint64_t OldValue;
+	ak_sharded_counter* Shards = (ak_sharded_counter*)AK_Atomic_Load_Ptr(&Counter->Shards, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(Shards) {
+		AK_Sharded_Counter_Add(Shards, Addend);
+		return;
+	}
+
+	if(++AK_Adaptive_Counter__Thread_Add_Count & AK_ADAPTIVE_COUNTER__SAMPLE_MASK) {
+		AK_Atomic_Fetch_Add_U64(&Counter->Value, Addend, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		return;
+	}
+
+	/*A single compare exchange attempt tells us whether somebody else wrote the word in between. 
+	  On failure the add is finished with a fetch add and the failure counts towards inflating*/
+	OldValue = AK_Atomic_Load_U64(&Counter->Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(AK_Atomic_Compare_Exchange_Weak_U64(&Counter->Value, &OldValue, OldValue+Addend, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+		return;
+	}
+
+	AK_Atomic_Fetch_Add_U64(&Counter->Value, Addend, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(AK_Atomic_Increment_U32(&Counter->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == Counter->InflateThreshold) {
+		/*Starting the failure count over backs off a full threshold of failed probes before the 
+		  next attempt, instead of giving up on inflating for good*/
+		if(!AK_Adaptive_Counter__Inflate(Counter)) {
+			AK_Atomic_Store_U32(&Counter->FailureCount, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+	}
+}
+
+/*Adds made before inflating stay in the word, so both are summed*/
+AKATOMICDEF uint64_t AK_Adaptive_Counter_Load(ak_adaptive_counter* Counter) {
+	uint64_t Result = AK_Atomic_Load_U64(&Counter->Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	ak_sharded_counter* Shards = (ak_sharded_counter*)AK_Atomic_Load_Ptr(&Counter->Shards, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(Shards) Result += AK_Sharded_Counter_Load(Shards);
+	return Result;
+}
+
+AKATOMICDEF int8_t AK_Adaptive_Counter_Is_Inflated(ak_adaptive_counter* Counter) {
+	return AK_Atomic_Load_Ptr(&Counter->Shards, AK_ATOMIC_MEMORY_ORDER_RELAXED) != NULL;
+}
+
+/*Memory reclamation lists. Retired pointers are collected in growable per thread arrays. Lists 
+  of exited threads become orphans tagged with the epoch they were retired in (hazard pointers 
+  don't use it). The orphan list is only pushed to and emptied as a whole with an exchange, which 
+  can't suffer from ABA*/
+typedef struct {
+	void* 					  Pointer;
+	ak_reclaim_callback_func* Callback;
+} ak_reclaim__entry;
+
+typedef struct {
+	ak_reclaim__entry* Entries;
+	uint32_t 		   Count;
+	uint32_t 		   Capacity;
+} ak_reclaim__list;
+
+typedef struct ak_reclaim__orphan ak_reclaim__orphan;
+struct ak_reclaim__orphan {
+	ak_reclaim__orphan* Next;
+	ak_reclaim__list 	List;
+	uint64_t 			Epoch;
+};
+
+#define AK_RECLAIM__MIN_CAPACITY 64
+
+static int8_t AK_Reclaim__List_Reserve(ak_reclaim__list* List, uint32_t Count) {
+	ak_reclaim__entry* Entries;
+	uint32_t i, Capacity = List->Capacity ? List->Capacity : AK_RECLAIM__MIN_CAPACITY;
+	if(Count <= List->Capacity) return ak_atomic_true;
+
+	while(Capacity < Count) Capacity *= 2;
+	Entries = (ak_reclaim__entry*)AK_ATOMIC_MALLOC(sizeof(ak_reclaim__entry)*Capacity);
+	AK_ATOMIC_ASSERT(Entries);
+	if(!Entries) return ak_atomic_false;
+
+	for(i = 0; i < List->Count; i++) Entries[i] = List->Entries[i];
+	if(List->Entries) AK_ATOMIC_FREE(List->Entries);
+	List->Entries = Entries;
+	List->Capacity = Capacity;
+	return ak_atomic_true;
+}
+
+static int8_t AK_Reclaim__List_Push(ak_reclaim__list* List, void* Pointer, ak_reclaim_callback_func* Callback) {
+	if(!AK_Reclaim__List_Reserve(List, List->Count+1)) return ak_atomic_false;
+	List->Entries[List->Count].Pointer = Pointer;
+	List->Entries[List->Count].Callback = Callback;
+	List->Count++;
+	return ak_atomic_true;
+}
+
+static void AK_Reclaim__List_Append(ak_reclaim__list* List, ak_reclaim__list* Other) {
+	uint32_t i;
+	if(!AK_Reclaim__List_Reserve(List, List->Count+Other->Count)) return;
+	for(i = 0; i < Other->Count; i++) List->Entries[List->Count++] = Other->Entries[i];
+	Other->Count = 0;
+}
+
+static void AK_Reclaim__List_Run(ak_reclaim__list* List) {
+	uint32_t i;
+	for(i = 0; i < List->Count; i++) List->Entries[i].Callback(List->Entries[i].Pointer);
+	List->Count = 0;
+}
+
+static void AK_Reclaim__List_Delete(ak_reclaim__list* List) {
+	if(List->Entries) AK_ATOMIC_FREE(List->Entries);
+	AK_ATOMIC_MEMORY_CLEAR(List, sizeof(ak_reclaim__list));
+}
+
+/*Moves the list into an orphan, the list is left empty. If the orphan can't be allocated the 
+  pointers leak, which is still better than freeing them too early*/
+static void AK_Reclaim__Push_Orphan(ak_atomic_ptr* Orphans, ak_reclaim__list* List, uint64_t Epoch) {
+	void* Head;
+	ak_reclaim__orphan* Orphan;
+	if(!List->Count) return;
+
+	Orphan = (ak_reclaim__orphan*)AK_ATOMIC_MALLOC(sizeof(ak_reclaim__orphan));
+	AK_ATOMIC_ASSERT(Orphan);
+	if(!Orphan) return;
+	Orphan->List = *List;
+	Orphan->Epoch = Epoch;
+	AK_ATOMIC_MEMORY_CLEAR(List, sizeof(ak_reclaim__list));
+
+	Head = AK_Atomic_Load_Ptr(Orphans, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	do {
+		Orphan->Next = (ak_reclaim__orphan*)Head;
+	} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(Orphans, &Head, Orphan, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+}
+
+static void AK_Reclaim__Delete_Orphan(ak_reclaim__orphan* Orphan) {
+	AK_Reclaim__List_Delete(&Orphan->List);
+	AK_ATOMIC_FREE(Orphan);
+}
+
+/*Header of the per thread records of hazard pointers, epochs and rcu. Records are only ever added 
+  to their global list and never freed, a thread that exits marks its record inactive so the next 
+  new thread can take it over*/
+typedef struct ak_reclaim__record ak_reclaim__record;
+struct ak_reclaim__record {
+	ak_reclaim__record* Next;
+	ak_atomic_u32 		IsActive;
+	uint32_t 			Padding;
+};
+
+/*Takes over an inactive record or allocates a cleared one of Size bytes and sets IsNew. New 
+  records get their own cache lines since other threads poll them*/
+static ak_reclaim__record* AK_Reclaim__Acquire_Record(ak_atomic_ptr* Records, size_t Size, int8_t* IsNew) {
+	ak_reclaim__record* Record;
+	void* Head;
+	void* Memory;
+
+	*IsNew = ak_atomic_false;
+	for(Record = (ak_reclaim__record*)AK_Atomic_Load_Ptr(Records, AK_ATOMIC_MEMORY_ORDER_ACQUIRE); Record; Record = Record->Next) {
+		uint32_t IsActive = 0;
+		if(AK_Atomic_Compare_Exchange_Strong_U32(&Record->IsActive, &IsActive, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+			return Record;
+		}
+	}
+
+	Memory = AK_ATOMIC_MALLOC(Size+AK_ATOMIC_CACHE_LINE_SIZE);
+	AK_ATOMIC_ASSERT(Memory);
+	if(!Memory) return NULL;
+	Record = (ak_reclaim__record*)AK_Atomic__Align_Cache_Line(Memory);
+	AK_ATOMIC_MEMORY_CLEAR(Record, Size);
+	AK_Atomic_Store_U32(&Record->IsActive, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	*IsNew = ak_atomic_true;
+
+	Head = AK_Atomic_Load_Ptr(Records, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	do {
+		Record->Next = (ak_reclaim__record*)Head;
+	} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(Records, &Head, Record, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+	return Record;
+}
+
+static void AK_Reclaim__Release_Record(ak_reclaim__record* Record) {
+	AK_Atomic_Store_U32(&Record->IsActive, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/*Hazard pointers*/
+
+typedef struct ak_hazard__record ak_hazard__record;
+struct ak_hazard__record {
+	ak_reclaim__record Header;
+	ak_atomic_ptr 	   Slots[AK_HAZARD_SLOT_COUNT];
+	ak_reclaim__list   Retired;
+	void** 			   Hazards;
+	uint32_t 		   HazardCapacity;
+	uint32_t 		   Padding;
+};
+
+static ak_atomic_ptr AK_Hazard__Records;
+static ak_atomic_u32 AK_Hazard__Record_Count;
+static ak_atomic_ptr AK_Hazard__Orphans;
+static AK_ATOMIC__THREAD_LOCAL ak_hazard__record* AK_Hazard__Thread_Record;
+
+static ak_hazard__record* AK_Hazard__Get_Record(void) {
+	ak_hazard__record* Record = AK_Hazard__Thread_Record;
+	int8_t IsNew;
+	if(Record) return Record;
+
+	Record = (ak_hazard__record*)AK_Reclaim__Acquire_Record(&AK_Hazard__Records, sizeof(ak_hazard__record), &IsNew);
+	if(!Record) return NULL;
+	if(IsNew) AK_Atomic_Increment_U32(&AK_Hazard__Record_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	AK_Hazard__Thread_Record = Record;
+	return Record;
+}
+
+static void AK_Hazard__Sort(void** Pointers, uint32_t Count) {
+	uint32_t Gap, i, j;
+	for(Gap = Count/2; Gap; Gap /= 2) {
+		for(i = Gap; i < Count; i++) {
+			void* Pointer = Pointers[i];
+			for(j = i; j >= Gap && (size_t)Pointers[j-Gap] > (size_t)Pointer; j -= Gap) {
+				Pointers[j] = Pointers[j-Gap];
+			}
+			Pointers[j] = Pointer;
+		}
+	}
+}
+
+static int8_t AK_Hazard__Contains(void** Pointers, uint32_t Count, void* Pointer) {
+	uint32_t Low = 0, High = Count;
+	while(Low < High) {
+		uint32_t Middle = Low + (High-Low)/2;
+		if((size_t)Pointers[Middle] < (size_t)Pointer) Low = Middle+1;
+		else High = Middle;
+	}
+	return Low < Count && Pointers[Low] == Pointer;
+}
+
+static void AK_Hazard__Scan(ak_hazard__record* Record) {
+	ak_reclaim__orphan* Orphan;
+	ak_hazard__record* Other;
+	uint32_t i, HazardCount = 0, KeptCount = 0;
+
+	/*Adopt whatever exited threads left behind*/
+	Orphan = (ak_reclaim__orphan*)AK_Atomic_Exchange_Ptr(&AK_Hazard__Orphans, NULL, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Orphan) {
+		ak_reclaim__orphan* Next = Orphan->Next;
+		AK_Reclaim__List_Append(&Record->Retired, &Orphan->List);
+		AK_Reclaim__Delete_Orphan(Orphan);
+		Orphan = Next;
+	}
+
+	/*Pairs with the light fence in protect. Every slot that was published before the pointers got
+	  unlinked is visible after this*/
+	AK_Atomic_Fence_Heavy();
+
+	for(Other = (ak_hazard__record*)AK_Atomic_Load_Ptr(&AK_Hazard__Records, AK_ATOMIC_MEMORY_ORDER_ACQUIRE); Other; Other = (ak_hazard__record*)Other->Header.Next) {
+		for(i = 0; i < AK_HAZARD_SLOT_COUNT; i++) {
+			void* Pointer = AK_Atomic_Load_Ptr(&Other->Slots[i], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			if(!Pointer) continue;
+
+			if(HazardCount == Record->HazardCapacity) {
+				uint32_t j, Capacity = Record->HazardCapacity ? Record->HazardCapacity*2 : AK_HAZARD_SLOT_COUNT*16;
+				void** Hazards = (void**)AK_ATOMIC_MALLOC(sizeof(void*)*Capacity);
+				/*Without room to remember the hazard nothing can be freed safely this time*/
+				if(!Hazards) return;
+				for(j = 0; j < HazardCount; j++) Hazards[j] = Record->Hazards[j];
+				if(Record->Hazards) AK_ATOMIC_FREE(Record->Hazards);
+				Record->Hazards = Hazards;
+				Record->HazardCapacity = Capacity;
+			}
+			Record->Hazards[HazardCount++] = Pointer;
+		}
+	}
+	AK_Hazard__Sort(Record->Hazards, HazardCount);
+
+	for(i = 0; i < Record->Retired.Count; i++) {
+		ak_reclaim__entry Entry = Record->Retired.Entries[i];
+		if(AK_Hazard__Contains(Record->Hazards, HazardCount, Entry.Pointer)) {
+			Record->Retired.Entries[KeptCount++] = Entry;
+		} else {
+			Entry.Callback(Entry.Pointer);
+		}
+	}
+	Record->Retired.Count = KeptCount;
+}
+
+AKATOMICDEF void* AK_Hazard_Protect(uint32_t Slot, ak_atomic_ptr* Source) {
+	ak_hazard__record* Record = AK_Hazard__Get_Record();
+	void* Pointer = AK_Atomic_Load_Ptr(Source, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_ATOMIC_ASSERT(Slot < AK_HAZARD_SLOT_COUNT);
+	for(;;) {
+		void* Validate;
+		AK_Atomic_Store_Ptr(&Record->Slots[Slot], Pointer, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		/*The slot store has to be visible before we reread, otherwise a scan could miss it*/
+		AK_Atomic_Fence_Light();
+		Validate = AK_Atomic_Load_Ptr(Source, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		if(Validate == Pointer) return Pointer;
+		Pointer = Validate;
+	}
+}
+
+AKATOMICDEF void AK_Hazard_Set(uint32_t Slot, void* Pointer) {
+	ak_hazard__record* Record = AK_Hazard__Get_Record();
+	AK_ATOMIC_ASSERT(Slot < AK_HAZARD_SLOT_COUNT);
+	AK_Atomic_Store_Ptr(&Record->Slots[Slot], Pointer, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Fence_Light();
+}
+
+AKATOMICDEF void AK_Hazard_Clear(uint32_t Slot) {
+	ak_hazard__record* Record = AK_Hazard__Get_Record();
+	AK_ATOMIC_ASSERT(Slot < AK_HAZARD_SLOT_COUNT);
+	AK_Atomic_Store_Ptr(&Record->Slots[Slot], NULL, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/*Checks every slot for a single pointer, which needs no memory unlike a full scan*/
+static int8_t AK_Hazard__Is_Protected(void* Pointer) {
+	ak_hazard__record* Other;
+	uint32_t i;
+	AK_Atomic_Fence_Heavy();
+	for(Other = (ak_hazard__record*)AK_Atomic_Load_Ptr(&AK_Hazard__Records, AK_ATOMIC_MEMORY_ORDER_ACQUIRE); Other; Other = (ak_hazard__record*)Other->Header.Next) {
+		for(i = 0; i < AK_HAZARD_SLOT_COUNT; i++) {
+			if(AK_Atomic_Load_Ptr(&Other->Slots[i], AK_ATOMIC_MEMORY_ORDER_RELAXED) == Pointer) return ak_atomic_true;
+		}
+	}
+	return ak_atomic_false;
+}
+
+AKATOMICDEF int8_t AK_Hazard_Retire(void* Pointer, ak_reclaim_callback_func* Callback) {
+	ak_hazard__record* Record = AK_Hazard__Get_Record();
+	uint32_t Threshold = 2*AK_HAZARD_SLOT_COUNT*AK_Atomic_Load_U32(&AK_Hazard__Record_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(Threshold < AK_HAZARD_RETIRE_THRESHOLD) Threshold = AK_HAZARD_RETIRE_THRESHOLD;
+
+	if(Record) {
+		if(AK_Reclaim__List_Push(&Record->Retired, Pointer, Callback)) {
+			if(Record->Retired.Count >= Threshold) AK_Hazard__Scan(Record);
+			return ak_atomic_true;
+		}
+
+		/*A scan frees whatever isn't protected anymore, which may make room in the list*/
+		AK_Hazard__Scan(Record);
+		if(AK_Reclaim__List_Push(&Record->Retired, Pointer, Callback)) return ak_atomic_true;
+	}
+
+	/*Without memory to defer the free it has to happen now, but only if no reader can see it*/
+	if(AK_Hazard__Is_Protected(Pointer)) return ak_atomic_false;
+	Callback(Pointer);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_Hazard_Scan(void) {
+	AK_Hazard__Scan(AK_Hazard__Get_Record());
+}
+
+AKATOMICDEF void AK_Hazard_Thread_Exit(void) {
+	ak_hazard__record* Record = AK_Hazard__Thread_Record;
+	uint32_t i;
+	if(!Record) return;
+
+	for(i = 0; i < AK_HAZARD_SLOT_COUNT; i++) {
+		AK_Atomic_Store_Ptr(&Record->Slots[i], NULL, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	}
+	AK_Hazard__Scan(Record);
+
+	AK_Reclaim__Push_Orphan(&AK_Hazard__Orphans, &Record->Retired, 0);
+
+	AK_Hazard__Thread_Record = NULL;
+	AK_Reclaim__Release_Record(&Record->Header);
+}
+
+/*Epoch based reclamation*/
+#define AK_EPOCH__BUCKET_COUNT 3
+
+/*Announced is epoch*2+1 while the thread is inside a critical section and 0 outside of it*/
+typedef struct ak_epoch__record ak_epoch__record;
+struct ak_epoch__record {
+	ak_reclaim__record 	 Header;
+	ak_atomic_u64_padded Announced;
+	uint32_t 			 NestCount;
+	uint32_t 			 PendingCount;
+	uint32_t 			 NextCollect;
+	uint32_t 			 Padding;
+	ak_reclaim__list 	 Buckets[AK_EPOCH__BUCKET_COUNT];
+	uint64_t 			 BucketEpochs[AK_EPOCH__BUCKET_COUNT];
+};
+
+static ak_atomic_u64 AK_Epoch__Global;
+static ak_atomic_ptr AK_Epoch__Records;
+static ak_atomic_ptr AK_Epoch__Orphans;
+static AK_ATOMIC__THREAD_LOCAL ak_epoch__record* AK_Epoch__Thread_Record;
+
+static ak_epoch__record* AK_Epoch__Get_Record(void) {
+	ak_epoch__record* Record = AK_Epoch__Thread_Record;
+	int8_t IsNew;
+	if(Record) return Record;
+
+	Record = (ak_epoch__record*)AK_Reclaim__Acquire_Record(&AK_Epoch__Records, sizeof(ak_epoch__record), &IsNew);
+	if(!Record) return NULL;
+	if(IsNew) Record->NextCollect = AK_EPOCH_RETIRE_THRESHOLD;
+
+	AK_Epoch__Thread_Record = Record;
+	return Record;
+}
+
+static uint64_t AK_Epoch__Try_Advance(void) {
+	ak_epoch__record* Record;
+	uint64_t Epoch = AK_Atomic_Load_U64(&AK_Epoch__Global, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+
+	/*Pairs with the light fence in enter. Every announcement made before this point is visible 
+	  and every critical section entered after it sees all unlinks made before it*/
+	AK_Atomic_Fence_Heavy();
+
+	for(Record = (ak_epoch__record*)AK_Atomic_Load_Ptr(&AK_Epoch__Records, AK_ATOMIC_MEMORY_ORDER_ACQUIRE); Record; Record = (ak_epoch__record*)Record->Header.Next) {
+		uint64_t Announced = AK_Atomic_Load_U64(&Record->Announced.Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if((Announced & 1) && (Announced >> 1) != Epoch) return Epoch;
+	}
+
+	/*If this fails someone else advanced and the epoch is already up to date*/
+	AK_Atomic_Compare_Exchange_Strong_U64(&AK_Epoch__Global, &Epoch, Epoch+1, AK_ATOMIC_MEMORY_ORDER_ACQ_REL);
+	return AK_Atomic_Load_U64(&AK_Epoch__Global, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+}
+
+static uint64_t AK_Epoch__Collect(ak_epoch__record* Record) {
+	ak_reclaim__orphan* Orphan;
+	uint64_t Epoch = AK_Epoch__Try_Advance();
+	uint32_t i;
+
+	/*Nothing retired in epoch e can be reached by a critical section once the global epoch reached
+	  e+2*/
+	Record->PendingCount = 0;
+	for(i = 0; i < AK_EPOCH__BUCKET_COUNT; i++) {
+		if(Record->BucketEpochs[i]+2 <= Epoch) AK_Reclaim__List_Run(&Record->Buckets[i]);
+		Record->PendingCount += Record->Buckets[i].Count;
+	}
+
+	Orphan = (ak_reclaim__orphan*)AK_Atomic_Exchange_Ptr(&AK_Epoch__Orphans, NULL, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Orphan) {
+		ak_reclaim__orphan* Next = Orphan->Next;
+		if(Orphan->Epoch+2 <= Epoch) {
+			AK_Reclaim__List_Run(&Orphan->List);
+			AK_Reclaim__Delete_Orphan(Orphan);
+		} else {
+			void* Head = AK_Atomic_Load_Ptr(&AK_Epoch__Orphans, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			do {
+				Orphan->Next = (ak_reclaim__orphan*)Head;
+			} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(&AK_Epoch__Orphans, &Head, Orphan, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+		}
+		Orphan = Next;
+	}
+
+	/*A long critical section can hold the epoch back, so back off instead of trying to advance on
+	  every retire*/
+	Record->NextCollect = Record->PendingCount+AK_EPOCH_RETIRE_THRESHOLD;
+	return Epoch;
+}
+
+AKATOMICDEF void AK_Epoch_Enter(void) {
+	ak_epoch__record* Record = AK_Epoch__Get_Record();
+	uint64_t Epoch;
+	if(Record->NestCount++) return;
+
+	Epoch = AK_Atomic_Load_U64(&AK_Epoch__Global, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U64(&Record->Announced.Value, (Epoch << 1) | 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	/*The announcement has to be visible before any shared pointer is loaded*/
+	AK_Atomic_Fence_Light();
+}
+
+AKATOMICDEF void AK_Epoch_Exit(void) {
+	ak_epoch__record* Record = AK_Epoch__Thread_Record;
+	AK_ATOMIC_ASSERT(Record && Record->NestCount);
+	if(--Record->NestCount) return;
+	AK_Atomic_Store_U64(&Record->Announced.Value, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF void AK_Epoch_Retire(void* Pointer, ak_reclaim_callback_func* Callback) {
+	ak_epoch__record* Record = AK_Epoch__Get_Record();
+	/*Loaded after the pointer got unlinked, so only critical sections that announced this epoch or
+	  the one before it can still see the pointer*/
+	uint64_t Epoch = AK_Atomic_Load_U64(&AK_Epoch__Global, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+	uint32_t Index = (uint32_t)(Epoch % AK_EPOCH__BUCKET_COUNT);
+	ak_reclaim__list* Bucket = &Record->Buckets[Index];
+
+	/*The bucket still holds pointers from three or more epochs ago which are all safe*/
+	if(Record->BucketEpochs[Index] != Epoch) {
+		Record->PendingCount -= Bucket->Count;
+		AK_Reclaim__List_Run(Bucket);
+		Record->BucketEpochs[Index] = Epoch;
+	}
+
+	/*Without memory to defer the free the pointer leaks, freeing it could crash a reader*/
+	if(!AK_Reclaim__List_Push(Bucket, Pointer, Callback)) return;
+	Record->PendingCount++;
+	if(Record->PendingCount >= Record->NextCollect) AK_Epoch__Collect(Record);
+}
+
+AKATOMICDEF uint64_t AK_Epoch_Collect(void) {
+	return AK_Epoch__Collect(AK_Epoch__Get_Record());
+}
+
+AKATOMICDEF void AK_Epoch_Thread_Exit(void) {
+	ak_epoch__record* Record = AK_Epoch__Thread_Record;
+	uint32_t i;
+	if(!Record) return;
+	AK_ATOMIC_ASSERT(!Record->NestCount);
+
+	AK_Epoch__Collect(Record);
+	for(i = 0; i < AK_EPOCH__BUCKET_COUNT; i++) {
+		AK_Reclaim__Push_Orphan(&AK_Epoch__Orphans, &Record->Buckets[i], Record->BucketEpochs[i]);
+	}
+	Record->PendingCount = 0;
+	Record->NextCollect = AK_EPOCH_RETIRE_THRESHOLD;
+
+	AK_Epoch__Thread_Record = NULL;
+	AK_Reclaim__Release_Record(&Record->Header);
+}
+
+/*Quiescent state based rcu*/
+
+/*Counter is GracePeriod*2+1 for the last grace period the thread passed a quiescent state in 
+  while online and 0 while offline. Current collects calls for the next grace period while Waiting
+  waits for WaitingGracePeriod to finish*/
+typedef struct ak_rcu__record ak_rcu__record;
+struct ak_rcu__record {
+	ak_reclaim__record 	 Header;
+	ak_atomic_u64_padded Counter;
+	ak_reclaim__list 	 Current;
+	ak_reclaim__list 	 Waiting;
+	uint64_t 			 WaitingGracePeriod;
+};
+
+static ak_atomic_u64 AK_RCU__Grace_Period;
+static ak_atomic_ptr AK_RCU__Records;
+static ak_atomic_ptr AK_RCU__Orphans;
+static AK_ATOMIC__THREAD_LOCAL ak_rcu__record* AK_RCU__Thread_Record;
+
+static ak_rcu__record* AK_RCU__Get_Record(void) {
+	ak_rcu__record* Record = AK_RCU__Thread_Record;
+	int8_t IsNew;
+	if(Record) return Record;
+
+	Record = (ak_rcu__record*)AK_Reclaim__Acquire_Record(&AK_RCU__Records, sizeof(ak_rcu__record), &IsNew);
+	if(!Record) return NULL;
+
+	AK_RCU__Thread_Record = Record;
+	return Record;
+}
+
+static int8_t AK_RCU__Is_Behind(uint64_t Counter, uint64_t GracePeriod) {
+	return (Counter & 1) && (Counter >> 1) < GracePeriod;
+}
+
+/*Starts a new grace period. It finishes once every online thread announced it*/
+static uint64_t AK_RCU__Start_Grace_Period(void) {
+	uint64_t GracePeriod = AK_Atomic_Fetch_Add_U64(&AK_RCU__Grace_Period, 1, AK_ATOMIC_MEMORY_ORDER_SEQ_CST)+1;
+	
+	/*Pairs with the light fence in online. A thread that came online concurrently either has its 
+	  counter visible here or sees every pointer unlinked before the grace period started*/
+	AK_Atomic_Fence_Heavy();
+	return GracePeriod;
+}
+
+static int8_t AK_RCU__Has_Finished(uint64_t GracePeriod) {
+	ak_rcu__record* Record;
+	for(Record = (ak_rcu__record*)AK_Atomic_Load_Ptr(&AK_RCU__Records, AK_ATOMIC_MEMORY_ORDER_ACQUIRE); Record; Record = (ak_rcu__record*)Record->Header.Next) {
+		if(AK_RCU__Is_Behind(AK_Atomic_Load_U64(&Record->Counter.Value, AK_ATOMIC_MEMORY_ORDER_ACQUIRE), GracePeriod)) {
+			return ak_atomic_false;
+		}
+	}
+	return ak_atomic_true;
+}
+
+static void AK_RCU__Reclaim_Orphans(void) {
+	ak_reclaim__orphan* Orphan = (ak_reclaim__orphan*)AK_Atomic_Exchange_Ptr(&AK_RCU__Orphans, NULL, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Orphan) {
+		ak_reclaim__orphan* Next = Orphan->Next;
+		if(AK_RCU__Has_Finished(Orphan->Epoch)) {
+			AK_Reclaim__List_Run(&Orphan->List);
+			AK_Reclaim__Delete_Orphan(Orphan);
+		} else {
+			void* Head = AK_Atomic_Load_Ptr(&AK_RCU__Orphans, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			do {
+				Orphan->Next = (ak_reclaim__orphan*)Head;
+			} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(&AK_RCU__Orphans, &Head, Orphan, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+		}
+		Orphan = Next;
+	}
+}
+
+/*Frees the waiting batch if its grace period finished and starts one for the current batch*/
+static void AK_RCU__Advance(ak_rcu__record* Record) {
+	if(Record->Waiting.Count) {
+		if(!AK_RCU__Has_Finished(Record->WaitingGracePeriod)) return;
+		AK_Reclaim__List_Run(&Record->Waiting);
+	}
+
+	if(Record->Current.Count) {
+		ak_reclaim__list Temp = Record->Waiting;
+		Record->Waiting = Record->Current;
+		Record->Current = Temp;
+		Record->WaitingGracePeriod = AK_RCU__Start_Grace_Period();
+	}
+	AK_RCU__Reclaim_Orphans();
+}
+
+/*Announces the latest grace period. Every pointer loaded before is no longer in use and loads
+  after it see everything unlinked before the grace period started*/
+static void AK_RCU__Quiescent_State(ak_rcu__record* Record) {
+	uint64_t GracePeriod = AK_Atomic_Load_U64(&AK_RCU__Grace_Period, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	AK_Atomic_Store_U64(&Record->Counter.Value, (GracePeriod << 1) | 1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF void AK_RCU_Thread_Online(void) {
+	ak_rcu__record* Record = AK_RCU__Get_Record();
+	AK_RCU__Quiescent_State(Record);
+	/*The counter has to be visible before any shared pointer is loaded*/
+	AK_Atomic_Fence_Light();
+}
+
+AKATOMICDEF void AK_RCU_Thread_Offline(void) {
+	ak_rcu__record* Record = AK_RCU__Get_Record();
+	AK_Atomic_Store_U64(&Record->Counter.Value, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF void AK_RCU_Quiescent_State(void) {
+	ak_rcu__record* Record = AK_RCU__Get_Record();
+	AK_ATOMIC_ASSERT(AK_Atomic_Load_U64(&Record->Counter.Value, AK_ATOMIC_MEMORY_ORDER_RELAXED) & 1);
+	AK_RCU__Quiescent_State(Record);
+	if(Record->Waiting.Count) AK_RCU__Advance(Record);
+}
+
+AKATOMICDEF void* AK_RCU_Dereference(ak_atomic_ptr* Pointer) {
+	return AK_Atomic_Load_Ptr(Pointer, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+}
+
+AKATOMICDEF void AK_RCU_Assign(ak_atomic_ptr* Pointer, void* Value) {
+	AK_Atomic_Store_Ptr(Pointer, Value, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF void AK_RCU_Synchronize(void) {
+	ak_rcu__record* Record = AK_RCU__Get_Record();
+	ak_rcu__record* Other;
+	uint64_t GracePeriod;
+	int8_t IsOnline = (int8_t)(AK_Atomic_Load_U64(&Record->Counter.Value, AK_ATOMIC_MEMORY_ORDER_RELAXED) & 1);
+
+	/*The caller can't hold rcu pointers across a synchronize, so it doesn't wait on itself*/
+	GracePeriod = AK_RCU__Start_Grace_Period();
+	if(IsOnline) AK_RCU__Quiescent_State(Record);
+
+	for(Other = (ak_rcu__record*)AK_Atomic_Load_Ptr(&AK_RCU__Records, AK_ATOMIC_MEMORY_ORDER_ACQUIRE); Other; Other = (ak_rcu__record*)Other->Header.Next) {
+		uint32_t SpinCount = 0;
+		while(AK_RCU__Is_Behind(AK_Atomic_Load_U64(&Other->Counter.Value, AK_ATOMIC_MEMORY_ORDER_ACQUIRE), GracePeriod)) {
+			if(++SpinCount < 64) {
+				AK_ATOMIC__SPIN_PAUSE();
+			} else {
+				AK_Thread_Yield();
+			}
+		}
+	}
+
+	/*Everything retired by this thread so far is covered by the grace period we just waited on*/
+	AK_Reclaim__List_Run(&Record->Waiting);
+	AK_Reclaim__List_Run(&Record->Current);
+	AK_RCU__Reclaim_Orphans();
+}
+
+AKATOMICDEF void AK_RCU_Call(void* Pointer, ak_reclaim_callback_func* Callback) {
+	ak_rcu__record* Record = AK_RCU__Get_Record();
+
+	/*Without memory to defer the free we have to wait for the readers*/
+	if(!AK_Reclaim__List_Push(&Record->Current, Pointer, Callback)) {
+		AK_RCU_Synchronize();
+		Callback(Pointer);
+		return;
+	}
+
+	if(Record->Current.Count >= AK_RCU_CALL_THRESHOLD) {
+		AK_RCU__Advance(Record);
+		/*Readers that never pass a quiescent state would make the batches grow without bound*/
+		if(Record->Current.Count >= AK_RCU_CALL_THRESHOLD*8) AK_RCU_Synchronize();
+	}
+}
+
+AKATOMICDEF void AK_RCU_Thread_Exit(void) {
+	ak_rcu__record* Record = AK_RCU__Thread_Record;
+	uint64_t GracePeriod;
+	if(!Record) return;
+
+	AK_Atomic_Store_U64(&Record->Counter.Value, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	AK_RCU__Advance(Record);
+
+	/*Whatever is left is freed by the next thread that sees a newer grace period finish*/
+	GracePeriod = AK_RCU__Start_Grace_Period();
+	AK_Reclaim__List_Append(&Record->Waiting, &Record->Current);
+	AK_Reclaim__Push_Orphan(&AK_RCU__Orphans, &Record->Waiting, GracePeriod);
+
+	AK_RCU__Thread_Record = NULL;
+	AK_Reclaim__Release_Record(&Record->Header);
+}
+
+/*Hash and bit helpers*/
+#ifdef AK_ATOMIC_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+/*Finalizer of splitmix64, sequential keys end up spread over the whole table*/
+static uint64_t AK_Atomic__Hash_U64(uint64_t Key) {
+	Key = (Key ^ (Key >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Key = (Key ^ (Key >> 27)) * 0x94D049BB133111EBull;
+	return Key ^ (Key >> 31);
+}
+
+/*Value must not be 0*/
+static uint32_t AK_Atomic__Count_Trailing_Zeros_U32(uint32_t Value) {
+#if defined(AK_ATOMIC_COMPILER_MSVC)
+	unsigned long Index;
+	_BitScanForward(&Index, Value);
+	return (uint32_t)Index;
+#else
+	return (uint32_t)__builtin_ctz(Value);
+#endif
+}
+
+/*Value must not be 0*/
+static uint32_t AK_Atomic__Count_Trailing_Zeros_U64(uint64_t Value) {
+#if defined(AK_ATOMIC_COMPILER_MSVC) && defined(AK_ATOMIC_CPU_X64)
+	unsigned long Index;
+	_BitScanForward64(&Index, Value);
+	return (uint32_t)Index;
+#elif defined(AK_ATOMIC_COMPILER_MSVC)
+	if((uint32_t)Value) return AK_Atomic__Count_Trailing_Zeros_U32((uint32_t)Value);
+	return 32+AK_Atomic__Count_Trailing_Zeros_U32((uint32_t)(Value >> 32));
+#else
+	return (uint32_t)__builtin_ctzll(Value);
+#endif
+}
+
+/*Lock free hash map*/
+
+/*A slot that is being migrated has the prime bit set on its value. Once the value is copied into 
+  the next table (or there was nothing to copy) the value becomes moved and the slot is dead*/
+#define AK_LF_HASHMAP__PRIME (1ull << 63)
+#define AK_LF_HASHMAP__MOVED (AK_LF_HASHMAP__PRIME | AK_LF_HASHMAP_TOMBSTONE)
+#define AK_LF_HASHMAP__MIN_CAPACITY 16
+#define AK_LF_HASHMAP__MIGRATE_CHUNK 1024
+
+typedef enum {
+	AK_LF_HASHMAP__WRITE_PUT,
+	AK_LF_HASHMAP__WRITE_INSERT,
+	AK_LF_HASHMAP__WRITE_REMOVE
+} ak_lf_hashmap__write_mode;
+
+/*Cells follow the header as key/value pairs. Next is set once when a resize starts*/
+typedef struct ak_lf_hashmap__table ak_lf_hashmap__table;
+struct ak_lf_hashmap__table {
+	uint64_t 	  Capacity;
+	ak_atomic_ptr Next;
+	ak_atomic_u64 ClaimCount;
+	ak_atomic_u64 MigrateIndex;
+	ak_atomic_u64 MigratedCount;
+};
+
+static ak_atomic_u64* AK_LF_Hashmap__Cells(ak_lf_hashmap__table* Table) {
+	return (ak_atomic_u64*)(Table+1);
+}
+
+static size_t AK_LF_Hashmap__Table_Size(uint64_t Capacity) {
+	return sizeof(ak_lf_hashmap__table)+(size_t)(sizeof(ak_atomic_u64)*2*Capacity);
+}
+
+static ak_lf_hashmap__table* AK_LF_Hashmap__Allocate_Table(uint64_t Capacity) {
+	size_t Size = AK_LF_Hashmap__Table_Size(Capacity);
+	ak_lf_hashmap__table* Table = (ak_lf_hashmap__table*)AK_Atomic__Large_Allocate(Size);
+	AK_ATOMIC_ASSERT(Table);
+	if(!Table) return NULL;
+	AK_ATOMIC_MEMORY_CLEAR(Table, Size);
+	Table->Capacity = Capacity;
+	return Table;
+}
+
+static void AK_LF_Hashmap__Delete_Table(ak_lf_hashmap__table* Table) {
+	AK_Atomic__Large_Free(Table, AK_LF_Hashmap__Table_Size(Table->Capacity));
+}
+
+static AK_RECLAIM_CALLBACK_DEFINE(AK_LF_Hashmap__Free_Table) {
+	AK_LF_Hashmap__Delete_Table((ak_lf_hashmap__table*)Pointer);
+}
+
+static int8_t AK_LF_Hashmap__Is_Live(uint64_t Value) {
+	return Value != 0 && Value < AK_LF_HASHMAP_TOMBSTONE;
+}
+
+/*Copies a live value into the next table unless the key already has a value there. Only the copy
+  of the old slot can have written the key so far, since writers finish the copy before they move 
+  on to the next table*/
+static void AK_LF_Hashmap__Copy_Into(ak_lf_hashmap__table* Table, uint64_t Key, uint64_t Value) {
+	ak_atomic_u64* Cells = AK_LF_Hashmap__Cells(Table);
+	uint64_t Mask = Table->Capacity-1;
+	uint64_t i, Index = AK_Atomic__Hash_U64(Key) & Mask;
+
+	for(i = 0; i < Table->Capacity; i++, Index = (Index+1) & Mask) {
+		uint64_t SlotKey = AK_Atomic_Load_U64(&Cells[Index*2], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		if(SlotKey == 0) {
+			if(AK_Atomic_Compare_Exchange_Strong_U64(&Cells[Index*2], &SlotKey, Key, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+				AK_Atomic_Increment_U64(&Table->ClaimCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				SlotKey = Key;
+			}
+		}
+
+		if(SlotKey == Key) {
+			uint64_t Expected = 0;
+			AK_Atomic_Compare_Exchange_Strong_U64(&Cells[Index*2+1], &Expected, Value, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+			return;
+		}
+	}
+
+	/*The next table is sized so the migration always fits*/
+	AK_ATOMIC_ASSERT(!"Hashmap table is full during migration");
+}
+
+static void AK_LF_Hashmap__Copy_Slot(ak_lf_hashmap__table* Table, uint64_t Index) {
+	ak_atomic_u64* Cells = AK_LF_Hashmap__Cells(Table);
+	uint64_t Value = AK_Atomic_Load_U64(&Cells[Index*2+1], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+
+	/*Freeze the slot first so no writer can change the value while it is copied*/
+	while(!(Value & AK_LF_HASHMAP__PRIME)) {
+		uint64_t NewValue = AK_LF_Hashmap__Is_Live(Value) ? (Value | AK_LF_HASHMAP__PRIME) : AK_LF_HASHMAP__MOVED;
+		if(AK_Atomic_Compare_Exchange_Weak_U64(&Cells[Index*2+1], &Value, NewValue, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+			Value = NewValue;
+		}
+	}
+
+	if(Value != AK_LF_HASHMAP__MOVED) {
+		uint64_t Key = AK_Atomic_Load_U64(&Cells[Index*2], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		ak_lf_hashmap__table* Next = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		AK_LF_Hashmap__Copy_Into(Next, Key, Value & ~AK_LF_HASHMAP__PRIME);
+		AK_Atomic_Compare_Exchange_Strong_U64(&Cells[Index*2+1], &Value, AK_LF_HASHMAP__MOVED, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	}
+}
+
+static void AK_LF_Hashmap__Finish_Migration(ak_lf_hashmap* Map, ak_lf_hashmap__table* Table) {
+	void* Expected = Table;
+	void* Next = AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(AK_Atomic_Compare_Exchange_Strong_Ptr(&Map->Table, &Expected, Next, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+		AK_Epoch_Retire(Table, AK_LF_Hashmap__Free_Table);
+	}
+}
+
+/*Migrates the next unclaimed chunk of slots. Returns false once every chunk has been claimed*/
+static int8_t AK_LF_Hashmap__Help_Migrate(ak_lf_hashmap* Map, ak_lf_hashmap__table* Table) {
+	uint64_t i, Start, End;
+	if(AK_Atomic_Load_U64(&Table->MigrateIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED) >= Table->Capacity) return ak_atomic_false;
+
+	Start = AK_Atomic_Fetch_Add_U64(&Table->MigrateIndex, AK_LF_HASHMAP__MIGRATE_CHUNK, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(Start >= Table->Capacity) return ak_atomic_false;
+	End = Start+AK_LF_HASHMAP__MIGRATE_CHUNK;
+	if(End > Table->Capacity) End = Table->Capacity;
+
+	for(i = Start; i < End; i++) AK_LF_Hashmap__Copy_Slot(Table, i);
+	if(AK_Atomic_Fetch_Add_U64(&Table->MigratedCount, End-Start, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)+(End-Start) == Table->Capacity) {
+		AK_LF_Hashmap__Finish_Migration(Map, Table);
+	}
+	return ak_atomic_true;
+}
+
+/*Used when a thread can't make progress until the migration is done. Once every chunk is claimed 
+  we copy every slot ourselves instead of waiting on the threads that claimed them*/
+static void AK_LF_Hashmap__Complete_Migration(ak_lf_hashmap* Map, ak_lf_hashmap__table* Table) {
+	uint64_t i;
+	while(AK_LF_Hashmap__Help_Migrate(Map, Table)) {}
+	if(AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != Table) return;
+	for(i = 0; i < Table->Capacity; i++) AK_LF_Hashmap__Copy_Slot(Table, i);
+	AK_LF_Hashmap__Finish_Migration(Map, Table);
+}
+
+/*Removed keys still hold their claimed slots, so a table mostly full of tombstones is copied into 
+  a table of the same size instead, the migration drops them. Either way a migration uses at most 
+  half of the next table, unless tombstoned keys get written again faster than the migration 
+  freezes them. Writers stop adding new keys to it at a quarter, which leaves room for threads 
+  that raced past the check*/
+static int8_t AK_LF_Hashmap__Start_Resize(ak_lf_hashmap* Map, ak_lf_hashmap__table* Table) {
+	void* Expected = NULL;
+	ak_lf_hashmap__table* Next;
+	uint64_t Capacity = Table->Capacity;
+	if(AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) return ak_atomic_true;
+
+	if(AK_Atomic_Load_U64(&Map->Size, AK_ATOMIC_MEMORY_ORDER_RELAXED)*4 >= Capacity) Capacity *= 2;
+	Next = AK_LF_Hashmap__Allocate_Table(Capacity);
+	if(!Next) return ak_atomic_false;
+	if(!AK_Atomic_Compare_Exchange_Strong_Ptr(&Table->Next, &Expected, Next, AK_ATOMIC_MEMORY_ORDER_SEQ_CST)) {
+		AK_LF_Hashmap__Delete_Table(Next);
+	}
+	return ak_atomic_true;
+}
+
+static uint64_t AK_LF_Hashmap__Write(ak_lf_hashmap* Map, uint64_t Key, uint64_t Value, ak_lf_hashmap__write_mode Mode) {
+	ak_lf_hashmap__table* Table;
+	uint64_t Result = 0;
+	AK_ATOMIC_ASSERT(Key != 0);
+	AK_ATOMIC_ASSERT(Mode == AK_LF_HASHMAP__WRITE_REMOVE || AK_LF_Hashmap__Is_Live(Value));
+
+	AK_Epoch_Enter();
+	Table = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	for(;;) {
+		ak_atomic_u64* Cells = AK_LF_Hashmap__Cells(Table);
+		ak_lf_hashmap__table* Next = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		int8_t IsHead = AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == Table;
+		int8_t IsFound = ak_atomic_false;
+		uint64_t Mask = Table->Capacity-1;
+		uint64_t i, Index = AK_Atomic__Hash_U64(Key) & Mask;
+		uint64_t SlotValue;
+
+		/*Pairs with the check after claiming a slot, the fence orders our probe after seeing Next*/
+		if(Next) {
+			AK_Atomic_Fence_Seq_Cst();
+			AK_LF_Hashmap__Help_Migrate(Map, Table);
+		}
+
+		for(i = 0; i < Table->Capacity; i++, Index = (Index+1) & Mask) {
+			uint64_t SlotKey = AK_Atomic_Load_U64(&Cells[Index*2], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(SlotKey == 0) {
+				uint64_t ClaimCount = AK_Atomic_Load_U64(&Table->ClaimCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				uint64_t MaxClaimCount = IsHead ? Table->Capacity/4*3 : Table->Capacity/4;
+				
+				/*New keys never go into a table that is being migrated*/
+				if(Next || Mode == AK_LF_HASHMAP__WRITE_REMOVE || ClaimCount >= MaxClaimCount) break;
+				if(AK_Atomic_Compare_Exchange_Strong_U64(&Cells[Index*2], &SlotKey, Key, AK_ATOMIC_MEMORY_ORDER_SEQ_CST)) {
+					AK_Atomic_Increment_U64(&Table->ClaimCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+					IsFound = ak_atomic_true;
+					break;
+				}
+			}
+
+			if(SlotKey == Key) {
+				IsFound = ak_atomic_true;
+				break;
+			}
+		}
+
+		if(!IsFound) {
+			if(Next) {
+				Table = Next;
+			} else if(Mode == AK_LF_HASHMAP__WRITE_REMOVE) {
+				break;
+			} else if(IsHead) {
+				if(!AK_LF_Hashmap__Start_Resize(Map, Table)) break;
+			} else {
+				/*The next table filled up before the migration into it finished*/
+				ak_lf_hashmap__table* Head = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+				if(Head != Table) AK_LF_Hashmap__Complete_Migration(Map, Head);
+				Table = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			}
+			continue;
+		}
+
+		/*A resize may have started after we loaded Next, and a writer that saw it could already have
+		  put the key into the next table if our key was claimed after its probe. Once a resize runs 
+		  values only go into the next table, so freeze the slot and move on like a write that hit 
+		  a migrating slot. Both sides are sequentially consistent, so either we see Next here or 
+		  the other writer sees the claimed key*/
+		if(!Next) Next = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+		if(Next) {
+			AK_LF_Hashmap__Copy_Slot(Table, Index);
+			Table = Next;
+			continue;
+		}
+
+		SlotValue = AK_Atomic_Load_U64(&Cells[Index*2+1], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		for(;;) {
+			uint64_t NewValue;
+			if(SlotValue & AK_LF_HASHMAP__PRIME) break;
+			if(Mode == AK_LF_HASHMAP__WRITE_INSERT && AK_LF_Hashmap__Is_Live(SlotValue)) break;
+			if(Mode == AK_LF_HASHMAP__WRITE_REMOVE && !AK_LF_Hashmap__Is_Live(SlotValue)) break;
+
+			NewValue = Mode == AK_LF_HASHMAP__WRITE_REMOVE ? AK_LF_HASHMAP_TOMBSTONE : Value;
+			if(AK_Atomic_Compare_Exchange_Weak_U64(&Cells[Index*2+1], &SlotValue, NewValue, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+				if(!AK_LF_Hashmap__Is_Live(SlotValue)) {
+					AK_Atomic_Increment_U64(&Map->Size, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				} else if(Mode == AK_LF_HASHMAP__WRITE_REMOVE) {
+					AK_Atomic_Decrement_U64(&Map->Size, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				}
+				break;
+			}
+		}
+
+		/*The slot is being migrated, finish its copy and retry in the next table*/
+		if(SlotValue & AK_LF_HASHMAP__PRIME) {
+			AK_LF_Hashmap__Copy_Slot(Table, Index);
+			Table = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			continue;
+		}
+
+		Result = AK_LF_Hashmap__Is_Live(SlotValue) ? SlotValue : 0;
+		break;
+	}
+	AK_Epoch_Exit();
+	return Result;
+}
+
+AKATOMICDEF int8_t AK_LF_Hashmap_Create(ak_lf_hashmap* Map, uint32_t InitialCapacity) {
+	uint64_t Capacity = AK_LF_HASHMAP__MIN_CAPACITY;
+	ak_lf_hashmap__table* Table;
+	
+	/*Keep the initial capacity under the load factor*/
+	while(Capacity/4*3 < InitialCapacity) Capacity *= 2;
+	Table = AK_LF_Hashmap__Allocate_Table(Capacity);
+	if(!Table) return ak_atomic_false;
+
+	AK_Atomic_Store_Ptr(&Map->Table, Table, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U64(&Map->Size, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_LF_Hashmap_Delete(ak_lf_hashmap* Map) {
+	ak_lf_hashmap__table* Table = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(Table) {
+		ak_lf_hashmap__table* Next = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		if(Next) AK_LF_Hashmap__Delete_Table(Next);
+		AK_LF_Hashmap__Delete_Table(Table);
+	}
+	AK_ATOMIC_MEMORY_CLEAR(Map, sizeof(ak_lf_hashmap));
+}
+
+AKATOMICDEF uint64_t AK_LF_Hashmap_Get(ak_lf_hashmap* Map, uint64_t Key) {
+	ak_lf_hashmap__table* Table;
+	uint64_t Result = 0;
+	AK_ATOMIC_ASSERT(Key != 0);
+
+	AK_Epoch_Enter();
+	Table = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Map->Table, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Table) {
+		ak_atomic_u64* Cells = AK_LF_Hashmap__Cells(Table);
+		uint64_t Mask = Table->Capacity-1;
+		uint64_t i, Index = AK_Atomic__Hash_U64(Key) & Mask;
+		int8_t IsFound = ak_atomic_false;
+		
+		for(i = 0; i < Table->Capacity; i++, Index = (Index+1) & Mask) {
+			uint64_t SlotKey = AK_Atomic_Load_U64(&Cells[Index*2], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(SlotKey == 0) break;
+			if(SlotKey == Key) {
+				IsFound = ak_atomic_true;
+				break;
+			}
+		}
+
+		if(IsFound) {
+			uint64_t Value = AK_Atomic_Load_U64(&Cells[Index*2+1], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(!(Value & AK_LF_HASHMAP__PRIME)) {
+				Result = AK_LF_Hashmap__Is_Live(Value) ? Value : 0;
+				break;
+			}
+			AK_LF_Hashmap__Copy_Slot(Table, Index);
+		}
+
+		/*Not in this table, but it may have been inserted into the one we are migrating to*/
+		Table = (ak_lf_hashmap__table*)AK_Atomic_Load_Ptr(&Table->Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	}
+	AK_Epoch_Exit();
+	return Result;
+}
+
+AKATOMICDEF uint64_t AK_LF_Hashmap_Put(ak_lf_hashmap* Map, uint64_t Key, uint64_t Value) {
+	return AK_LF_Hashmap__Write(Map, Key, Value, AK_LF_HASHMAP__WRITE_PUT);
+}
+
+AKATOMICDEF uint64_t AK_LF_Hashmap_Insert(ak_lf_hashmap* Map, uint64_t Key, uint64_t Value) {
+	return AK_LF_Hashmap__Write(Map, Key, Value, AK_LF_HASHMAP__WRITE_INSERT);
+}
+
+AKATOMICDEF uint64_t AK_LF_Hashmap_Remove(ak_lf_hashmap* Map, uint64_t Key) {
+	return AK_LF_Hashmap__Write(Map, Key, 0, AK_LF_HASHMAP__WRITE_REMOVE);
+}
+
+AKATOMICDEF uint64_t AK_LF_Hashmap_Size(ak_lf_hashmap* Map) {
+	return AK_Atomic_Load_U64(&Map->Size, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+/*Concurrent swiss table set*/
+#ifdef AK_ATOMIC_SSE2
+#include <emmintrin.h>
+#endif
+
+/*Full slots store the low 7 bits of the hash, free slots have the high bit set*/
+#define AK_SWISS_SET__EMPTY 0x80
+#define AK_SWISS_SET__DELETED 0xFE
+#define AK_SWISS_SET__GROUP_SIZE 16
+
+/*Version is odd while a writer modifies the group. Control and keys are only written with the 
+  lock held and the version odd*/
+struct ak_swiss_set__group {
+	ak_atomic_u32 Version;
+	ak_atomic_u8  Lock;
+	uint8_t 	  Padding[11];
+	uint8_t 	  Control[AK_SWISS_SET__GROUP_SIZE];
+	ak_atomic_u64 Keys[AK_SWISS_SET__GROUP_SIZE];
+};
+
+/*Bit i is set when control byte i equals Byte*/
+static uint32_t AK_Swiss_Set__Match(const uint8_t* Control, uint8_t Byte) {
+#ifdef AK_ATOMIC_SSE2
+	__m128i Group = _mm_loadu_si128((const __m128i*)Control);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Group, _mm_set1_epi8((char)Byte)));
+#else
+	uint32_t i, Result = 0;
+	for(i = 0; i < AK_SWISS_SET__GROUP_SIZE; i++) {
+		if(Control[i] == Byte) Result |= 1u << i;
+	}
+	return Result;
+#endif
+}
+
+/*Bit i is set when slot i is empty or deleted*/
+static uint32_t AK_Swiss_Set__Match_Free(const uint8_t* Control) {
+#ifdef AK_ATOMIC_SSE2
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)Control));
+#else
+	uint32_t i, Result = 0;
+	for(i = 0; i < AK_SWISS_SET__GROUP_SIZE; i++) {
+		if(Control[i] & 0x80) Result |= 1u << i;
+	}
+	return Result;
+#endif
+}
+
+/*A purge holds every lock for a while, so waiters yield after spinning for some time*/
+static void AK_Swiss_Set__Spin(uint32_t* SpinCount) {
+	if(++*SpinCount < 64) {
+		AK_ATOMIC__SPIN_PAUSE();
+	} else {
+		AK_Thread_Yield();
+	}
+}
+
+static void AK_Swiss_Set__Lock(ak_swiss_set__group* Group) {
+	uint32_t SpinCount = 0;
+	for(;;) {
+		if(!AK_Atomic_Exchange_U8(&Group->Lock, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) return;
+		while(AK_Atomic_Load_U8(&Group->Lock, AK_ATOMIC_MEMORY_ORDER_RELAXED)) AK_Swiss_Set__Spin(&SpinCount);
+	}
+}
+
+static void AK_Swiss_Set__Unlock(ak_swiss_set__group* Group) {
+	AK_Atomic_Store_U8(&Group->Lock, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/*Readers have to see the odd version before any of the writes to the group*/
+static void AK_Swiss_Set__Begin_Write(ak_swiss_set__group* Group) {
+	uint32_t Version = AK_Atomic_Load_U32(&Group->Version, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Group->Version, Version+1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Fence_Release();
+}
+
+static void AK_Swiss_Set__End_Write(ak_swiss_set__group* Group) {
+	uint32_t Version = AK_Atomic_Load_U32(&Group->Version, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Group->Version, Version+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/*Only called with the lock held. Returns the slot of the key or AK_SWISS_SET__GROUP_SIZE*/
+static uint32_t AK_Swiss_Set__Find_Locked(ak_swiss_set__group* Group, uint64_t Key, uint8_t Tag) {
+	uint32_t Matches = AK_Swiss_Set__Match(Group->Control, Tag);
+	while(Matches) {
+		uint32_t Slot = AK_Atomic__Count_Trailing_Zeros_U32(Matches);
+		if(AK_Atomic_Load_U64(&Group->Keys[Slot], AK_ATOMIC_MEMORY_ORDER_RELAXED) == Key) return Slot;
+		Matches &= Matches-1;
+	}
+	return AK_SWISS_SET__GROUP_SIZE;
+}
+
+/*Generation is odd while a purge rehashes the set. Probes that span a purge have to restart since 
+  keys may have moved to groups they already passed*/
+static uint32_t AK_Swiss_Set__Wait_Generation(ak_swiss_set* Set) {
+	uint32_t Generation, SpinCount = 0;
+	while((Generation = AK_Atomic_Load_U32(&Set->Generation, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) & 1) {
+		AK_Swiss_Set__Spin(&SpinCount);
+	}
+	return Generation;
+}
+
+/*Locks every group in index order, which can't deadlock since other writers hold at most one lock,
+  and reinserts every key into a cleared set. Only one purge runs at a time, everyone else waits for 
+  it to finish. MinDeleted is checked again with the locks held since the set may have been purged 
+  between the caller's check and taking the locks*/
+static void AK_Swiss_Set__Purge(ak_swiss_set* Set, uint64_t MinDeleted) {
+	uint64_t i, KeyCount = 0, GroupCount = Set->GroupMask+1;
+	uint64_t* Keys = NULL;
+
+	if(AK_Atomic_Exchange_U32(&Set->IsPurging, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+		uint32_t SpinCount = 0;
+		while(AK_Atomic_Load_U32(&Set->IsPurging, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) AK_Swiss_Set__Spin(&SpinCount);
+		return;
+	}
+
+	for(i = 0; i < GroupCount; i++) AK_Swiss_Set__Lock(Set->Groups + i);
+	if(AK_Atomic_Load_U64(&Set->Deleted, AK_ATOMIC_MEMORY_ORDER_RELAXED) >= MinDeleted) {
+		for(i = 0; i < GroupCount; i++) {
+			uint32_t j;
+			for(j = 0; j < AK_SWISS_SET__GROUP_SIZE; j++) KeyCount += !(Set->Groups[i].Control[j] & 0x80);
+		}
+		/*Without the memory the tombstones just stay*/
+		Keys = KeyCount ? (uint64_t*)AK_Atomic__Large_Allocate((size_t)(sizeof(uint64_t)*KeyCount)) : NULL;
+	}
+
+	if(Keys || (!KeyCount && AK_Atomic_Load_U64(&Set->Deleted, AK_ATOMIC_MEMORY_ORDER_RELAXED) >= MinDeleted)) {
+		uint64_t k = 0;
+		AK_Atomic_Store_U32(&Set->Generation, AK_Atomic_Load_U32(&Set->Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED)+1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Fence_Release();
+		for(i = 0; i < GroupCount; i++) {
+			ak_swiss_set__group* Group = Set->Groups + i;
+			uint32_t j;
+			AK_Swiss_Set__Begin_Write(Group);
+			for(j = 0; j < AK_SWISS_SET__GROUP_SIZE; j++) {
+				if(!(Group->Control[j] & 0x80)) Keys[k++] = AK_Atomic_Load_U64(&Group->Keys[j], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				Group->Control[j] = AK_SWISS_SET__EMPTY;
+			}
+		}
+
+		for(k = 0; k < KeyCount; k++) {
+			uint64_t Hash = AK_Atomic__Hash_U64(Keys[k]);
+			uint64_t Probe, Index = (Hash >> 7) & Set->GroupMask;
+			for(Probe = 0; Probe <= Set->GroupMask; Probe++) {
+				ak_swiss_set__group* Group = Set->Groups + Index;
+				uint32_t Empty = AK_Swiss_Set__Match(Group->Control, AK_SWISS_SET__EMPTY);
+				if(Empty) {
+					uint32_t Slot = AK_Atomic__Count_Trailing_Zeros_U32(Empty);
+					AK_Atomic_Store_U64(&Group->Keys[Slot], Keys[k], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+					Group->Control[Slot] = (uint8_t)(Hash & 0x7F);
+					break;
+				}
+				Index = (Index+Probe+1) & Set->GroupMask;
+			}
+		}
+
+		AK_Atomic_Store_U64(&Set->Deleted, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		for(i = 0; i < GroupCount; i++) AK_Swiss_Set__End_Write(Set->Groups + i);
+		AK_Atomic_Store_U32(&Set->Generation, AK_Atomic_Load_U32(&Set->Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED)+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+		if(Keys) AK_Atomic__Large_Free(Keys, (size_t)(sizeof(uint64_t)*KeyCount));
+	}
+
+	for(i = 0; i < GroupCount; i++) AK_Swiss_Set__Unlock(Set->Groups + i);
+	AK_Atomic_Store_U32(&Set->IsPurging, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF int8_t AK_Swiss_Set_Create(ak_swiss_set* Set, uint64_t Capacity) {
+	uint64_t i, GroupCount = 1;
+	size_t Size;
+
+	/*Keep the load factor at 7/8 so probes stay short*/
+	while(GroupCount*AK_SWISS_SET__GROUP_SIZE/8*7 < Capacity) GroupCount *= 2;
+	Size = (size_t)(sizeof(ak_swiss_set__group)*GroupCount);
+
+	Set->Memory = AK_Atomic__Large_Allocate(Size+AK_ATOMIC_CACHE_LINE_SIZE);
+	AK_ATOMIC_ASSERT(Set->Memory);
+	if(!Set->Memory) return ak_atomic_false;
+	Set->Groups = (ak_swiss_set__group*)AK_Atomic__Align_Cache_Line(Set->Memory);
+	AK_ATOMIC_MEMORY_CLEAR(Set->Groups, Size);
+	for(i = 0; i < GroupCount; i++) {
+		uint32_t j;
+		for(j = 0; j < AK_SWISS_SET__GROUP_SIZE; j++) Set->Groups[i].Control[j] = AK_SWISS_SET__EMPTY;
+	}
+	Set->GroupMask = GroupCount-1;
+	AK_Atomic_Store_U64(&Set->Count, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U64(&Set->Deleted, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Set->Generation, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Set->IsPurging, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_Swiss_Set_Delete(ak_swiss_set* Set) {
+	if(Set->Memory) AK_Atomic__Large_Free(Set->Memory, sizeof(ak_swiss_set__group)*(size_t)(Set->GroupMask+1)+AK_ATOMIC_CACHE_LINE_SIZE);
+	AK_ATOMIC_MEMORY_CLEAR(Set, sizeof(ak_swiss_set));
+}
+
+/*Groups are probed quadratically (by triangular numbers), which visits every group once since the 
+  group count is a power of two. A group with an empty slot ends the probe because inserts always 
+  use the first group with one and a full group never gets an empty slot back (until a purge, which
+  changes the generation). A key that was found is always correct, a miss is only trusted if no 
+  purge happened during the probe*/
+AKATOMICDEF int8_t AK_Swiss_Set_Contains(ak_swiss_set* Set, uint64_t Key) {
+	uint64_t Hash = AK_Atomic__Hash_U64(Key);
+	uint8_t Tag = (uint8_t)(Hash & 0x7F);
+	uint32_t Generation;
+	uint64_t Probe, Index;
+
+Retry:
+	Generation = AK_Swiss_Set__Wait_Generation(Set);
+	Index = (Hash >> 7) & Set->GroupMask;
+	for(Probe = 0; Probe <= Set->GroupMask; Probe++) {
+		ak_swiss_set__group* Group = Set->Groups + Index;
+		int8_t IsFound, HasEmpty;
+		uint32_t SpinCount = 0;
+		for(;;) {
+			uint32_t Matches;
+			uint32_t Version = AK_Atomic_Load_U32(&Group->Version, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(Version & 1) {
+				AK_Swiss_Set__Spin(&SpinCount);
+				continue;
+			}
+
+			IsFound = ak_atomic_false;
+			Matches = AK_Swiss_Set__Match(Group->Control, Tag);
+			while(Matches && !IsFound) {
+				uint32_t Slot = AK_Atomic__Count_Trailing_Zeros_U32(Matches);
+				IsFound = AK_Atomic_Load_U64(&Group->Keys[Slot], AK_ATOMIC_MEMORY_ORDER_RELAXED) == Key;
+				Matches &= Matches-1;
+			}
+			HasEmpty = AK_Swiss_Set__Match(Group->Control, AK_SWISS_SET__EMPTY) != 0;
+
+			AK_Atomic_Fence_Acquire();
+			if(AK_Atomic_Load_U32(&Group->Version, AK_ATOMIC_MEMORY_ORDER_RELAXED) == Version) break;
+		}
+
+		if(IsFound) return ak_atomic_true;
+		if(HasEmpty) break;
+		Index = (Index+Probe+1) & Set->GroupMask;
+	}
+
+	AK_Atomic_Fence_Acquire();
+	if(AK_Atomic_Load_U32(&Set->Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED) != Generation) goto Retry;
+	return ak_atomic_false;
+}
+
+/*Groups are locked one at a time in probe order. Two inserts of the same key always end in the 
+  same group (the first one with an empty slot), so the second one finds the key there. A purge 
+  can't run while a group is locked, so checking the generation under each lock tells whether the 
+  groups visited before are still valid*/
+AKATOMICDEF int8_t AK_Swiss_Set_Insert(ak_swiss_set* Set, uint64_t Key) {
+	uint64_t Hash = AK_Atomic__Hash_U64(Key);
+	uint8_t Tag = (uint8_t)(Hash & 0x7F);
+	uint64_t MaxDeleted = (Set->GroupMask+1)*AK_SWISS_SET__GROUP_SIZE/8;
+	int8_t IsPurged = ak_atomic_false;
+	uint32_t Generation;
+	uint64_t Probe, Index;
+
+	if(AK_Atomic_Load_U64(&Set->Deleted, AK_ATOMIC_MEMORY_ORDER_RELAXED) >= MaxDeleted) {
+		AK_Swiss_Set__Purge(Set, MaxDeleted);
+	}
+
+Retry:
+	Generation = AK_Swiss_Set__Wait_Generation(Set);
+	Index = (Hash >> 7) & Set->GroupMask;
+	for(Probe = 0; Probe <= Set->GroupMask; Probe++) {
+		ak_swiss_set__group* Group = Set->Groups + Index;
+		AK_Swiss_Set__Lock(Group);
+		if(AK_Atomic_Load_U32(&Set->Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED) != Generation) {
+			AK_Swiss_Set__Unlock(Group);
+			goto Retry;
+		}
+
+		if(AK_Swiss_Set__Find_Locked(Group, Key, Tag) != AK_SWISS_SET__GROUP_SIZE) {
+			AK_Swiss_Set__Unlock(Group);
+			return ak_atomic_false;
+		}
+
+		if(AK_Swiss_Set__Match(Group->Control, AK_SWISS_SET__EMPTY)) {
+			uint32_t Slot = AK_Atomic__Count_Trailing_Zeros_U32(AK_Swiss_Set__Match_Free(Group->Control));
+			AK_Swiss_Set__Begin_Write(Group);
+			AK_Atomic_Store_U64(&Group->Keys[Slot], Key, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			Group->Control[Slot] = Tag;
+			AK_Swiss_Set__End_Write(Group);
+			AK_Swiss_Set__Unlock(Group);
+			AK_Atomic_Increment_U64(&Set->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			return ak_atomic_true;
+		}
+
+		AK_Swiss_Set__Unlock(Group);
+		Index = (Index+Probe+1) & Set->GroupMask;
+	}
+
+	/*Every group is full of keys and tombstones*/
+	if(!IsPurged && AK_Atomic_Load_U64(&Set->Deleted, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+		AK_Swiss_Set__Purge(Set, 1);
+		IsPurged = ak_atomic_true;
+		goto Retry;
+	}
+
+	AK_ATOMIC_ASSERT(!"Swiss set is full");
+	return ak_atomic_false;
+}
+
+AKATOMICDEF int8_t AK_Swiss_Set_Remove(ak_swiss_set* Set, uint64_t Key) {
+	uint64_t Hash = AK_Atomic__Hash_U64(Key);
+	uint8_t Tag = (uint8_t)(Hash & 0x7F);
+	uint32_t Generation;
+	uint64_t Probe, Index;
+
+Retry:
+	Generation = AK_Swiss_Set__Wait_Generation(Set);
+	Index = (Hash >> 7) & Set->GroupMask;
+	for(Probe = 0; Probe <= Set->GroupMask; Probe++) {
+		ak_swiss_set__group* Group = Set->Groups + Index;
+		uint32_t Slot;
+		int8_t HasEmpty;
+
+		AK_Swiss_Set__Lock(Group);
+		if(AK_Atomic_Load_U32(&Set->Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED) != Generation) {
+			AK_Swiss_Set__Unlock(Group);
+			goto Retry;
+		}
+
+		Slot = AK_Swiss_Set__Find_Locked(Group, Key, Tag);
+		HasEmpty = AK_Swiss_Set__Match(Group->Control, AK_SWISS_SET__EMPTY) != 0;
+		if(Slot != AK_SWISS_SET__GROUP_SIZE) {
+			/*A full group has to stay without empty slots or probes that passed it would stop early*/
+			AK_Swiss_Set__Begin_Write(Group);
+			Group->Control[Slot] = HasEmpty ? AK_SWISS_SET__EMPTY : AK_SWISS_SET__DELETED;
+			AK_Swiss_Set__End_Write(Group);
+			/*Counted under the lock so a purge never misses it*/
+			if(!HasEmpty) AK_Atomic_Increment_U64(&Set->Deleted, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Swiss_Set__Unlock(Group);
+			AK_Atomic_Decrement_U64(&Set->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			return ak_atomic_true;
+		}
+		AK_Swiss_Set__Unlock(Group);
+
+		if(HasEmpty) return ak_atomic_false;
+		Index = (Index+Probe+1) & Set->GroupMask;
+	}
+	return ak_atomic_false;
+}
+
+AKATOMICDEF uint64_t AK_Swiss_Set_Count(ak_swiss_set* Set) {
+	return AK_Atomic_Load_U64(&Set->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+/*Lock free skiplist*/
+
+/*A node is linked level by level after its insert succeeded at level 0, so a delete can race with 
+  building the upper levels. Whoever of the two finishes last retires the node, at that point it 
+  can't be linked anywhere anymore*/
+#define AK_LF_SKIPLIST__BUILD_DONE 1
+#define AK_LF_SKIPLIST__UNLINKED 2
+
+struct ak_lf_skiplist__node {
+	uint64_t 	  Key;
+	ak_atomic_u64 Value;
+	ak_atomic_u32 State;
+	uint32_t 	  Level;
+	ak_atomic_ptr Next[1];
+};
+
+static AK_ATOMIC__THREAD_LOCAL uint64_t AK_LF_Skiplist__Random_State;
+static ak_atomic_u64 AK_LF_Skiplist__Seed;
+
+#define AK_LF_Skiplist__Is_Marked(pointer) (((size_t)(pointer)) & 1)
+#define AK_LF_Skiplist__Mark(pointer) ((void*)(((size_t)(pointer)) | 1))
+#define AK_LF_Skiplist__Unmark(pointer) ((ak_lf_skiplist__node*)(((size_t)(pointer)) & ~(size_t)1))
+
+static ak_lf_skiplist__node* AK_LF_Skiplist__Allocate_Node(uint64_t Key, uint64_t Value, uint32_t Level) {
+	size_t Size = sizeof(ak_lf_skiplist__node)+sizeof(ak_atomic_ptr)*(Level-1);
+	ak_lf_skiplist__node* Node = (ak_lf_skiplist__node*)AK_ATOMIC_MALLOC(Size);
+	AK_ATOMIC_ASSERT(Node);
+	if(!Node) return NULL;
+	AK_ATOMIC_MEMORY_CLEAR(Node, Size);
+	Node->Key = Key;
+	Node->Level = Level;
+	AK_Atomic_Store_U64(&Node->Value, Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return Node;
+}
+
+static AK_RECLAIM_CALLBACK_DEFINE(AK_LF_Skiplist__Free_Node) {
+	AK_ATOMIC_FREE(Pointer);
+}
+
+/*Geometric distribution with p = 1/2 from a per thread xorshift*/
+static uint32_t AK_LF_Skiplist__Random_Level(void) {
+	uint64_t State = AK_LF_Skiplist__Random_State;
+	uint32_t Level;
+	if(!State) {
+		State = AK_Atomic__Hash_U64(AK_Atomic_Increment_U64(&AK_LF_Skiplist__Seed, AK_ATOMIC_MEMORY_ORDER_RELAXED)) | 1;
+	}
+	State ^= State << 13;
+	State ^= State >> 7;
+	State ^= State << 17;
+	AK_LF_Skiplist__Random_State = State;
+
+	Level = 1+AK_Atomic__Count_Trailing_Zeros_U32((uint32_t)(State >> 32) | (1u << (AK_LF_SKIPLIST_MAX_LEVEL-1)));
+	return Level;
+}
+
+/*Fills the predecessors and successors of the key on every level and unlinks every marked node it
+  walks past. Returns true if an unmarked node with the key is at level 0*/
+static int8_t AK_LF_Skiplist__Search(ak_lf_skiplist* List, uint64_t Key, ak_lf_skiplist__node** Preds, ak_lf_skiplist__node** Succs) {
+	int32_t Level;
+	ak_lf_skiplist__node* Pred;
+	ak_lf_skiplist__node* Curr;
+
+Retry:
+	Pred = List->Head;
+	for(Level = AK_LF_SKIPLIST_MAX_LEVEL-1; Level >= 0; Level--) {
+		Curr = AK_LF_Skiplist__Unmark(AK_Atomic_Load_Ptr(&Pred->Next[Level], AK_ATOMIC_MEMORY_ORDER_ACQUIRE));
+		while(Curr) {
+			void* Succ = AK_Atomic_Load_Ptr(&Curr->Next[Level], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(AK_LF_Skiplist__Is_Marked(Succ)) {
+				void* Expected = Curr;
+				if(!AK_Atomic_Compare_Exchange_Strong_Ptr(&Pred->Next[Level], &Expected, AK_LF_Skiplist__Unmark(Succ), AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+					goto Retry;
+				}
+				Curr = AK_LF_Skiplist__Unmark(Succ);
+				continue;
+			}
+
+			if(Curr->Key >= Key) break;
+			Pred = Curr;
+			Curr = (ak_lf_skiplist__node*)Succ;
+		}
+		Preds[Level] = Pred;
+		Succs[Level] = Curr;
+	}
+	return Succs[0] && Succs[0]->Key == Key;
+}
+
+/*Read only search for the first node at level 0 whose key is greater or equal, skipping deleted 
+  nodes without unlinking them*/
+static ak_lf_skiplist__node* AK_LF_Skiplist__Lower_Bound(ak_lf_skiplist* List, uint64_t Key) {
+	int32_t Level;
+	ak_lf_skiplist__node* Pred = List->Head;
+	ak_lf_skiplist__node* Curr = NULL;
+
+	for(Level = AK_LF_SKIPLIST_MAX_LEVEL-1; Level >= 0; Level--) {
+		Curr = AK_LF_Skiplist__Unmark(AK_Atomic_Load_Ptr(&Pred->Next[Level], AK_ATOMIC_MEMORY_ORDER_ACQUIRE));
+		while(Curr) {
+			void* Succ = AK_Atomic_Load_Ptr(&Curr->Next[Level], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(!AK_LF_Skiplist__Is_Marked(Succ)) {
+				if(Curr->Key >= Key) break;
+				Pred = Curr;
+			}
+			Curr = AK_LF_Skiplist__Unmark(Succ);
+		}
+	}
+
+	/*The node may have been deleted after we looked at its upper levels*/
+	while(Curr && AK_LF_Skiplist__Is_Marked(AK_Atomic_Load_Ptr(&Curr->Next[0], AK_ATOMIC_MEMORY_ORDER_ACQUIRE))) {
+		Curr = AK_LF_Skiplist__Unmark(AK_Atomic_Load_Ptr(&Curr->Next[0], AK_ATOMIC_MEMORY_ORDER_ACQUIRE));
+	}
+	return Curr;
+}
+
+static void AK_LF_Skiplist__Finish(ak_lf_skiplist__node* Node, uint32_t Flag) {
+	uint32_t OtherFlag = Flag == AK_LF_SKIPLIST__BUILD_DONE ? AK_LF_SKIPLIST__UNLINKED : AK_LF_SKIPLIST__BUILD_DONE;
+	if(AK_Atomic_Fetch_Or_U32(&Node->State, Flag, AK_ATOMIC_MEMORY_ORDER_ACQ_REL) & OtherFlag) {
+		AK_Epoch_Retire(Node, AK_LF_Skiplist__Free_Node);
+	}
+}
+
+AKATOMICDEF int8_t AK_LF_Skiplist_Create(ak_lf_skiplist* List) {
+	List->Head = AK_LF_Skiplist__Allocate_Node(0, 0, AK_LF_SKIPLIST_MAX_LEVEL);
+	if(!List->Head) return ak_atomic_false;
+	AK_Atomic_Store_U64(&List->Count, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_LF_Skiplist_Delete(ak_lf_skiplist* List) {
+	ak_lf_skiplist__node* Node = List->Head;
+	while(Node) {
+		ak_lf_skiplist__node* Next = AK_LF_Skiplist__Unmark(AK_Atomic_Load_Ptr(&Node->Next[0], AK_ATOMIC_MEMORY_ORDER_RELAXED));
+		AK_ATOMIC_FREE(Node);
+		Node = Next;
+	}
+	AK_ATOMIC_MEMORY_CLEAR(List, sizeof(ak_lf_skiplist));
+}
+
+AKATOMICDEF int8_t AK_LF_Skiplist_Find(ak_lf_skiplist* List, uint64_t Key, uint64_t* Value) {
+	ak_lf_skiplist__node* Node;
+	int8_t Result = ak_atomic_false;
+
+	AK_Epoch_Enter();
+	Node = AK_LF_Skiplist__Lower_Bound(List, Key);
+	if(Node && Node->Key == Key) {
+		if(Value) *Value = AK_Atomic_Load_U64(&Node->Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Result = ak_atomic_true;
+	}
+	AK_Epoch_Exit();
+	return Result;
+}
+
+AKATOMICDEF int8_t AK_LF_Skiplist_Insert(ak_lf_skiplist* List, uint64_t Key, uint64_t Value) {
+	ak_lf_skiplist__node* Preds[AK_LF_SKIPLIST_MAX_LEVEL];
+	ak_lf_skiplist__node* Succs[AK_LF_SKIPLIST_MAX_LEVEL];
+	ak_lf_skiplist__node* Node;
+	uint32_t i, Level = AK_LF_Skiplist__Random_Level();
+
+	Node = AK_LF_Skiplist__Allocate_Node(Key, Value, Level);
+	if(!Node) return ak_atomic_false;
+
+	AK_Epoch_Enter();
+	for(;;) {
+		void* Expected;
+		if(AK_LF_Skiplist__Search(List, Key, Preds, Succs)) {
+			AK_Epoch_Exit();
+			AK_ATOMIC_FREE(Node);
+			return ak_atomic_false;
+		}
+
+		for(i = 0; i < Level; i++) AK_Atomic_Store_Ptr(&Node->Next[i], Succs[i], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Expected = Succs[0];
+		if(AK_Atomic_Compare_Exchange_Strong_Ptr(&Preds[0]->Next[0], &Expected, Node, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) break;
+	}
+	AK_Atomic_Increment_U64(&List->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	/*Link the upper levels. A delete marks every level of the node, so building stops once the 
+	  node is marked*/
+	for(i = 1; i < Level; i++) {
+		for(;;) {
+			void* Expected;
+			void* Next = AK_Atomic_Load_Ptr(&Node->Next[i], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+			if(AK_LF_Skiplist__Is_Marked(Next)) goto Done;
+			if(Next != Succs[i] && !AK_Atomic_Compare_Exchange_Strong_Ptr(&Node->Next[i], &Next, Succs[i], AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) goto Done;
+
+			Expected = Succs[i];
+			if(AK_Atomic_Compare_Exchange_Strong_Ptr(&Preds[i]->Next[i], &Expected, Node, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) break;
+			if(!AK_LF_Skiplist__Search(List, Key, Preds, Succs) || Succs[0] != Node) goto Done;
+		}
+	}
+
+Done:
+	/*A delete that finished before one of our links could have missed it, so unlink again*/
+	if(AK_LF_Skiplist__Is_Marked(AK_Atomic_Load_Ptr(&Node->Next[0], AK_ATOMIC_MEMORY_ORDER_ACQUIRE))) {
+		AK_LF_Skiplist__Search(List, Key, Preds, Succs);
+	}
+	AK_LF_Skiplist__Finish(Node, AK_LF_SKIPLIST__BUILD_DONE);
+	AK_Epoch_Exit();
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_LF_Skiplist_Remove(ak_lf_skiplist* List, uint64_t Key) {
+	ak_lf_skiplist__node* Preds[AK_LF_SKIPLIST_MAX_LEVEL];
+	ak_lf_skiplist__node* Succs[AK_LF_SKIPLIST_MAX_LEVEL];
+	ak_lf_skiplist__node* Node;
+	int32_t Level;
+	void* Next;
+
+	AK_Epoch_Enter();
+	if(!AK_LF_Skiplist__Search(List, Key, Preds, Succs)) {
+		AK_Epoch_Exit();
+		return ak_atomic_false;
+	}
+	Node = Succs[0];
+
+	for(Level = (int32_t)Node->Level-1; Level >= 1; Level--) {
+		Next = AK_Atomic_Load_Ptr(&Node->Next[Level], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		while(!AK_LF_Skiplist__Is_Marked(Next)) {
+			AK_Atomic_Compare_Exchange_Weak_Ptr(&Node->Next[Level], &Next, AK_LF_Skiplist__Mark(Next), AK_ATOMIC_MEMORY_ORDER_ACQ_REL);
+		}
+	}
+
+	/*Marking level 0 is the linearization point, only one remove can win it*/
+	Next = AK_Atomic_Load_Ptr(&Node->Next[0], AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	for(;;) {
+		if(AK_LF_Skiplist__Is_Marked(Next)) {
+			AK_Epoch_Exit();
+			return ak_atomic_false;
+		}
+		if(AK_Atomic_Compare_Exchange_Weak_Ptr(&Node->Next[0], &Next, AK_LF_Skiplist__Mark(Next), AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) break;
+	}
+	AK_Atomic_Decrement_U64(&List->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	AK_LF_Skiplist__Search(List, Key, Preds, Succs);
+	AK_LF_Skiplist__Finish(Node, AK_LF_SKIPLIST__UNLINKED);
+	AK_Epoch_Exit();
+	return ak_atomic_true;
+}
+
+AKATOMICDEF uint64_t AK_LF_Skiplist_Count(ak_lf_skiplist* List) {
+	return AK_Atomic_Load_U64(&List->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+static int8_t AK_LF_Skiplist__Iterator_Set(ak_lf_skiplist_iterator* Iterator, ak_lf_skiplist__node* Node) {
+	Iterator->Node = Node;
+	if(!Node) return ak_atomic_false;
+	Iterator->Key = Node->Key;
+	Iterator->Value = AK_Atomic_Load_U64(&Node->Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_LF_Skiplist_Iterator_Begin(ak_lf_skiplist* List, ak_lf_skiplist_iterator* Iterator, uint64_t StartKey) {
+	AK_Epoch_Enter();
+	return AK_LF_Skiplist__Iterator_Set(Iterator, AK_LF_Skiplist__Lower_Bound(List, StartKey));
+}
+
+/*A deleted node keeps its frozen next pointer, which still leads forward in key order*/
+AKATOMICDEF int8_t AK_LF_Skiplist_Iterator_Next(ak_lf_skiplist_iterator* Iterator) {
+	ak_lf_skiplist__node* Node = Iterator->Node;
+	if(!Node) return ak_atomic_false;
+
+	do {
+		Node = AK_LF_Skiplist__Unmark(AK_Atomic_Load_Ptr(&Node->Next[0], AK_ATOMIC_MEMORY_ORDER_ACQUIRE));
+	} while(Node && AK_LF_Skiplist__Is_Marked(AK_Atomic_Load_Ptr(&Node->Next[0], AK_ATOMIC_MEMORY_ORDER_ACQUIRE)));
+	return AK_LF_Skiplist__Iterator_Set(Iterator, Node);
+}
+
+AKATOMICDEF void AK_LF_Skiplist_Iterator_End(ak_lf_skiplist_iterator* Iterator) {
+	Iterator->Node = NULL;
+	AK_Epoch_Exit();
+}
+
+/*OLC B+tree*/
+
+/*Both node kinds fill AK_OLC_BTREE_NODE_SIZE exactly on 64 bit targets*/
+#define AK_OLC_BTREE__CAPACITY ((AK_OLC_BTREE_NODE_SIZE-32)/16)
+
+/*Version is odd while a writer holds the node. Everything a reader looks at is atomic since it 
+  reads nodes that are being modified and only finds out afterwards*/
+typedef struct {
+	ak_atomic_u64 Version;
+	ak_atomic_u32 Count;
+	uint32_t 	  IsLeaf;
+	void* 		  Memory;
+} ak_olc_btree__node;
+
+typedef struct {
+	ak_olc_btree__node Node;
+	ak_atomic_ptr 	   Next;
+	ak_atomic_u64 	   Keys[AK_OLC_BTREE__CAPACITY];
+	ak_atomic_u64 	   Values[AK_OLC_BTREE__CAPACITY];
+} ak_olc_btree__leaf;
+
+/*Children[i] holds the keys that are less or equal to Keys[i]*/
+typedef struct {
+	ak_olc_btree__node Node;
+	ak_atomic_u64 	   Keys[AK_OLC_BTREE__CAPACITY];
+	ak_atomic_ptr 	   Children[AK_OLC_BTREE__CAPACITY+1];
+} ak_olc_btree__inner;
+
+AK_ATOMIC__COMPILE_TIME_ASSERT(AK_OLC_BTREE__CAPACITY >= 4);
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_olc_btree__leaf) <= AK_OLC_BTREE_NODE_SIZE);
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_olc_btree__inner) <= AK_OLC_BTREE_NODE_SIZE);
+
+static ak_olc_btree__node* AK_OLC_BTree__Allocate_Node(uint32_t IsLeaf) {
+	size_t Size = IsLeaf ? sizeof(ak_olc_btree__leaf) : sizeof(ak_olc_btree__inner);
+	ak_olc_btree__node* Node;
+	void* Memory = AK_ATOMIC_MALLOC(Size+AK_ATOMIC_CACHE_LINE_SIZE);
+	AK_ATOMIC_ASSERT(Memory);
+	if(!Memory) return NULL;
+	Node = (ak_olc_btree__node*)AK_Atomic__Align_Cache_Line(Memory);
+	AK_ATOMIC_MEMORY_CLEAR(Node, Size);
+	Node->IsLeaf = IsLeaf;
+	Node->Memory = Memory;
+	return Node;
+}
+
+static void AK_OLC_BTree__Free_Node(ak_olc_btree__node* Node) {
+	if(!Node->IsLeaf) {
+		ak_olc_btree__inner* Inner = (ak_olc_btree__inner*)Node;
+		uint32_t i, Count = AK_Atomic_Load_U32(&Node->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		for(i = 0; i <= Count; i++) {
+			AK_OLC_BTree__Free_Node((ak_olc_btree__node*)AK_Atomic_Load_Ptr(&Inner->Children[i], AK_ATOMIC_MEMORY_ORDER_RELAXED));
+		}
+	}
+	AK_ATOMIC_FREE(Node->Memory);
+}
+
+/*Fails when a writer holds the node, callers restart*/
+static int8_t AK_OLC_BTree__Read_Lock(ak_olc_btree__node* Node, uint64_t* Version) {
+	*Version = AK_Atomic_Load_U64(&Node->Version, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(*Version & 1) {
+		AK_ATOMIC__SPIN_PAUSE();
+		return ak_atomic_false;
+	}
+	return ak_atomic_true;
+}
+
+/*True if nothing was written to the node since Version was read, which makes every read in between
+  consistent*/
+static int8_t AK_OLC_BTree__Validate(ak_olc_btree__node* Node, uint64_t Version) {
+	AK_Atomic_Fence_Acquire();
+	return AK_Atomic_Load_U64(&Node->Version, AK_ATOMIC_MEMORY_ORDER_RELAXED) == Version;
+}
+
+/*Readers have to see the odd version before any of the writes to the node*/
+static int8_t AK_OLC_BTree__Upgrade(ak_olc_btree__node* Node, uint64_t Version) {
+	if(!AK_Atomic_Compare_Exchange_Strong_U64(&Node->Version, &Version, Version+1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+		return ak_atomic_false;
+	}
+	AK_Atomic_Fence_Release();
+	return ak_atomic_true;
+}
+
+static void AK_OLC_BTree__Write_Unlock(ak_olc_btree__node* Node) {
+	uint64_t Version = AK_Atomic_Load_U64(&Node->Version, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U64(&Node->Version, Version+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+static uint32_t AK_OLC_BTree__Lower_Bound(ak_atomic_u64* Keys, uint32_t Count, uint64_t Key) {
+	uint32_t Low = 0, High = Count;
+	while(Low < High) {
+		uint32_t Middle = (Low+High)/2;
+		if(AK_Atomic_Load_U64(&Keys[Middle], AK_ATOMIC_MEMORY_ORDER_RELAXED) < Key) Low = Middle+1;
+		else High = Middle;
+	}
+	return Low;
+}
+
+/*Optimistically descends to the leaf that covers Key. Every parent is validated after its child's 
+  version was read, so the child was still the right one at that point. Returns NULL on a restart*/
+static ak_olc_btree__leaf* AK_OLC_BTree__Find_Leaf(ak_olc_btree* Tree, uint64_t Key, uint64_t* LeafVersion) {
+	uint64_t Version;
+	ak_olc_btree__node* Node = (ak_olc_btree__node*)AK_Atomic_Load_Ptr(&Tree->Root, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(!AK_OLC_BTree__Read_Lock(Node, &Version)) return NULL;
+	if(Node != AK_Atomic_Load_Ptr(&Tree->Root, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) return NULL;
+
+	while(!Node->IsLeaf) {
+		ak_olc_btree__inner* Inner = (ak_olc_btree__inner*)Node;
+		uint32_t Count = AK_Atomic_Load_U32(&Node->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		uint32_t Index = AK_OLC_BTree__Lower_Bound(Inner->Keys, Count, Key);
+		ak_olc_btree__node* Child = (ak_olc_btree__node*)AK_Atomic_Load_Ptr(&Inner->Children[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		uint64_t ChildVersion;
+
+		if(!AK_OLC_BTree__Validate(Node, Version)) return NULL;
+		if(!AK_OLC_BTree__Read_Lock(Child, &ChildVersion)) return NULL;
+		if(!AK_OLC_BTree__Validate(Node, Version)) return NULL;
+		Node = Child;
+		Version = ChildVersion;
+	}
+
+	*LeafVersion = Version;
+	return (ak_olc_btree__leaf*)Node;
+}
+
+/*Only called with the inner node write locked and not full*/
+static void AK_OLC_BTree__Inner_Insert(ak_olc_btree__inner* Inner, uint64_t Key, ak_olc_btree__node* Child) {
+	uint32_t i, Count = AK_Atomic_Load_U32(&Inner->Node.Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t Index = AK_OLC_BTree__Lower_Bound(Inner->Keys, Count, Key);
+	for(i = Count; i > Index; i--) {
+		AK_Atomic_Store_U64(&Inner->Keys[i], AK_Atomic_Load_U64(&Inner->Keys[i-1], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_Ptr(&Inner->Children[i+1], AK_Atomic_Load_Ptr(&Inner->Children[i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	AK_Atomic_Store_U64(&Inner->Keys[Index], Key, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_Ptr(&Inner->Children[Index+1], Child, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Inner->Node.Count, Count+1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+/*Only called with the node and its parent (if any) write locked. Moves the upper half of the node 
+  into a new right sibling and adds the separator to the parent, or grows a new root. The new nodes 
+  are published by the parent's or the root's release, so their contents can be written relaxed*/
+static int8_t AK_OLC_BTree__Split(ak_olc_btree* Tree, ak_olc_btree__inner* Parent, ak_olc_btree__node* Node) {
+	uint32_t i, Count = AK_Atomic_Load_U32(&Node->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t RightCount = Count-Count/2;
+	uint64_t Separator;
+	ak_olc_btree__inner* Root = NULL;
+	ak_olc_btree__node* Right = AK_OLC_BTree__Allocate_Node(Node->IsLeaf);
+	if(!Right) return ak_atomic_false;
+	if(!Parent) {
+		Root = (ak_olc_btree__inner*)AK_OLC_BTree__Allocate_Node(ak_atomic_false);
+		if(!Root) {
+			AK_ATOMIC_FREE(Right->Memory);
+			return ak_atomic_false;
+		}
+	}
+
+	if(Node->IsLeaf) {
+		ak_olc_btree__leaf* LeftLeaf = (ak_olc_btree__leaf*)Node;
+		ak_olc_btree__leaf* RightLeaf = (ak_olc_btree__leaf*)Right;
+		uint32_t LeftCount = Count-RightCount;
+		for(i = 0; i < RightCount; i++) {
+			AK_Atomic_Store_U64(&RightLeaf->Keys[i], AK_Atomic_Load_U64(&LeftLeaf->Keys[LeftCount+i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Atomic_Store_U64(&RightLeaf->Values[i], AK_Atomic_Load_U64(&LeftLeaf->Values[LeftCount+i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		AK_Atomic_Store_U32(&Right->Count, RightCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_Ptr(&RightLeaf->Next, AK_Atomic_Load_Ptr(&LeftLeaf->Next, AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_Ptr(&LeftLeaf->Next, RightLeaf, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+		AK_Atomic_Store_U32(&Node->Count, LeftCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Separator = AK_Atomic_Load_U64(&LeftLeaf->Keys[LeftCount-1], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	} else {
+		/*The separator moves up into the parent*/
+		ak_olc_btree__inner* LeftInner = (ak_olc_btree__inner*)Node;
+		ak_olc_btree__inner* RightInner = (ak_olc_btree__inner*)Right;
+		uint32_t LeftCount = Count-RightCount-1;
+		for(i = 0; i < RightCount; i++) {
+			AK_Atomic_Store_U64(&RightInner->Keys[i], AK_Atomic_Load_U64(&LeftInner->Keys[LeftCount+1+i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		for(i = 0; i <= RightCount; i++) {
+			AK_Atomic_Store_Ptr(&RightInner->Children[i], AK_Atomic_Load_Ptr(&LeftInner->Children[LeftCount+1+i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		AK_Atomic_Store_U32(&Right->Count, RightCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U32(&Node->Count, LeftCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Separator = AK_Atomic_Load_U64(&LeftInner->Keys[LeftCount], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+
+	if(Parent) {
+		AK_OLC_BTree__Inner_Insert(Parent, Separator, Right);
+	} else {
+		AK_Atomic_Store_U64(&Root->Keys[0], Separator, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_Ptr(&Root->Children[0], Node, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_Ptr(&Root->Children[1], Right, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U32(&Root->Node.Count, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_Ptr(&Tree->Root, Root, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	}
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_OLC_BTree_Create(ak_olc_btree* Tree) {
+	ak_olc_btree__node* Root = AK_OLC_BTree__Allocate_Node(ak_atomic_true);
+	if(!Root) return ak_atomic_false;
+	AK_Atomic_Store_Ptr(&Tree->Root, Root, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U64(&Tree->Count, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_OLC_BTree_Delete(ak_olc_btree* Tree) {
+	ak_olc_btree__node* Root = (ak_olc_btree__node*)AK_Atomic_Load_Ptr(&Tree->Root, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(Root) AK_OLC_BTree__Free_Node(Root);
+	AK_ATOMIC_MEMORY_CLEAR(Tree, sizeof(ak_olc_btree));
+}
+
+AKATOMICDEF int8_t AK_OLC_BTree_Find(ak_olc_btree* Tree, uint64_t Key, uint64_t* Value) {
+	for(;;) {
+		uint64_t Version, Result = 0;
+		uint32_t Count, Index;
+		int8_t IsFound;
+		ak_olc_btree__leaf* Leaf = AK_OLC_BTree__Find_Leaf(Tree, Key, &Version);
+		if(!Leaf) continue;
+
+		Count = AK_Atomic_Load_U32(&Leaf->Node.Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Index = AK_OLC_BTree__Lower_Bound(Leaf->Keys, Count, Key);
+		IsFound = Index < Count && AK_Atomic_Load_U64(&Leaf->Keys[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED) == Key;
+		if(IsFound) Result = AK_Atomic_Load_U64(&Leaf->Values[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(!AK_OLC_BTree__Validate(&Leaf->Node, Version)) continue;
+
+		if(IsFound && Value) *Value = Result;
+		return IsFound;
+	}
+}
+
+/*Full nodes are split eagerly while descending, which needs the parent locked as well. Afterwards 
+  the insert restarts from the root*/
+AKATOMICDEF int8_t AK_OLC_BTree_Insert(ak_olc_btree* Tree, uint64_t Key, uint64_t Value) {
+	ak_olc_btree__node* Node;
+	ak_olc_btree__inner* Parent;
+	ak_olc_btree__leaf* Leaf;
+	uint64_t Version, ParentVersion = 0;
+	uint32_t i, Count, Index;
+
+Restart:
+	Parent = NULL;
+	Node = (ak_olc_btree__node*)AK_Atomic_Load_Ptr(&Tree->Root, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(!AK_OLC_BTree__Read_Lock(Node, &Version)) goto Restart;
+	if(Node != AK_Atomic_Load_Ptr(&Tree->Root, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) goto Restart;
+
+	for(;;) {
+		Count = AK_Atomic_Load_U32(&Node->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(Count == AK_OLC_BTREE__CAPACITY) {
+			int8_t Result;
+			if(Parent && !AK_OLC_BTree__Upgrade(&Parent->Node, ParentVersion)) goto Restart;
+			if(!AK_OLC_BTree__Upgrade(Node, Version)) {
+				if(Parent) AK_OLC_BTree__Write_Unlock(&Parent->Node);
+				goto Restart;
+			}
+
+			/*Someone else grew a new root above the node*/
+			if(!Parent && Node != AK_Atomic_Load_Ptr(&Tree->Root, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+				AK_OLC_BTree__Write_Unlock(Node);
+				goto Restart;
+			}
+
+			Result = AK_OLC_BTree__Split(Tree, Parent, Node);
+			AK_OLC_BTree__Write_Unlock(Node);
+			if(Parent) AK_OLC_BTree__Write_Unlock(&Parent->Node);
+			if(!Result) return ak_atomic_false;
+			goto Restart;
+		}
+		if(Node->IsLeaf) break;
+
+		if(Parent && !AK_OLC_BTree__Validate(&Parent->Node, ParentVersion)) goto Restart;
+		Parent = (ak_olc_btree__inner*)Node;
+		ParentVersion = Version;
+		Index = AK_OLC_BTree__Lower_Bound(Parent->Keys, Count, Key);
+		Node = (ak_olc_btree__node*)AK_Atomic_Load_Ptr(&Parent->Children[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(!AK_OLC_BTree__Validate(&Parent->Node, ParentVersion)) goto Restart;
+		if(!AK_OLC_BTree__Read_Lock(Node, &Version)) goto Restart;
+	}
+
+	Leaf = (ak_olc_btree__leaf*)Node;
+	Index = AK_OLC_BTree__Lower_Bound(Leaf->Keys, Count, Key);
+	if(Index < Count && AK_Atomic_Load_U64(&Leaf->Keys[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED) == Key) {
+		if(!AK_OLC_BTree__Validate(Node, Version)) goto Restart;
+		return ak_atomic_false;
+	}
+
+	/*The upgrade only succeeds if the leaf is unchanged, so Count and Index are still right*/
+	if(!AK_OLC_BTree__Upgrade(Node, Version)) goto Restart;
+	if(Parent && !AK_OLC_BTree__Validate(&Parent->Node, ParentVersion)) {
+		AK_OLC_BTree__Write_Unlock(Node);
+		goto Restart;
+	}
+
+	for(i = Count; i > Index; i--) {
+		AK_Atomic_Store_U64(&Leaf->Keys[i], AK_Atomic_Load_U64(&Leaf->Keys[i-1], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U64(&Leaf->Values[i], AK_Atomic_Load_U64(&Leaf->Values[i-1], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	AK_Atomic_Store_U64(&Leaf->Keys[Index], Key, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U64(&Leaf->Values[Index], Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Node->Count, Count+1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_OLC_BTree__Write_Unlock(Node);
+
+	AK_Atomic_Increment_U64(&Tree->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF int8_t AK_OLC_BTree_Remove(ak_olc_btree* Tree, uint64_t Key) {
+	for(;;) {
+		uint64_t Version;
+		uint32_t i, Count, Index;
+		ak_olc_btree__leaf* Leaf = AK_OLC_BTree__Find_Leaf(Tree, Key, &Version);
+		if(!Leaf) continue;
+
+		Count = AK_Atomic_Load_U32(&Leaf->Node.Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Index = AK_OLC_BTree__Lower_Bound(Leaf->Keys, Count, Key);
+		if(Index == Count || AK_Atomic_Load_U64(&Leaf->Keys[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED) != Key) {
+			if(!AK_OLC_BTree__Validate(&Leaf->Node, Version)) continue;
+			return ak_atomic_false;
+		}
+		if(!AK_OLC_BTree__Upgrade(&Leaf->Node, Version)) continue;
+
+		for(i = Index+1; i < Count; i++) {
+			AK_Atomic_Store_U64(&Leaf->Keys[i-1], AK_Atomic_Load_U64(&Leaf->Keys[i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Atomic_Store_U64(&Leaf->Values[i-1], AK_Atomic_Load_U64(&Leaf->Values[i], AK_ATOMIC_MEMORY_ORDER_RELAXED), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		AK_Atomic_Store_U32(&Leaf->Node.Count, Count-1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_OLC_BTree__Write_Unlock(&Leaf->Node);
+
+		AK_Atomic_Decrement_U64(&Tree->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		return ak_atomic_true;
+	}
+}
+
+AKATOMICDEF uint64_t AK_OLC_BTree_Count(ak_olc_btree* Tree) {
+	return AK_Atomic_Load_U64(&Tree->Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+/*Splits only ever move keys into a new right sibling and leaves are never freed, so following the 
+  next pointers from any leaf that once covered StartKey reaches every larger key*/
+AKATOMICDEF uint32_t AK_OLC_BTree_Scan(ak_olc_btree* Tree, uint64_t StartKey, uint64_t* Keys, uint64_t* Values, uint32_t MaxCount) {
+	ak_olc_btree__leaf* Leaf;
+	uint64_t Version;
+	uint32_t Result = 0;
+	AK_ATOMIC_ASSERT(Keys);
+	if(!MaxCount) return 0;
+
+	do {
+		Leaf = AK_OLC_BTree__Find_Leaf(Tree, StartKey, &Version);
+	} while(!Leaf);
+
+	for(;;) {
+		uint32_t Count = AK_Atomic_Load_U32(&Leaf->Node.Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		uint32_t Index = AK_OLC_BTree__Lower_Bound(Leaf->Keys, Count, StartKey);
+		uint32_t Copied = Result;
+		ak_olc_btree__leaf* Next;
+
+		for(; Index < Count && Copied < MaxCount; Index++, Copied++) {
+			Keys[Copied] = AK_Atomic_Load_U64(&Leaf->Keys[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			if(Values) Values[Copied] = AK_Atomic_Load_U64(&Leaf->Values[Index], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		Next = (ak_olc_btree__leaf*)AK_Atomic_Load_Ptr(&Leaf->Next, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+		/*Copy the leaf again, the pairs copied from it may be torn*/
+		if(!AK_OLC_BTree__Validate(&Leaf->Node, Version)) {
+			while(!AK_OLC_BTree__Read_Lock(&Leaf->Node, &Version)) {}
+			continue;
+		}
+
+		Result = Copied;
+		if(Result == MaxCount || !Next) return Result;
+		if(Result) {
+			if(Keys[Result-1] == (uint64_t)-1) return Result;
+			StartKey = Keys[Result-1]+1;
+		}
+
+		Leaf = Next;
+		while(!AK_OLC_BTree__Read_Lock(&Leaf->Node, &Version)) {}
+	}
+}
+
+/*Tagged stack*/
+
+#if AK_ATOMIC_PTR_SIZE == 8
+#define AK_ATOMIC__TAGGED_POINTER_MASK 0x0000FFFFFFFFFFFFull
+#define AK_ATOMIC__TAGGED_TAG_SHIFT 48
+#else
+#define AK_ATOMIC__TAGGED_POINTER_MASK 0x00000000FFFFFFFFull
+#define AK_ATOMIC__TAGGED_TAG_SHIFT 32
+#endif
+
+/*Lock free stack whose head is a pointer and a tag packed in a u64. Nodes start with their 
+  ak_atomic_ptr link and must not be freed while the stack is in use, so a pop may read the link of a
+  node that was popped by someone else in the meantime. The tag makes its CAS fail in that case*/
+static void AK_Atomic__Tagged_Push(ak_atomic_u64* Stack, ak_atomic_ptr* Node) {
+	uint64_t Head = AK_Atomic_Load_U64(Stack, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint64_t NewHead;
+	AK_ATOMIC_ASSERT(((uint64_t)(size_t)Node & ~AK_ATOMIC__TAGGED_POINTER_MASK) == 0);
+	do {
+		AK_Atomic_Store_Ptr(Node, (void*)(size_t)(Head & AK_ATOMIC__TAGGED_POINTER_MASK), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		NewHead = (uint64_t)(size_t)Node | ((((Head >> AK_ATOMIC__TAGGED_TAG_SHIFT)+1) << AK_ATOMIC__TAGGED_TAG_SHIFT));
+	} while(!AK_Atomic_Compare_Exchange_Weak_U64(Stack, &Head, NewHead, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+}
+
+static void* AK_Atomic__Tagged_Pop(ak_atomic_u64* Stack) {
+	uint64_t Head = AK_Atomic_Load_U64(Stack, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	for(;;) {
+		ak_atomic_ptr* Node = (ak_atomic_ptr*)(size_t)(Head & AK_ATOMIC__TAGGED_POINTER_MASK);
+		uint64_t NewHead;
+		if(!Node) return NULL;
+
+		NewHead = (uint64_t)(size_t)AK_Atomic_Load_Ptr(Node, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		NewHead |= ((Head >> AK_ATOMIC__TAGGED_TAG_SHIFT)+1) << AK_ATOMIC__TAGGED_TAG_SHIFT;
+		if(AK_Atomic_Compare_Exchange_Weak_U64(Stack, &Head, NewHead, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) return Node;
+	}
+}
+
+/*Object pool*/
+
+#define AK_OBJECT_POOL__ALIGNMENT 16
+
+/*Magazines are never freed before the pool so the depot can use tagged stacks*/
+typedef struct {
+	ak_atomic_ptr Next;
+	void* 		  Link;
+	uint32_t 	  Count;
+	uint32_t 	  Padding;
+	void* 		  Objects[AK_OBJECT_POOL_MAGAZINE_SIZE];
+} ak_object_pool__magazine;
+
+/*Loaded is what allocations and frees work on, Previous is always either full or empty so the thread
+  can do a full magazine worth of allocations or frees before it has to go to the depot again*/
+typedef struct {
+	void* 					  Link;
+	ak_object_pool__magazine* Loaded;
+	ak_object_pool__magazine* Previous;
+} ak_object_pool__cache;
+
+/*Blocks, magazines and caches are only ever pushed onto their lists while the pool is alive and 
+  popped in AK_Object_Pool_Delete, which can't suffer from ABA*/
+static void AK_Object_Pool__Link(ak_atomic_ptr* List, void** Link, void* Item) {
+	void* Head = AK_Atomic_Load_Ptr(List, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	do {
+		*Link = Head;
+	} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(List, &Head, Item, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+}
+
+static ak_object_pool__magazine* AK_Object_Pool__Allocate_Magazine(ak_object_pool* Pool) {
+	ak_object_pool__magazine* Magazine = (ak_object_pool__magazine*)AK_ATOMIC_MALLOC(sizeof(ak_object_pool__magazine));
+	AK_ATOMIC_ASSERT(Magazine);
+	if(!Magazine) return NULL;
+	AK_ATOMIC_MEMORY_CLEAR(Magazine, sizeof(ak_object_pool__magazine));
+	AK_Object_Pool__Link(&Pool->Magazines, &Magazine->Link, Magazine);
+	return Magazine;
+}
+
+/*Carves a new block into a magazine worth of objects. The first AK_OBJECT_POOL__ALIGNMENT bytes of a
+  block link it into the pool's block list*/
+static int8_t AK_Object_Pool__Fill_Magazine(ak_object_pool* Pool, ak_object_pool__magazine* Magazine) {
+	uint32_t i;
+	uint8_t* Block = (uint8_t*)AK_ATOMIC_MALLOC(AK_OBJECT_POOL__ALIGNMENT+Pool->ObjectSize*AK_OBJECT_POOL_MAGAZINE_SIZE);
+	AK_ATOMIC_ASSERT(Block);
+	if(!Block) return ak_atomic_false;
+	AK_Object_Pool__Link(&Pool->Blocks, (void**)Block, Block);
+
+	for(i = 0; i < AK_OBJECT_POOL_MAGAZINE_SIZE; i++) {
+		Magazine->Objects[i] = Block+AK_OBJECT_POOL__ALIGNMENT+Pool->ObjectSize*(AK_OBJECT_POOL_MAGAZINE_SIZE-1-i);
+	}
+	Magazine->Count = AK_OBJECT_POOL_MAGAZINE_SIZE;
+	return ak_atomic_true;
+}
+
+static ak_object_pool__cache* AK_Object_Pool__Get_Cache(ak_object_pool* Pool) {
+	ak_object_pool__cache* Cache = (ak_object_pool__cache*)AK_TLS_Get(&Pool->TLS);
+	if(!Cache) {
+		Cache = (ak_object_pool__cache*)AK_ATOMIC_MALLOC(sizeof(ak_object_pool__cache));
+		AK_ATOMIC_ASSERT(Cache);
+		if(!Cache) return NULL;
+		AK_ATOMIC_MEMORY_CLEAR(Cache, sizeof(ak_object_pool__cache));
+		AK_Object_Pool__Link(&Pool->Caches, &Cache->Link, Cache);
+		AK_TLS_Set(&Pool->TLS, Cache);
+	}
+	return Cache;
+}
+
+AKATOMICDEF int8_t AK_Object_Pool_Create(ak_object_pool* Pool, size_t ObjectSize) {
+	AK_ATOMIC_MEMORY_CLEAR(Pool, sizeof(ak_object_pool));
+	if(!AK_TLS_Create(&Pool->TLS)) return ak_atomic_false;
+	if(!ObjectSize) ObjectSize = 1;
+	Pool->ObjectSize = (ObjectSize+AK_OBJECT_POOL__ALIGNMENT-1) & ~((size_t)AK_OBJECT_POOL__ALIGNMENT-1);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_Object_Pool_Delete(ak_object_pool* Pool) {
+	void* Item = AK_Atomic_Load_Ptr(&Pool->Blocks, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Item) {
+		void* Next = *(void**)Item;
+		AK_ATOMIC_FREE(Item);
+		Item = Next;
+	}
+
+	Item = AK_Atomic_Load_Ptr(&Pool->Magazines, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Item) {
+		void* Next = ((ak_object_pool__magazine*)Item)->Link;
+		AK_ATOMIC_FREE(Item);
+		Item = Next;
+	}
+
+	Item = AK_Atomic_Load_Ptr(&Pool->Caches, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Item) {
+		void* Next = ((ak_object_pool__cache*)Item)->Link;
+		AK_ATOMIC_FREE(Item);
+		Item = Next;
+	}
+
+	AK_TLS_Delete(&Pool->TLS);
+	AK_ATOMIC_MEMORY_CLEAR(Pool, sizeof(ak_object_pool));
+}
+
+AKATOMICDEF void* AK_Object_Pool_Allocate(ak_object_pool* Pool) {
+	ak_object_pool__magazine* Magazine;
+	ak_object_pool__cache* Cache = AK_Object_Pool__Get_Cache(Pool);
+	if(!Cache) return NULL;
+
+	if(Cache->Loaded && Cache->Loaded->Count) {
+		return Cache->Loaded->Objects[--Cache->Loaded->Count];
+	}
+
+	if(Cache->Previous && Cache->Previous->Count == AK_OBJECT_POOL_MAGAZINE_SIZE) {
+		Magazine = Cache->Previous;
+		Cache->Previous = Cache->Loaded;
+		Cache->Loaded = Magazine;
+		return Magazine->Objects[--Magazine->Count];
+	}
+
+	/*Both magazines are empty, trade one of them for a full one*/
+	Magazine = (ak_object_pool__magazine*)AK_Atomic__Tagged_Pop(&Pool->FullMagazines.Value);
+	if(Magazine) {
+		if(Cache->Previous) AK_Atomic__Tagged_Push(&Pool->EmptyMagazines.Value, &Cache->Previous->Next);
+		Cache->Previous = Cache->Loaded;
+		Cache->Loaded = Magazine;
+		return Magazine->Objects[--Magazine->Count];
+	}
+
+	/*The depot ran dry, grow the pool*/
+	if(!Cache->Loaded) {
+		Cache->Loaded = AK_Object_Pool__Allocate_Magazine(Pool);
+		if(!Cache->Loaded) return NULL;
+	}
+	if(!AK_Object_Pool__Fill_Magazine(Pool, Cache->Loaded)) return NULL;
+	return Cache->Loaded->Objects[--Cache->Loaded->Count];
+}
+
+AKATOMICDEF void AK_Object_Pool_Free(ak_object_pool* Pool, void* Object) {
+	ak_object_pool__magazine* Magazine;
+	ak_object_pool__cache* Cache;
+	if(!Object) return;
+
+	Cache = AK_Object_Pool__Get_Cache(Pool);
+	if(!Cache) return;
+
+	if(Cache->Loaded && Cache->Loaded->Count < AK_OBJECT_POOL_MAGAZINE_SIZE) {
+		Cache->Loaded->Objects[Cache->Loaded->Count++] = Object;
+		return;
+	}
+
+	if(Cache->Previous && !Cache->Previous->Count) {
+		Magazine = Cache->Previous;
+		Cache->Previous = Cache->Loaded;
+		Cache->Loaded = Magazine;
+		Magazine->Objects[Magazine->Count++] = Object;
+		return;
+	}
+
+	/*Both magazines are full, trade one of them for an empty one. If that fails the object stays 
+	  in its block until the pool is deleted*/
+	Magazine = (ak_object_pool__magazine*)AK_Atomic__Tagged_Pop(&Pool->EmptyMagazines.Value);
+	if(!Magazine) {
+		Magazine = AK_Object_Pool__Allocate_Magazine(Pool);
+		if(!Magazine) return;
+	}
+	if(Cache->Previous) AK_Atomic__Tagged_Push(&Pool->FullMagazines.Value, &Cache->Previous->Next);
+	Cache->Previous = Cache->Loaded;
+	Cache->Loaded = Magazine;
+	Magazine->Objects[Magazine->Count++] = Object;
+}
+
+/*Partially filled magazines go to the full stack too, allocations take whatever they find there*/
+AKATOMICDEF void AK_Object_Pool_Thread_Exit(ak_object_pool* Pool) {
+	ak_object_pool__cache* Cache = (ak_object_pool__cache*)AK_TLS_Get(&Pool->TLS);
+	ak_object_pool__magazine* Magazines[2];
+	uint32_t i;
+	if(!Cache) return;
+
+	Magazines[0] = Cache->Loaded;
+	Magazines[1] = Cache->Previous;
+	for(i = 0; i < 2; i++) {
+		if(Magazines[i]) {
+			AK_Atomic__Tagged_Push(Magazines[i]->Count ? &Pool->FullMagazines.Value : &Pool->EmptyMagazines.Value, &Magazines[i]->Next);
+		}
+	}
+	Cache->Loaded = NULL;
+	Cache->Previous = NULL;
+}
+
+/*Arena*/
+
+#define AK_Arena__Align_Up(value, alignment) (((value) + (alignment)-1) & ~((alignment)-1))
+
+/*A reset bumps the arena's generation, which tells every thread that its chunk is gone*/
+typedef struct {
+	void* 	 Link;
+	uint8_t* Current;
+	uint8_t* End;
+	uint32_t Generation;
+	uint32_t Padding;
+} ak_arena__cache;
+
+/*The shared offset only moves in whole cache lines so chunks of different threads never share one.
+  Sizes are checked against the reservation before any padding is added so the math can't wrap, and 
+  a used up arena isn't bumped any further so failed allocations can't wrap the offset either*/
+static void* AK_Arena__Allocate_Shared(ak_arena* Arena, size_t Size, size_t Alignment) {
+	uint64_t Offset;
+	size_t Result;
+	if(Size > Arena->ReserveSize || Alignment > Arena->ReserveSize) return NULL;
+	if(Alignment > AK_ATOMIC_CACHE_LINE_SIZE) Size += Alignment-AK_ATOMIC_CACHE_LINE_SIZE;
+	Size = AK_Arena__Align_Up(Size, (size_t)AK_ATOMIC_CACHE_LINE_SIZE);
+	if(AK_Atomic_Load_U64(&Arena->Offset.Value, AK_ATOMIC_MEMORY_ORDER_RELAXED) > Arena->ReserveSize) return NULL;
+
+	Offset = AK_Atomic_Fetch_Add_U64(&Arena->Offset.Value, Size, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(Offset > Arena->ReserveSize || Arena->ReserveSize-Offset < Size) return NULL;
+
+	Result = AK_Arena__Align_Up((size_t)(Arena->Memory+Offset), Alignment);
+	if(!AK_OS__Commit_Memory(Arena->Memory+Offset, Size)) return NULL;
+	return (void*)Result;
+}
+
+static ak_arena__cache* AK_Arena__Get_Cache(ak_arena* Arena) {
+	ak_arena__cache* Cache = (ak_arena__cache*)AK_TLS_Get(&Arena->TLS);
+	if(!Cache) {
+		void* Head;
+		Cache = (ak_arena__cache*)AK_ATOMIC_MALLOC(sizeof(ak_arena__cache));
+		AK_ATOMIC_ASSERT(Cache);
+		if(!Cache) return NULL;
+		AK_ATOMIC_MEMORY_CLEAR(Cache, sizeof(ak_arena__cache));
+
+		Head = AK_Atomic_Load_Ptr(&Arena->Caches, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		do {
+			Cache->Link = Head;
+		} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(&Arena->Caches, &Head, Cache, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+		AK_TLS_Set(&Arena->TLS, Cache);
+	}
+	return Cache;
+}
+
+AKATOMICDEF int8_t AK_Arena_Create(ak_arena* Arena, size_t ReserveSize) {
+	AK_ATOMIC_MEMORY_CLEAR(Arena, sizeof(ak_arena));
+	ReserveSize = AK_Arena__Align_Up(ReserveSize, (size_t)AK_ARENA_CHUNK_SIZE);
+	Arena->Memory = (uint8_t*)AK_OS__Reserve_Memory(ReserveSize);
+	AK_ATOMIC_ASSERT(Arena->Memory);
+	if(!Arena->Memory) return ak_atomic_false;
+	AK_OS__Advise_Huge_Pages(Arena->Memory, ReserveSize);
+
+	if(!AK_TLS_Create(&Arena->TLS)) {
+		AK_OS__Release_Memory(Arena->Memory, ReserveSize);
+		Arena->Memory = NULL;
+		return ak_atomic_false;
+	}
+	Arena->ReserveSize = ReserveSize;
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_Arena_Delete(ak_arena* Arena) {
+	void* Cache = AK_Atomic_Load_Ptr(&Arena->Caches, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	while(Cache) {
+		void* Next = ((ak_arena__cache*)Cache)->Link;
+		AK_ATOMIC_FREE(Cache);
+		Cache = Next;
+	}
+
+	if(Arena->Memory) {
+		AK_TLS_Delete(&Arena->TLS);
+		AK_OS__Release_Memory(Arena->Memory, Arena->ReserveSize);
+	}
+	AK_ATOMIC_MEMORY_CLEAR(Arena, sizeof(ak_arena));
+}
+
+AKATOMICDEF void* AK_Arena_Allocate(ak_arena* Arena, size_t Size, size_t Alignment) {
+	size_t Result;
+	uint32_t Generation = AK_Atomic_Load_U32(&Arena->Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	ak_arena__cache* Cache = AK_Arena__Get_Cache(Arena);
+	AK_ATOMIC_ASSERT(Alignment && !(Alignment & (Alignment-1)));
+	if(!Cache) return NULL;
+
+	/*Nothing this big can fit, and rejecting it here keeps Size+Alignment below from wrapping*/
+	if(Size > Arena->ReserveSize || Alignment > Arena->ReserveSize) return NULL;
+
+	if(Cache->Generation != Generation) {
+		Cache->Current = NULL;
+		Cache->End = NULL;
+		Cache->Generation = Generation;
+	}
+
+	if(Cache->Current) {
+		Result = AK_Arena__Align_Up((size_t)Cache->Current, Alignment);
+		if(Result <= (size_t)Cache->End && (size_t)Cache->End-Result >= Size) {
+			Cache->Current = (uint8_t*)Result+Size;
+			return (void*)Result;
+		}
+	}
+
+	/*Big allocations would waste most of a fresh chunk*/
+	if(Size+Alignment > AK_ARENA_CHUNK_SIZE/4) {
+		return AK_Arena__Allocate_Shared(Arena, Size, Alignment);
+	}
+
+	Cache->Current = (uint8_t*)AK_Arena__Allocate_Shared(Arena, AK_ARENA_CHUNK_SIZE, AK_ATOMIC_CACHE_LINE_SIZE);
+	if(!Cache->Current) {
+		Cache->End = NULL;
+		return NULL;
+	}
+	Cache->End = Cache->Current+AK_ARENA_CHUNK_SIZE;
+
+	Result = AK_Arena__Align_Up((size_t)Cache->Current, Alignment);
+	Cache->Current = (uint8_t*)Result+Size;
+	return (void*)Result;
+}
+
+AKATOMICDEF void AK_Arena_Reset(ak_arena* Arena) {
+	AK_Atomic_Store_U64(&Arena->Offset.Value, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Increment_U32(&Arena->Generation, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+AKATOMICDEF size_t AK_Arena_Used(ak_arena* Arena) {
+	uint64_t Offset = AK_Atomic_Load_U64(&Arena->Offset.Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return Offset < Arena->ReserveSize ? (size_t)Offset : Arena->ReserveSize;
+}
+
+/*Slab allocator*/
+
+/*16 byte classes up to 128 bytes and then four classes per power of two up to AK_SLAB_MAX_SIZE*/
+#define AK_SLAB__SMALL_CLASS_COUNT 8
+#define AK_SLAB__HEADER_SIZE 128
+#define AK_SLAB__LARGE_HEADER_SIZE 16
+#define AK_SLAB__MAX_CLASS_COUNT 64
+
+typedef struct ak_slab__page ak_slab__page;
+
+/*Remote frees form an intrusive Vyukov MPSC queue through the first word of every freed block. 
+  Producers only exchange the tail, Stub is the queue's dummy node. UsedCount counts the blocks that 
+  are handed out and not collected yet, so once it hits zero no other thread can still touch the page*/
+struct ak_slab__page {
+	ak_atomic_ptr  Next;
+	ak_atomic_ptr  Owner;
+	ak_atomic_ptr  RemoteTail;
+	ak_atomic_ptr  Stub;
+	ak_atomic_ptr* RemoteHead;
+	void* 		   LocalFree;
+	ak_slab__page* HeapPrev;
+	ak_slab__page* HeapNext;
+	uint32_t 	   BlockSize;
+	uint32_t 	   BlockCount;
+	uint32_t 	   CarvedCount;
+	uint32_t 	   UsedCount;
+	uint32_t 	   SizeClass;
+	uint32_t 	   Padding;
+};
+
+/*A heap takes a whole page of the reservation, only the part that is touched gets backed*/
+typedef struct {
+	ak_atomic_ptr  Next;
+	ak_slab__page* Pages[AK_SLAB__MAX_CLASS_COUNT];
+} ak_slab__heap;
+
+AK_ATOMIC__COMPILE_TIME_ASSERT(sizeof(ak_slab__page) <= AK_SLAB__HEADER_SIZE);
+AK_ATOMIC__COMPILE_TIME_ASSERT((AK_SLAB_PAGE_SIZE & (AK_SLAB_PAGE_SIZE-1)) == 0);
+AK_ATOMIC__COMPILE_TIME_ASSERT(AK_SLAB_MAX_SIZE >= 256);
+
+static uint32_t AK_Slab__Size_Class(size_t Size) {
+	uint32_t Bits = 7;
+	if(Size <= 128) return Size ? (uint32_t)((Size-1) >> 4) : 0;
+	while((Size-1) >> (Bits+1)) Bits++;
+	return AK_SLAB__SMALL_CLASS_COUNT + (Bits-7)*4 + (uint32_t)((Size-1) >> (Bits-2)) - 4;
+}
+
+static uint32_t AK_Slab__Class_Size(uint32_t SizeClass) {
+	uint32_t Bits;
+	if(SizeClass < AK_SLAB__SMALL_CLASS_COUNT) return (SizeClass+1)*16;
+	SizeClass -= AK_SLAB__SMALL_CLASS_COUNT;
+	Bits = 7 + SizeClass/4;
+	return (5 + SizeClass%4) << (Bits-2);
+}
+
+static void AK_Slab__Remote_Push(ak_slab__page* Page, ak_atomic_ptr* Node) {
+	ak_atomic_ptr* Prev;
+	AK_Atomic_Store_Ptr(Node, NULL, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Prev = (ak_atomic_ptr*)AK_Atomic_Exchange_Ptr(&Page->RemoteTail, Node, AK_ATOMIC_MEMORY_ORDER_ACQ_REL);
+	AK_Atomic_Store_Ptr(Prev, Node, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/*Only called by the owner. Returns NULL when the queue is empty or a producer is between its 
+  exchange and linking its node, the node shows up on the next collect then*/
+static ak_atomic_ptr* AK_Slab__Remote_Pop(ak_slab__page* Page) {
+	ak_atomic_ptr* Head = Page->RemoteHead;
+	ak_atomic_ptr* Next = (ak_atomic_ptr*)AK_Atomic_Load_Ptr(Head, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+
+	if(Head == &Page->Stub) {
+		if(!Next) return NULL;
+		Page->RemoteHead = Next;
+		Head = Next;
+		Next = (ak_atomic_ptr*)AK_Atomic_Load_Ptr(Next, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	}
+
+	if(Next) {
+		Page->RemoteHead = Next;
+		return Head;
+	}
+
+	if(Head != AK_Atomic_Load_Ptr(&Page->RemoteTail, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) return NULL;
+
+	/*Head is the last node, put the stub behind it so it can be taken out*/
+	AK_Slab__Remote_Push(Page, &Page->Stub);
+	Next = (ak_atomic_ptr*)AK_Atomic_Load_Ptr(Head, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+	if(!Next) return NULL;
+	Page->RemoteHead = Next;
+	return Head;
+}
+
+static void AK_Slab__Collect(ak_slab__page* Page) {
+	ak_atomic_ptr* Node;
+	while((Node = AK_Slab__Remote_Pop(Page)) != NULL) {
+		*(void**)Node = Page->LocalFree;
+		Page->LocalFree = Node;
+		Page->UsedCount--;
+	}
+}
+
+static void* AK_Slab__Page_Allocate(ak_slab__page* Page) {
+	void* Block = Page->LocalFree;
+	if(Block) {
+		Page->LocalFree = *(void**)Block;
+	} else {
+		AK_ATOMIC_ASSERT(Page->CarvedCount < Page->BlockCount);
+		Block = (uint8_t*)Page + AK_SLAB__HEADER_SIZE + (size_t)Page->BlockSize*Page->CarvedCount++;
+	}
+	Page->UsedCount++;
+	return Block;
+}
+
+/*Pages and heaps are never unmapped while the slab is alive, so they can share the tagged free 
+  page stack*/
+static void* AK_Slab__Allocate_Raw_Page(ak_slab* Slab, size_t CommitSize) {
+	uint8_t* Page = (uint8_t*)AK_Atomic__Tagged_Pop(&Slab->FreePages.Value);
+	if(!Page) {
+		uint64_t Offset = AK_Atomic_Fetch_Add_U64(&Slab->Offset.Value, AK_SLAB_PAGE_SIZE, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(Offset > Slab->ReserveSize-AK_SLAB_PAGE_SIZE) return NULL;
+		Page = Slab->Memory+Offset;
+	}
+	if(!AK_OS__Commit_Memory(Page, CommitSize)) {
+		AK_Atomic__Tagged_Push(&Slab->FreePages.Value, (ak_atomic_ptr*)Page);
+		return NULL;
+	}
+	return Page;
+}
+
+static ak_slab__page* AK_Slab__Allocate_Page(ak_slab* Slab, ak_slab__heap* Heap, uint32_t SizeClass) {
+	ak_slab__page* Page = (ak_slab__page*)AK_Slab__Allocate_Raw_Page(Slab, AK_SLAB_PAGE_SIZE);
+	if(!Page) return NULL;
+
+	AK_ATOMIC_MEMORY_CLEAR(Page, sizeof(ak_slab__page));
+	AK_Atomic_Store_Ptr(&Page->Owner, Heap, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_Ptr(&Page->RemoteTail, &Page->Stub, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Page->RemoteHead = &Page->Stub;
+	Page->BlockSize = AK_Slab__Class_Size(SizeClass);
+	Page->BlockCount = (AK_SLAB_PAGE_SIZE-AK_SLAB__HEADER_SIZE)/Page->BlockSize;
+	Page->SizeClass = SizeClass;
+
+	Page->HeapNext = Heap->Pages[SizeClass];
+	if(Page->HeapNext) Page->HeapNext->HeapPrev = Page;
+	Heap->Pages[SizeClass] = Page;
+	return Page;
+}
+
+static void AK_Slab__Unlink_Page(ak_slab__heap* Heap, ak_slab__page* Page) {
+	if(Page->HeapPrev) Page->HeapPrev->HeapNext = Page->HeapNext;
+	else Heap->Pages[Page->SizeClass] = Page->HeapNext;
+	if(Page->HeapNext) Page->HeapNext->HeapPrev = Page->HeapPrev;
+	Page->HeapPrev = NULL;
+	Page->HeapNext = NULL;
+}
+
+static void AK_Slab__Release_Page(ak_slab* Slab, ak_slab__heap* Heap, ak_slab__page* Page) {
+	AK_Slab__Unlink_Page(Heap, Page);
+	AK_Atomic_Store_Ptr(&Page->Owner, NULL, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic__Tagged_Push(&Slab->FreePages.Value, &Page->Next);
+}
+
+static ak_slab__heap* AK_Slab__Get_Heap(ak_slab* Slab) {
+	ak_slab__heap* Heap = (ak_slab__heap*)AK_TLS_Get(&Slab->TLS);
+	if(!Heap) {
+		Heap = (ak_slab__heap*)AK_Atomic__Tagged_Pop(&Slab->AbandonedHeaps);
+		if(!Heap) {
+			Heap = (ak_slab__heap*)AK_Slab__Allocate_Raw_Page(Slab, sizeof(ak_slab__heap));
+			if(!Heap) return NULL;
+			AK_ATOMIC_MEMORY_CLEAR(Heap, sizeof(ak_slab__heap));
+		}
+		AK_TLS_Set(&Slab->TLS, Heap);
+	}
+	return Heap;
+}
+
+/*Looks for a page with free blocks, collecting remote frees on the way, and moves it to the front*/
+static void* AK_Slab__Allocate_Slow(ak_slab* Slab, ak_slab__heap* Heap, uint32_t SizeClass) {
+	ak_slab__page* Page = Heap->Pages[SizeClass];
+	while(Page) {
+		ak_slab__page* Next = Page->HeapNext;
+		AK_Slab__Collect(Page);
+		if(Page->LocalFree || Page->CarvedCount < Page->BlockCount) {
+			if(Page != Heap->Pages[SizeClass]) {
+				AK_Slab__Unlink_Page(Heap, Page);
+				Page->HeapNext = Heap->Pages[SizeClass];
+				if(Page->HeapNext) Page->HeapNext->HeapPrev = Page;
+				Heap->Pages[SizeClass] = Page;
+			}
+			return AK_Slab__Page_Allocate(Page);
+		}
+		Page = Next;
+	}
+
+	Page = AK_Slab__Allocate_Page(Slab, Heap, SizeClass);
+	if(!Page) return NULL;
+	return AK_Slab__Page_Allocate(Page);
+}
+
+static void* AK_Slab__Allocate_Large(size_t Size) {
+	size_t TotalSize = Size+AK_SLAB__LARGE_HEADER_SIZE;
+	uint8_t* Memory = (uint8_t*)AK_OS__Reserve_Memory(TotalSize);
+	AK_ATOMIC_ASSERT(Memory);
+	if(!Memory) return NULL;
+	if(!AK_OS__Commit_Memory(Memory, TotalSize)) {
+		AK_OS__Release_Memory(Memory, TotalSize);
+		return NULL;
+	}
+	*(size_t*)Memory = TotalSize;
+	return Memory+AK_SLAB__LARGE_HEADER_SIZE;
+}
+
+AKATOMICDEF int8_t AK_Slab_Create(ak_slab* Slab, size_t ReserveSize) {
+	AK_ATOMIC_ASSERT(AK_Slab__Size_Class(AK_SLAB_MAX_SIZE) < AK_SLAB__MAX_CLASS_COUNT);
+	AK_ATOMIC_MEMORY_CLEAR(Slab, sizeof(ak_slab));
+	ReserveSize = (ReserveSize+AK_SLAB_PAGE_SIZE-1) & ~((size_t)AK_SLAB_PAGE_SIZE-1);
+	if(ReserveSize < AK_SLAB_PAGE_SIZE) ReserveSize = AK_SLAB_PAGE_SIZE;
+
+	/*One extra page to align the pages to their size*/
+	Slab->Reservation = AK_OS__Reserve_Memory(ReserveSize+AK_SLAB_PAGE_SIZE);
+	AK_ATOMIC_ASSERT(Slab->Reservation);
+	if(!Slab->Reservation) return ak_atomic_false;
+
+	if(!AK_TLS_Create(&Slab->TLS)) {
+		AK_OS__Release_Memory(Slab->Reservation, ReserveSize+AK_SLAB_PAGE_SIZE);
+		Slab->Reservation = NULL;
+		return ak_atomic_false;
+	}
+
+	Slab->Memory = (uint8_t*)(((size_t)Slab->Reservation+AK_SLAB_PAGE_SIZE-1) & ~((size_t)AK_SLAB_PAGE_SIZE-1));
+	Slab->ReserveSize = ReserveSize;
+	AK_OS__Advise_Huge_Pages(Slab->Memory, ReserveSize);
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_Slab_Delete(ak_slab* Slab) {
+	if(Slab->Reservation) {
+		AK_TLS_Delete(&Slab->TLS);
+		AK_OS__Release_Memory(Slab->Reservation, Slab->ReserveSize+AK_SLAB_PAGE_SIZE);
+	}
+	AK_ATOMIC_MEMORY_CLEAR(Slab, sizeof(ak_slab));
+}
+
+AKATOMICDEF void* AK_Slab_Allocate(ak_slab* Slab, size_t Size) {
+	ak_slab__heap* Heap;
+	ak_slab__page* Page;
+	uint32_t SizeClass;
+	if(Size > AK_SLAB_MAX_SIZE) return AK_Slab__Allocate_Large(Size);
+
+	Heap = AK_Slab__Get_Heap(Slab);
+	if(!Heap) return NULL;
+
+	SizeClass = AK_Slab__Size_Class(Size);
+	Page = Heap->Pages[SizeClass];
+	if(Page && (Page->LocalFree || Page->CarvedCount < Page->BlockCount)) {
+		return AK_Slab__Page_Allocate(Page);
+	}
+	return AK_Slab__Allocate_Slow(Slab, Heap, SizeClass);
+}
+
+AKATOMICDEF void AK_Slab_Free(ak_slab* Slab, void* Memory) {
+	ak_slab__page* Page;
+	ak_slab__heap* Heap;
+	if(!Memory) return;
+
+	if((uint8_t*)Memory < Slab->Memory || (uint8_t*)Memory >= Slab->Memory+Slab->ReserveSize) {
+		uint8_t* Header = (uint8_t*)Memory-AK_SLAB__LARGE_HEADER_SIZE;
+		AK_OS__Release_Memory(Header, *(size_t*)Header);
+		return;
+	}
+
+	/*The owner of a page can't change while one of its blocks is alive*/
+	Page = (ak_slab__page*)((size_t)Memory & ~((size_t)AK_SLAB_PAGE_SIZE-1));
+	Heap = (ak_slab__heap*)AK_TLS_Get(&Slab->TLS);
+	if(!Heap || Heap != AK_Atomic_Load_Ptr(&Page->Owner, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+		AK_Slab__Remote_Push(Page, (ak_atomic_ptr*)Memory);
+		return;
+	}
+
+	/*Empty pages other than the one allocations currently use go back to the slab*/
+	*(void**)Memory = Page->LocalFree;
+	Page->LocalFree = Memory;
+	if(!--Page->UsedCount && Page != Heap->Pages[Page->SizeClass]) {
+		AK_Slab__Release_Page(Slab, Heap, Page);
+	}
+}
+
+/*The heap keeps its pages, and their owner stays the heap, so blocks that are still out are freed to
+  whichever thread adopts it*/
+AKATOMICDEF void AK_Slab_Thread_Exit(ak_slab* Slab) {
+	ak_slab__heap* Heap = (ak_slab__heap*)AK_TLS_Get(&Slab->TLS);
+	if(!Heap) return;
+	AK_TLS_Set(&Slab->TLS, NULL);
+	AK_Atomic__Tagged_Push(&Slab->AbandonedHeaps, &Heap->Next);
+}
+
+/*ID pool*/
+#define AK_ID_POOL__FULL ((uint64_t)-1)
+
+static size_t AK_ID_Pool__Memory_Size(ak_id_pool* Pool) {
+	return sizeof(ak_atomic_u64)*((size_t)Pool->WordCount+Pool->SummaryCount);
+}
+
+/*The summary bit is only a hint. Setting it races with a free on the same word, which clears it 
+  after seeing the word full, so the word is checked again after setting the bit. Both sides are 
+  sequentially consistent so at least one of them sees the other*/
+static void AK_ID_Pool__Mark_Full(ak_id_pool* Pool, uint32_t WordIndex) {
+	ak_atomic_u64* Summary = Pool->Summary + (WordIndex / 64);
+	uint64_t Bit = 1ull << (WordIndex % 64);
+	AK_Atomic_Fetch_Or_U64(Summary, Bit, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+	if(AK_Atomic_Load_U64(&Pool->Words[WordIndex], AK_ATOMIC_MEMORY_ORDER_SEQ_CST) != AK_ID_POOL__FULL) {
+		AK_Atomic_Fetch_And_U64(Summary, ~Bit, AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+	}
+}
+
+static uint32_t AK_ID_Pool__Allocate_From_Word(ak_id_pool* Pool, uint32_t WordIndex) {
+	ak_atomic_u64* Word = &Pool->Words[WordIndex];
+	uint64_t Value = AK_Atomic_Load_U64(Word, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	while(Value != AK_ID_POOL__FULL) {
+		uint64_t Bit = 1ull << AK_Atomic__Count_Trailing_Zeros_U64(~Value);
+		uint64_t Old = AK_Atomic_Fetch_Or_U64(Word, Bit, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		if(!(Old & Bit)) {
+			if(Pool->Summary && (Old|Bit) == AK_ID_POOL__FULL) AK_ID_Pool__Mark_Full(Pool, WordIndex);
+			return WordIndex*64 + AK_Atomic__Count_Trailing_Zeros_U64(Bit);
+		}
+
+		/*Somebody else took the bit, the fetch or already returned the latest word*/
+		Value = Old|Bit;
+	}
+	return AK_ID_POOL_INVALID;
+}
+
+/*Hints are stored plus one so that an empty thread local slot means no hint yet. New threads start
+  at scattered words*/
+static uint32_t AK_ID_Pool__Get_Hint(ak_id_pool* Pool) {
+	size_t Hint = (size_t)AK_TLS_Get(&Pool->TLS);
+	if(!Hint) {
+		uint32_t Index = AK_Atomic_Increment_U32(&Pool->NextHint, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		return (uint32_t)(AK_Atomic__Hash_U64(Index) % Pool->WordCount);
+	}
+	return (uint32_t)(Hint-1);
+}
+
+AKATOMICDEF int8_t AK_ID_Pool_Create(ak_id_pool* Pool, uint32_t Capacity) {
+	AK_ATOMIC_ASSERT(Capacity && Capacity < AK_ID_POOL_INVALID);
+	AK_ATOMIC_MEMORY_CLEAR(Pool, sizeof(ak_id_pool));
+
+	Pool->Capacity = Capacity;
+	Pool->WordCount = (uint32_t)(((uint64_t)Capacity+63)/64);
+	if(Capacity >= AK_ID_POOL_SUMMARY_MIN_IDS) Pool->SummaryCount = (Pool->WordCount+63)/64;
+
+	if(!AK_TLS_Create(&Pool->TLS)) return ak_atomic_false;
+	Pool->Words = (ak_atomic_u64*)AK_Atomic__Large_Allocate(AK_ID_Pool__Memory_Size(Pool));
+	AK_ATOMIC_ASSERT(Pool->Words);
+	if(!Pool->Words) {
+		AK_TLS_Delete(&Pool->TLS);
+		return ak_atomic_false;
+	}
+
+	AK_ATOMIC_MEMORY_CLEAR(Pool->Words, AK_ID_Pool__Memory_Size(Pool));
+	if(Pool->SummaryCount) Pool->Summary = Pool->Words + Pool->WordCount;
+
+	/*IDs past the capacity and summary bits past the last word are permanently taken*/
+	if(Capacity % 64) {
+		AK_Atomic_Store_U64(&Pool->Words[Pool->WordCount-1], ~((1ull << (Capacity % 64))-1), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	if(Pool->Summary && (Pool->WordCount % 64)) {
+		AK_Atomic_Store_U64(&Pool->Summary[Pool->SummaryCount-1], ~((1ull << (Pool->WordCount % 64))-1), AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	return ak_atomic_true;
+}
+
+AKATOMICDEF void AK_ID_Pool_Delete(ak_id_pool* Pool) {
+	if(Pool->Words) {
+		AK_Atomic__Large_Free(Pool->Words, AK_ID_Pool__Memory_Size(Pool));
+		AK_TLS_Delete(&Pool->TLS);
+	}
+	AK_ATOMIC_MEMORY_CLEAR(Pool, sizeof(ak_id_pool));
+}
+
+AKATOMICDEF uint32_t AK_ID_Pool_Allocate(ak_id_pool* Pool) {
+	uint32_t Hint = AK_ID_Pool__Get_Hint(Pool);
+	uint32_t ID = AK_ID_Pool__Allocate_From_Word(Pool, Hint);
+	uint32_t i;
+
+	if(ID == AK_ID_POOL_INVALID) {
+		if(Pool->Summary) {
+			/*Only words whose summary bit is clear can have a free ID*/
+			uint32_t Start = Hint / 64;
+			for(i = 0; i < Pool->SummaryCount && ID == AK_ID_POOL_INVALID; i++) {
+				uint32_t SummaryIndex = (Start+i) % Pool->SummaryCount;
+				uint64_t Free = ~AK_Atomic_Load_U64(&Pool->Summary[SummaryIndex], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				while(Free && ID == AK_ID_POOL_INVALID) {
+					Hint = SummaryIndex*64 + AK_Atomic__Count_Trailing_Zeros_U64(Free);
+					ID = AK_ID_Pool__Allocate_From_Word(Pool, Hint);
+					Free &= Free-1;
+				}
+			}
+		} else {
+			for(i = 1; i < Pool->WordCount && ID == AK_ID_POOL_INVALID; i++) {
+				Hint = (Hint+1) % Pool->WordCount;
+				ID = AK_ID_Pool__Allocate_From_Word(Pool, Hint);
+			}
+		}
+	}
+
+	if(ID != AK_ID_POOL_INVALID) AK_TLS_Set(&Pool->TLS, (void*)(size_t)(Hint+1));
+	return ID;
+}
+
+AKATOMICDEF void AK_ID_Pool_Free(ak_id_pool* Pool, uint32_t ID) {
+	uint32_t WordIndex = ID / 64;
+	uint64_t Bit = 1ull << (ID % 64);
+	uint64_t Old;
+	AK_ATOMIC_ASSERT(ID < Pool->Capacity);
+
+	Old = AK_Atomic_Fetch_And_U64(&Pool->Words[WordIndex], ~Bit, Pool->Summary ? AK_ATOMIC_MEMORY_ORDER_SEQ_CST : AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	/*Double free*/
+	AK_ATOMIC_ASSERT(Old & Bit);
+	if(Pool->Summary && Old == AK_ID_POOL__FULL) {
+		AK_Atomic_Fetch_And_U64(&Pool->Summary[WordIndex / 64], ~(1ull << (WordIndex % 64)), AK_ATOMIC_MEMORY_ORDER_SEQ_CST);
+	}
+}
+
+AKATOMICDEF int8_t AK_ID_Pool_Is_Allocated(ak_id_pool* Pool, uint32_t ID) {
+	AK_ATOMIC_ASSERT(ID < Pool->Capacity);
+	return (AK_Atomic_Load_U64(&Pool->Words[ID / 64], AK_ATOMIC_MEMORY_ORDER_ACQUIRE) >> (ID % 64)) & 1;
+}
+
+/*Fiber job system*/
+#ifdef AK_ATOMIC_FIBERS
+
+typedef enum {
+	AK_FIBER_STATE_RUNNING,
+	AK_FIBER_STATE_WAITING,
+	AK_FIBER_STATE_FINISHED
+} ak_fiber_state;
+
+typedef struct ak_fiber ak_fiber;
+struct ak_fiber {
+	void* 				 StackPointer;
+	ak_fiber_job_system* JobSystem;
+	ak_job_entry 		 Job;
+	ak_atomic_u32* 		 WaitCounter;
+	ak_fiber* 			 NextWaiter;
+	ak_fiber_state 		 State;
+	uint32_t 			 Padding;
+};
+
+typedef struct {
+	ak_fiber_job_system* JobSystem;
+	ak_job_worker* 		 JobWorker;
+	ak_fiber* 			 CurrentFiber;
+	void* 				 SchedulerStackPointer;
+} ak_fiber_worker;
+
+#define AK_FIBER_JOB_SYSTEM__WAIT_BUCKET_COUNT 64
+
+/*Parked fibers are chained off a bucket picked by hashing the address of the counter they wait
+  on, so whoever drops the counter to zero only has to look at a single short list*/
+typedef struct {
+	ak_atomic_u32 Lock;
+	uint32_t 	  Padding;
+	ak_fiber* 	  Head;
+} ak_fiber_wait_bucket;
+
+/*Free and ready fibers are tracked with the same bounded queue the job system uses, with the
+  fiber stored in the entry's user data. Both queues can hold every fiber so they never fill up*/
+struct ak_fiber_job_system {
+	ak_job_node 		 Node;
+	ak_job_queue 		 FreeFibers;
+	ak_job_queue 		 ReadyFibers;
+	ak_fiber_wait_bucket WaitBuckets[AK_FIBER_JOB_SYSTEM__WAIT_BUCKET_COUNT];
+	ak_lw_semaphore  	 Semaphore;
+	ak_atomic_u32 		 IsRunning;
+	uint32_t 			 WorkerCount;
+	uint32_t 			 FiberCount;
+	ak_atomic_u32 		 WaiterCount;
+	ak_job_worker* 		 Workers;
+	ak_fiber_worker* 	 FiberWorkers;
+	ak_fiber* 			 Fibers;
+	uint8_t* 			 StackMemory;
+	size_t 				 StackMemorySize;
+	ak_tls 				 WorkerTLS;
+};
+
+/*Saves the callee saved registers (System V x86-64), mxcsr and the x87 control word on the current
+  stack, stores the stack pointer in SaveStackPointer and then restores everything from
+  LoadStackPointer. Returning pops into whichever fiber owned that stack. The parameters are only
+  touched through rdi and rsi so they are marked unused*/
+static __attribute__((naked, noinline)) void AK_Fiber__Switch(void** SaveStackPointer __attribute__((unused)), 
+															  void* LoadStackPointer __attribute__((unused))) {
+	__asm__ volatile(
+		"pushq %rbp\n\t"
+		"pushq %rbx\n\t"
+		"pushq %r12\n\t"
+		"pushq %r13\n\t"
+		"pushq %r14\n\t"
+		"pushq %r15\n\t"
+		"subq $8, %rsp\n\t"
+		"stmxcsr (%rsp)\n\t"
+		"fnstcw 4(%rsp)\n\t"
+		"movq %rsp, (%rdi)\n\t"
+		"movq %rsi, %rsp\n\t"
+		"ldmxcsr (%rsp)\n\t"
+		"fldcw 4(%rsp)\n\t"
+		"addq $8, %rsp\n\t"
+		"popq %r15\n\t"
+		"popq %r14\n\t"
+		"popq %r13\n\t"
+		"popq %r12\n\t"
+		"popq %rbx\n\t"
+		"popq %rbp\n\t"
+		"ret\n\t"
+	);
+}
+
+/*First code a new fiber runs. The fiber is passed in rbx and the entry point in r12 (see
+  AK_Fiber__Init_Stack)*/
+static __attribute__((naked, noinline)) void AK_Fiber__Trampoline(void) {
+	__asm__ volatile(
+		"movq %rbx, %rdi\n\t"
+		"jmpq *%r12\n\t"
+	);
+}
+
+static ak_fiber* AK_Fiber_Job_System__Dequeue_Fiber(ak_job_queue* Queue) {
+	ak_job_entry Entry;
+	if(!AK_Job_Queue__Dequeue(Queue, &Entry)) return NULL;
+	return (ak_fiber*)Entry.UserData;
+}
+
+static void AK_Fiber_Job_System__Enqueue_Fiber(ak_job_queue* Queue, ak_fiber* Fiber) {
+	ak_job_entry Entry;
+	int8_t Result;
+	Entry.Callback = NULL;
+	Entry.UserData = Fiber;
+	Entry.Counter = NULL;
+	Result = AK_Job_Queue__Enqueue(Queue, &Entry);
+	AK_ATOMIC_ASSERT(Result);
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Result);
+}
+
+static ak_fiber_wait_bucket* AK_Fiber_Job_System__Lock_Bucket(ak_fiber_job_system* JobSystem, ak_atomic_u32* Counter) {
+	uint64_t Index = AK_Atomic__Hash_U64((uint64_t)(size_t)Counter) & (AK_FIBER_JOB_SYSTEM__WAIT_BUCKET_COUNT-1);
+	ak_fiber_wait_bucket* Bucket = JobSystem->WaitBuckets + Index;
+	uint32_t SpinCount = 0;
+	while(AK_Atomic_Exchange_U32(&Bucket->Lock, 1, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+		while(AK_Atomic_Load_U32(&Bucket->Lock, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+			if(++SpinCount < 64) {
+				AK_ATOMIC__SPIN_PAUSE();
+			} else {
+				AK_Thread_Yield();
+			}
+		}
+	}
+	return Bucket;
+}
+
+static void AK_Fiber_Job_System__Unlock_Bucket(ak_fiber_wait_bucket* Bucket) {
+	AK_Atomic_Store_U32(&Bucket->Lock, 0, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/*Called by the scheduler once a waiting fiber is off its stack. The counter is rechecked under the
+  bucket lock so a wake that happened while the fiber was switching out can't be missed*/
+static void AK_Fiber_Job_System__Park(ak_fiber_job_system* JobSystem, ak_fiber* Fiber) {
+	ak_fiber_wait_bucket* Bucket = AK_Fiber_Job_System__Lock_Bucket(JobSystem, Fiber->WaitCounter);
+	int8_t IsReady = AK_Atomic_Load_U32(Fiber->WaitCounter, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 0;
+	if(!IsReady) {
+		Fiber->NextWaiter = Bucket->Head;
+		Bucket->Head = Fiber;
+	}
+	AK_Fiber_Job_System__Unlock_Bucket(Bucket);
+
+	if(IsReady) {
+		AK_Fiber_Job_System__Enqueue_Fiber(&JobSystem->ReadyFibers, Fiber);
+		AK_LW_Semaphore_Increment(&JobSystem->Semaphore);
+	}
+}
+
+/*Moves every fiber parked on the counter to the ready queue and wakes a worker for each. The
+  counter is only used as a key and never dereferenced since its owner may already be gone*/
+static void AK_Fiber_Job_System__Wake(ak_fiber_job_system* JobSystem, ak_atomic_u32* Counter) {
+	ak_fiber_wait_bucket* Bucket = AK_Fiber_Job_System__Lock_Bucket(JobSystem, Counter);
+	ak_fiber** Link = &Bucket->Head;
+	int32_t WakeCount = 0;
+	while(*Link) {
+		ak_fiber* Fiber = *Link;
+		if(Fiber->WaitCounter == Counter) {
+			*Link = Fiber->NextWaiter;
+			Fiber->NextWaiter = NULL;
+			AK_Fiber_Job_System__Enqueue_Fiber(&JobSystem->ReadyFibers, Fiber);
+			WakeCount++;
+		} else {
+			Link = &Fiber->NextWaiter;
+		}
+	}
+	AK_Fiber_Job_System__Unlock_Bucket(Bucket);
+
+	if(WakeCount) AK_LW_Semaphore_Add(&JobSystem->Semaphore, WakeCount);
+}
+
+static void AK_Fiber__Execute_Inline(ak_fiber_job_system* JobSystem, const ak_job_entry* Entry) {
+	ak_fiber_job_callback_func* Callback = (ak_fiber_job_callback_func*)Entry->Callback;
+	Callback(JobSystem, Entry->UserData);
+	if(Entry->Counter) AK_Fiber_Job_System_Decrement(JobSystem, Entry->Counter);
+}
+
+/*Fibers loop forever. Once a job finishes the fiber switches back to whatever worker is running it
+  and the next time it is handed out it picks up the new job from here*/
+static void AK_Fiber__Main(ak_fiber* Fiber) {
+	ak_fiber_job_system* JobSystem = Fiber->JobSystem;
+	for(;;) {
+		ak_fiber_worker* Worker;
+		AK_Fiber__Execute_Inline(JobSystem, &Fiber->Job);
+		Fiber->State = AK_FIBER_STATE_FINISHED;
+
+		/*The fiber may have waited and resumed on another thread, so the worker must be fetched again*/
+		Worker = (ak_fiber_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+		AK_Fiber__Switch(&Fiber->StackPointer, Worker->SchedulerStackPointer);
+	}
+}
+
+static void AK_Fiber__Init_Stack(ak_fiber* Fiber, uint8_t* StackTop) {
+	uint64_t* Stack = (uint64_t*)((size_t)StackTop & ~(size_t)15);
+	*--Stack = 0; 									 /*Fake return address, keeps the entry 16 byte aligned*/
+	*--Stack = (uint64_t)(size_t)AK_Fiber__Trampoline; /*Return address*/
+	*--Stack = 0; 									 /*rbp*/
+	*--Stack = (uint64_t)(size_t)Fiber; 			 /*rbx*/
+	*--Stack = (uint64_t)(size_t)AK_Fiber__Main; 	 /*r12*/
+	*--Stack = 0; 									 /*r13*/
+	*--Stack = 0; 									 /*r14*/
+	*--Stack = 0; 									 /*r15*/
+	*--Stack = ((uint64_t)0x037F << 32) | 0x1F80; 	 /*Default x87 control word and mxcsr*/
+	Fiber->StackPointer = Stack;
+}
+
+/*Resumed fibers are preferred over new jobs so dependency chains drain before new work piles up.
+  When the fiber pool is exhausted the job runs directly on the worker's own stack*/
+static int8_t AK_Fiber_Worker__Run_Next(ak_fiber_worker* Worker) {
+	ak_fiber_job_system* JobSystem = Worker->JobSystem;
+	ak_fiber* Fiber = AK_Fiber_Job_System__Dequeue_Fiber(&JobSystem->ReadyFibers);
+
+	if(!Fiber) {
+		ak_job_entry Entry;
+		if(!AK_Job__Get_Entry(&JobSystem->Node, 1, JobSystem->Workers, Worker->JobWorker, &Entry)) {
+			return ak_atomic_false;
+		}
+
+		Fiber = AK_Fiber_Job_System__Dequeue_Fiber(&JobSystem->FreeFibers);
+		if(!Fiber) {
+			AK_Fiber__Execute_Inline(JobSystem, &Entry);
+			return ak_atomic_true;
+		}
+		Fiber->Job = Entry;
+	}
+
+	Fiber->State = AK_FIBER_STATE_RUNNING;
+	Worker->CurrentFiber = Fiber;
+	AK_Fiber__Switch(&Worker->SchedulerStackPointer, Fiber->StackPointer);
+	Worker->CurrentFiber = NULL;
+
+	/*The fiber is off its stack now so it is safe to hand it to other workers*/
+	if(Fiber->State == AK_FIBER_STATE_WAITING) {
+		AK_Fiber_Job_System__Park(JobSystem, Fiber);
+	} else {
+		AK_Fiber_Job_System__Enqueue_Fiber(&JobSystem->FreeFibers, Fiber);
+	}
+
+	return ak_atomic_true;
+}
+
+/*Every queued job and every fiber made ready posts the semaphore once, so workers only ever sleep
+  on it and never have to poll*/
+static AK_THREAD_CALLBACK_DEFINE(AK_Fiber_Job_System__Worker_Proc) {
+	ak_fiber_worker* Worker = (ak_fiber_worker*)UserData;
+	ak_fiber_job_system* JobSystem = Worker->JobSystem;
+	AK_ATOMIC__UNREFERENCED_PARAMETER(Thread);
+
+	AK_TLS_Set(&JobSystem->WorkerTLS, Worker);
+	while(AK_Atomic_Load_U32(&JobSystem->IsRunning, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) {
+		AK_LW_Semaphore_Decrement(&JobSystem->Semaphore);
+		AK_Fiber_Worker__Run_Next(Worker);
+	}
+
+	return 0;
+}
+
+/*Frees everything besides the semaphore, the tls slot and the threads. Safe to call on a partially
+  created job system since the queues and deques are zeroed until they are created*/
+static void AK_Fiber_Job_System__Release(ak_fiber_job_system* JobSystem) {
+	uint32_t i;
+	if(JobSystem->Workers) {
+		for(i = 0; i < JobSystem->WorkerCount; i++) {
+			AK_Job_Deque__Delete(&JobSystem->Workers[i].Deque);
+		}
+		AK_ATOMIC_FREE(JobSystem->Workers);
+	}
+	if(JobSystem->StackMemory) munmap(JobSystem->StackMemory, JobSystem->StackMemorySize);
+	if(JobSystem->Fibers) AK_ATOMIC_FREE(JobSystem->Fibers);
+	if(JobSystem->FiberWorkers) AK_ATOMIC_FREE(JobSystem->FiberWorkers);
+	AK_Job_Queue__Delete(&JobSystem->Node.Queue);
+	AK_Job_Queue__Delete(&JobSystem->FreeFibers);
+	AK_Job_Queue__Delete(&JobSystem->ReadyFibers);
+	AK_ATOMIC_FREE(JobSystem);
+}
+
+AKATOMICDEF ak_fiber_job_system* AK_Fiber_Job_System_Create(uint32_t ThreadCount, uint32_t FiberCount, uint32_t FiberStackSize) {
+	ak_fiber_job_system* JobSystem;
+	uint32_t i, QueueCapacity;
+	size_t PageSize, StackSize;
+	int8_t IsValid;
+
+	if(!ThreadCount) ThreadCount = AK_Get_Effective_Processor_Thread_Count();
+	if(!ThreadCount) ThreadCount = 1;
+	if(!FiberCount) FiberCount = AK_FIBER_JOB_SYSTEM_DEFAULT_FIBER_COUNT;
+	if(!FiberStackSize) FiberStackSize = AK_FIBER_JOB_SYSTEM_DEFAULT_STACK_SIZE;
+
+	PageSize = (size_t)sysconf(_SC_PAGESIZE);
+	StackSize = ((size_t)FiberStackSize + PageSize-1) & ~(PageSize-1);
+
+	JobSystem = (ak_fiber_job_system*)AK_ATOMIC_MALLOC(sizeof(ak_fiber_job_system));
+	AK_ATOMIC_ASSERT(JobSystem);
+	if(!JobSystem) return NULL;
+	AK_ATOMIC_MEMORY_CLEAR(JobSystem, sizeof(ak_fiber_job_system));
+
+	JobSystem->WorkerCount = ThreadCount;
+	JobSystem->FiberCount = FiberCount;
+	JobSystem->Node.WorkerCount = ThreadCount;
+	JobSystem->Workers = (ak_job_worker*)AK_ATOMIC_MALLOC(sizeof(ak_job_worker)*ThreadCount);
+	JobSystem->FiberWorkers = (ak_fiber_worker*)AK_ATOMIC_MALLOC(sizeof(ak_fiber_worker)*ThreadCount);
+	JobSystem->Fibers = (ak_fiber*)AK_ATOMIC_MALLOC(sizeof(ak_fiber)*FiberCount);
+
+	/*Every fiber stack gets a guard page underneath it so an overflow faults instead of silently
+	  corrupting the neighbouring fiber*/
+	JobSystem->StackMemorySize = (StackSize+PageSize)*FiberCount;
+	JobSystem->StackMemory = (uint8_t*)mmap(NULL, JobSystem->StackMemorySize, PROT_READ|PROT_WRITE,
+											MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if(JobSystem->StackMemory == (uint8_t*)MAP_FAILED) JobSystem->StackMemory = NULL;
+
+	QueueCapacity = AK_Job_System__Round_Capacity(FiberCount);
+	IsValid = JobSystem->Workers && JobSystem->FiberWorkers && JobSystem->Fibers && JobSystem->StackMemory;
+	if(IsValid) {
+		AK_ATOMIC_MEMORY_CLEAR(JobSystem->Workers, sizeof(ak_job_worker)*ThreadCount);
+		AK_ATOMIC_MEMORY_CLEAR(JobSystem->FiberWorkers, sizeof(ak_fiber_worker)*ThreadCount);
+		AK_ATOMIC_MEMORY_CLEAR(JobSystem->Fibers, sizeof(ak_fiber)*FiberCount);
+		IsValid = AK_Job_Queue__Create(&JobSystem->Node.Queue, AK_JOB_SYSTEM_DEFAULT_QUEUE_CAPACITY, -1) &&
+				  AK_Job_Queue__Create(&JobSystem->FreeFibers, QueueCapacity, -1) &&
+				  AK_Job_Queue__Create(&JobSystem->ReadyFibers, QueueCapacity, -1);
+	}
+
+	for(i = 0; IsValid && i < ThreadCount; i++) {
+		ak_job_worker* JobWorker = JobSystem->Workers + i;
+		ak_fiber_worker* Worker = JobSystem->FiberWorkers + i;
+		JobWorker->Index = i;
+		JobWorker->RandomState = 0x9E3779B9u*(i+1);
+		Worker->JobSystem = JobSystem;
+		Worker->JobWorker = JobWorker;
+		IsValid = AK_Job_Deque__Create(&JobWorker->Deque, AK_JOB_SYSTEM_DEFAULT_QUEUE_CAPACITY, -1);
+	}
+
+	/*Without the guard page a stack overflow would silently corrupt the neighbouring fiber, so
+	  failing to protect it is treated like any other allocation failure*/
+	for(i = 0; IsValid && i < FiberCount; i++) {
+		ak_fiber* Fiber = JobSystem->Fibers + i;
+		uint8_t* Guard = JobSystem->StackMemory + (StackSize+PageSize)*i;
+		IsValid = mprotect(Guard, PageSize, PROT_NONE) == 0;
+		Fiber->JobSystem = JobSystem;
+		AK_Fiber__Init_Stack(Fiber, Guard+PageSize+StackSize);
+		AK_Fiber_Job_System__Enqueue_Fiber(&JobSystem->FreeFibers, Fiber);
+	}
+
+	if(!IsValid) {
+		AK_ATOMIC_ASSERT(!"Failed to allocate fiber job system");
+		AK_Fiber_Job_System__Release(JobSystem);
+		return NULL;
+	}
+
+	if(!AK_LW_Semaphore_Create(&JobSystem->Semaphore, 0)) {
+		AK_ATOMIC_ASSERT(!"Failed to create the fiber job system semaphore");
+		AK_Fiber_Job_System__Release(JobSystem);
+		return NULL;
+	}
+
+	if(!AK_TLS_Create(&JobSystem->WorkerTLS)) {
+		AK_ATOMIC_ASSERT(!"Failed to create the fiber job system tls");
+		AK_LW_Semaphore_Delete(&JobSystem->Semaphore);
+		AK_Fiber_Job_System__Release(JobSystem);
+		return NULL;
+	}
+
+	AK_Atomic_Store_U32(&JobSystem->IsRunning, ak_atomic_true, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < ThreadCount; i++) {
+		JobSystem->Workers[i].Thread = AK_Thread_Create(AK_Fiber_Job_System__Worker_Proc, JobSystem->FiberWorkers + i);
+		if(!JobSystem->Workers[i].Thread) {
+			/*Delete only joins the threads that were actually started*/
+			AK_ATOMIC_ASSERT(!"Failed to create fiber job system thread");
+			AK_Fiber_Job_System_Delete(JobSystem);
+			return NULL;
+		}
+	}
+
+	return JobSystem;
+}
+
+AKATOMICDEF void AK_Fiber_Job_System_Delete(ak_fiber_job_system* JobSystem) {
+	uint32_t i;
+	AK_ATOMIC_ASSERT(JobSystem);
+	if(!JobSystem) return;
+
+	AK_Atomic_Store_U32(&JobSystem->IsRunning, ak_atomic_false, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	AK_LW_Semaphore_Add(&JobSystem->Semaphore, (int32_t)JobSystem->WorkerCount);
+
+	for(i = 0; i < JobSystem->WorkerCount; i++) {
+		ak_job_worker* JobWorker = JobSystem->Workers + i;
+		if(JobWorker->Thread) AK_Thread_Delete(JobWorker->Thread);
+	}
+
+	AK_TLS_Delete(&JobSystem->WorkerTLS);
+	AK_LW_Semaphore_Delete(&JobSystem->Semaphore);
+	AK_Fiber_Job_System__Release(JobSystem);
+}
+
+static int8_t AK_Fiber_Job_System__Push(ak_fiber_job_system* JobSystem, const ak_job_entry* Entry) {
+	ak_fiber_worker* Worker = (ak_fiber_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+	if(Worker && AK_Job_Deque__Push(&Worker->JobWorker->Deque, Entry)) return ak_atomic_true;
+	return AK_Job_Queue__Enqueue(&JobSystem->Node.Queue, Entry);
+}
+
+AKATOMICDEF void AK_Fiber_Job_System_Submit(ak_fiber_job_system* JobSystem, ak_fiber_job_callback_func* Callback, void* UserData, ak_atomic_u32* Counter) {
+	ak_job_entry Entry;
+	Entry.Callback = (ak_job_callback_func*)Callback;
+	Entry.UserData = UserData;
+	Entry.Counter = Counter;
+
+	if(Counter) AK_Atomic_Increment_U32(Counter, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	if(AK_Fiber_Job_System__Push(JobSystem, &Entry)) {
+		AK_LW_Semaphore_Increment(&JobSystem->Semaphore);
+	} else {
+		AK_Fiber__Execute_Inline(JobSystem, &Entry);
+	}
+}
+
+AKATOMICDEF void AK_Fiber_Job_System_Submit_Batch(ak_fiber_job_system* JobSystem, const ak_fiber_job* Jobs, uint32_t JobCount, ak_atomic_u32* Counter) {
+	uint32_t i, QueuedCount = 0;
+	ak_job_entry Entry;
+
+	if(!JobCount) return;
+	if(Counter) AK_Atomic_Fetch_Add_U32(Counter, JobCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	Entry.Counter = Counter;
+	for(i = 0; i < JobCount; i++) {
+		Entry.Callback = (ak_job_callback_func*)Jobs[i].Callback;
+		Entry.UserData = Jobs[i].UserData;
+		if(AK_Fiber_Job_System__Push(JobSystem, &Entry)) {
+			QueuedCount++;
+		} else {
+			if(QueuedCount) {
+				AK_LW_Semaphore_Add(&JobSystem->Semaphore, (int32_t)QueuedCount);
+				QueuedCount = 0;
+			}
+			AK_Fiber__Execute_Inline(JobSystem, &Entry);
+		}
+	}
+
+	if(QueuedCount) AK_LW_Semaphore_Add(&JobSystem->Semaphore, (int32_t)QueuedCount);
+}
+
+AKATOMICDEF void AK_Fiber_Job_System_Decrement(ak_fiber_job_system* JobSystem, ak_atomic_u32* Counter) {
+	if(AK_Job__Decrement_Counter(&JobSystem->WaiterCount, Counter)) {
+		AK_Fiber_Job_System__Wake(JobSystem, Counter);
+	}
+}
+
+/*Inside of a fiber the wait parks the fiber and hands the worker back to the scheduler. Anywhere
+  else (outside threads, or jobs that ran inline because the fiber pool was empty) we can't switch
+  stacks so we help run jobs until the counter reaches zero. Outside threads park once there is 
+  nothing left to help with*/
+AKATOMICDEF void AK_Fiber_Job_System_Wait(ak_fiber_job_system* JobSystem, ak_atomic_u32* Counter) {
+	ak_fiber_worker* Worker = (ak_fiber_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+	if(Worker && Worker->CurrentFiber) {
+		while(AK_Atomic_Load_U32(Counter, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != 0) {
+			ak_fiber* Fiber = Worker->CurrentFiber;
+			Fiber->State = AK_FIBER_STATE_WAITING;
+			Fiber->WaitCounter = Counter;
+			AK_Fiber__Switch(&Fiber->StackPointer, Worker->SchedulerStackPointer);
+			Worker = (ak_fiber_worker*)AK_TLS_Get(&JobSystem->WorkerTLS);
+		}
+	} else {
+		ak_job_worker* JobWorker = Worker ? Worker->JobWorker : NULL;
+		uint32_t IdleCount = 0;
+		ak_job_entry Entry;
+		while(AK_Atomic_Load_U32(Counter, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != 0) {
+			if(AK_Job__Get_Entry(&JobSystem->Node, 1, JobSystem->Workers, JobWorker, &Entry)) {
+				AK_Fiber__Execute_Inline(JobSystem, &Entry);
+				IdleCount = 0;
+			} else if(++IdleCount < 64) {
+				AK_ATOMIC__SPIN_PAUSE();
+			} else if(Worker) {
+				AK_Thread_Yield();
+			} else {
+				AK_Job__Park(&JobSystem->WaiterCount, Counter);
+				IdleCount = 0;
+			}
+		}
+	}
+}
+
+#endif
+
 #ifdef AK_ATOMIC_COMPILER_MSVC
 #pragma warning(pop)
 #endif
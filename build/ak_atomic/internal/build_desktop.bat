@@ -121,6 +121,14 @@ if "%compiler%"=="msvc" (
 	set compile_tests[!i!]=/std:c++20 /Zc:__cplusplus /D_HAS_EXCEPTIONS=0 %test_path%\ak_atomic_unit_test.cpp
 	set compile_output[!i!]=ak_atomic_cpp20_unit_test.exe
 	set /a i=i+1
+
+	set compile_tests[!i!]=/std:c11 /Tc %test_path%\ak_atomic_benchmark.c
+	set compile_output[!i!]=ak_atomic_c11_benchmark.exe
+	set /a i=i+1
+
+	set compile_tests[!i!]=/std:c++14 /Zc:__cplusplus /D_HAS_EXCEPTIONS=0 %test_path%\ak_atomic_benchmark.cpp
+	set compile_output[!i!]=ak_atomic_cpp14_benchmark.exe
+	set /a i=i+1
 )
 
 if "%compiler%"=="clang" (
@@ -151,6 +159,14 @@ if "%compiler%"=="clang" (
 	set compile_tests[!i!]=-std=c++20 %test_path%\ak_atomic_unit_test.cpp
 	set compile_output[!i!]=ak_atomic_cpp20_unit_test.exe
 	set /a i=i+1
+
+	set compile_tests[!i!]=-std=c11 %test_path%\ak_atomic_benchmark.c
+	set compile_output[!i!]=ak_atomic_c11_benchmark.exe
+	set /a i=i+1
+
+	set compile_tests[!i!]=-std=c++14 %test_path%\ak_atomic_benchmark.cpp
+	set compile_output[!i!]=ak_atomic_cpp14_benchmark.exe
+	set /a i=i+1
 )
 
 if "%compiler%"=="intel" (
@@ -181,6 +197,14 @@ if "%compiler%"=="intel" (
 	set compile_tests[!i!]=-Qstd=c++20 %test_path%\ak_atomic_unit_test.cpp
 	set compile_output[!i!]=ak_atomic_cpp20_unit_test.exe
 	set /a i=i+1
+
+	set compile_tests[!i!]=-Qstd=c11 %test_path%\ak_atomic_benchmark.c
+	set compile_output[!i!]=ak_atomic_c11_benchmark.exe
+	set /a i=i+1
+
+	set compile_tests[!i!]=-Qstd=c++14 %test_path%\ak_atomic_benchmark.cpp
+	set compile_output[!i!]=ak_atomic_cpp14_benchmark.exe
+	set /a i=i+1
 )
 
 echo %compile_flags%
@@ -101,6 +101,14 @@ if [ $compiler == "clang" ]; then
     compile_std+=("-std=c++20 -lstdc++")
     compile_tests+=("$test_path/ak_atomic_unit_test.cpp")
 	compile_output+=("ak_atomic_cpp20_unit_test")
+
+    compile_std+=("-std=c11")
+    compile_tests+=("$test_path/ak_atomic_benchmark.c")
+	compile_output+=("ak_atomic_c11_benchmark")
+
+    compile_std+=("-std=c++11 -lstdc++")
+    compile_tests+=("$test_path/ak_atomic_benchmark.cpp")
+	compile_output+=("ak_atomic_cpp11_benchmark")
 fi
 
 pushd $bin_path
@@ -0,0 +1,325 @@
+#include "ak_atomic_test_header.h"
+
+#include <stdio.h>
+
+/*Compares AK_Parallel_For against splitting the range into one static chunk per worker. Uniform
+  loops should be about even, skewed loops are where static partitioning loses since one chunk 
+  holds most of the work, and tiny loop bodies show the overhead of splitting. Afterwards the same 
+  workloads are run on a plain pool and a numa aware pool. Single node machines get a fake two node 
+  topology so the numa code paths still run, there the numbers just show the overhead. Last, 
+  threads hammer a single atomic counter, a per cpu counter, a sharded and an adaptive counter*/
+
+#define BENCHMARK_ITERATIONS 10
+
+typedef enum {
+	BENCHMARK_WORKLOAD_UNIFORM,
+	BENCHMARK_WORKLOAD_SKEWED,
+	BENCHMARK_WORKLOAD_TINY,
+	BENCHMARK_WORKLOAD_COUNT
+} benchmark_workload;
+
+static const char* G_Workload_Names[BENCHMARK_WORKLOAD_COUNT] = {
+	"uniform",
+	"skewed",
+	"tiny"
+};
+
+static const uint64_t G_Workload_Counts[BENCHMARK_WORKLOAD_COUNT] = {
+	1 << 16,
+	1 << 12,
+	1 << 24
+};
+
+static const uint64_t G_Workload_Grains[BENCHMARK_WORKLOAD_COUNT] = {
+	64,
+	1,
+	4096
+};
+
+typedef struct {
+	benchmark_workload Workload;
+	uint32_t* 		   Values;
+	uint64_t 		   Count;
+} benchmark_data;
+
+static uint32_t Benchmark_Work(uint32_t Value, uint64_t Iterations) {
+	uint64_t i;
+	for(i = 0; i < Iterations; i++) {
+		Value = Value*1664525u + 1013904223u;
+	}
+	return Value;
+}
+
+static AK_PARALLEL_FOR_CALLBACK_DEFINE(Benchmark_Range) {
+	benchmark_data* Data = (benchmark_data*)UserData;
+	uint64_t i;
+	switch(Data->Workload) {
+		case BENCHMARK_WORKLOAD_UNIFORM: {
+			for(i = Begin; i < End; i++) Data->Values[i] = Benchmark_Work(Data->Values[i], 256);
+		} break;
+
+		case BENCHMARK_WORKLOAD_SKEWED: {
+			/*The last eighth of the range holds most of the work*/
+			for(i = Begin; i < End; i++) {
+				uint64_t Iterations = (i >= Data->Count-Data->Count/8) ? 32768 : 64;
+				Data->Values[i] = Benchmark_Work(Data->Values[i], Iterations);
+			}
+		} break;
+
+		case BENCHMARK_WORKLOAD_TINY: {
+			for(i = Begin; i < End; i++) Data->Values[i] = Data->Values[i]*2 + 1;
+		} break;
+
+		default: break;
+	}
+}
+
+typedef struct {
+	benchmark_data* Data;
+	uint64_t 		Begin;
+	uint64_t 		End;
+} benchmark_static_chunk;
+
+static AK_JOB_CALLBACK_DEFINE(Benchmark_Static_Job) {
+	benchmark_static_chunk* Chunk = (benchmark_static_chunk*)UserData;
+	Benchmark_Range(Chunk->Begin, Chunk->End, Chunk->Data);
+	(void)JobSystem;
+}
+
+static void Benchmark_Static_For(ak_job_system* JobSystem, benchmark_data* Data, benchmark_static_chunk* Chunks, ak_job* Jobs) {
+	uint32_t i, ChunkCount = AK_Job_System_Get_Thread_Count(JobSystem);
+	ak_atomic_u32 Counter;
+
+	for(i = 0; i < ChunkCount; i++) {
+		Chunks[i].Data = Data;
+		Chunks[i].Begin = (Data->Count*i)/ChunkCount;
+		Chunks[i].End = (Data->Count*(i+1))/ChunkCount;
+		Jobs[i].Callback = Benchmark_Static_Job;
+		Jobs[i].UserData = Chunks + i;
+	}
+
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Job_System_Submit_Batch(JobSystem, Jobs, ChunkCount, &Counter);
+	AK_Job_System_Wait(JobSystem, &Counter);
+}
+
+static double Benchmark_Elapsed_Ms(uint64_t Start) {
+	uint64_t End = AK_Query_Performance_Counter();
+	return (double)(End-Start)*1000.0 / (double)AK_Query_Performance_Frequency();
+}
+
+static double Benchmark_Adaptive_Ms(ak_job_system* JobSystem, benchmark_data* Data, uint64_t Grain) {
+	double Result = 1e30;
+	uint32_t i;
+	for(i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		double Elapsed;
+		uint64_t Start = AK_Query_Performance_Counter();
+		AK_Parallel_For(JobSystem, 0, Data->Count, Grain, Benchmark_Range, Data);
+		Elapsed = Benchmark_Elapsed_Ms(Start);
+		if(Elapsed < Result) Result = Elapsed;
+	}
+	return Result;
+}
+
+static void Benchmark_Numa(uint32_t ThreadCount) {
+	ak_cpu_topology Topology;
+	ak_cpu_topology FakeTopology;
+	ak_cpu_info* FakeCPUs = NULL;
+	const ak_cpu_topology* UsedTopology = &Topology;
+	ak_job_system_create_info CreateInfo;
+	ak_job_system* PlainSystem;
+	ak_job_system* NumaSystem;
+	uint32_t w, i;
+
+	if(!AK_Get_CPU_Topology(&Topology)) {
+		printf("Numa benchmark skipped, no cpu topology\n");
+		return;
+	}
+
+	if(Topology.NodeCount < 2) {
+		/*Split the processors in half. With a single processor both fake nodes share it*/
+		uint32_t FakeCount = Topology.CPUCount < 2 ? 2 : Topology.CPUCount;
+		FakeCPUs = (ak_cpu_info*)Allocate_Memory(sizeof(ak_cpu_info)*FakeCount);
+		for(i = 0; i < FakeCount; i++) {
+			FakeCPUs[i] = Topology.CPUs[i < Topology.CPUCount ? i : 0];
+			FakeCPUs[i].NodeIndex = i < FakeCount/2 ? 0 : 1;
+		}
+		FakeTopology = Topology;
+		FakeTopology.CPUs = FakeCPUs;
+		FakeTopology.CPUCount = FakeCount;
+		FakeTopology.NodeCount = 2;
+		UsedTopology = &FakeTopology;
+	}
+
+	Memory_Clear(&CreateInfo, sizeof(ak_job_system_create_info));
+	CreateInfo.ThreadCount = ThreadCount;
+	PlainSystem = AK_Job_System_Create_Ex(&CreateInfo);
+	CreateInfo.Flags = AK_JOB_SYSTEM_FLAG_NUMA;
+	CreateInfo.Topology = UsedTopology;
+	NumaSystem = AK_Job_System_Create_Ex(&CreateInfo);
+
+	printf("\nNuma benchmark (%u nodes%s, best of %d)\n", UsedTopology->NodeCount, 
+		   FakeCPUs ? " simulated" : "", BENCHMARK_ITERATIONS);
+	printf("%-10s %14s %14s\n", "workload", "plain (ms)", "numa (ms)");
+
+	for(w = 0; w < BENCHMARK_WORKLOAD_COUNT; w++) {
+		benchmark_data Data;
+		double PlainMs, NumaMs;
+
+		Data.Workload = (benchmark_workload)w;
+		Data.Count = G_Workload_Counts[w];
+		Data.Values = (uint32_t*)Allocate_Memory((uint32_t)(sizeof(uint32_t)*Data.Count));
+		for(i = 0; i < Data.Count; i++) Data.Values[i] = i;
+
+		PlainMs = Benchmark_Adaptive_Ms(PlainSystem, &Data, G_Workload_Grains[w]);
+		NumaMs = Benchmark_Adaptive_Ms(NumaSystem, &Data, G_Workload_Grains[w]);
+
+		printf("%-10s %14.3f %14.3f\n", G_Workload_Names[w], PlainMs, NumaMs);
+		Free_Memory(Data.Values);
+	}
+
+	AK_Job_System_Delete(NumaSystem);
+	AK_Job_System_Delete(PlainSystem);
+	if(FakeCPUs) Free_Memory(FakeCPUs);
+	AK_Free_CPU_Topology(&Topology);
+}
+
+#define BENCHMARK_COUNTER_ADDS 4000000
+
+typedef struct {
+	ak_atomic_u64* 		 Shared;
+	ak_percpu_counter* 	 PerCPU;
+	ak_sharded_counter*  Sharded;
+	ak_adaptive_counter* Adaptive;
+	uint32_t 			 AddCount;
+	uint32_t 			 Padding;
+} benchmark_counter_data;
+
+static AK_THREAD_CALLBACK_DEFINE(Benchmark_Shared_Counter_Thread) {
+	benchmark_counter_data* Data = (benchmark_counter_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < Data->AddCount; i++) AK_Atomic_Fetch_Add_U64(Data->Shared, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	return 0;
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Benchmark_PerCPU_Counter_Thread) {
+	benchmark_counter_data* Data = (benchmark_counter_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < Data->AddCount; i++) AK_PerCPU_Add_U64(Data->PerCPU, 1);
+	return 0;
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Benchmark_Sharded_Counter_Thread) {
+	benchmark_counter_data* Data = (benchmark_counter_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < Data->AddCount; i++) AK_Sharded_Counter_Add(Data->Sharded, 1);
+	return 0;
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Benchmark_Adaptive_Counter_Thread) {
+	benchmark_counter_data* Data = (benchmark_counter_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < Data->AddCount; i++) AK_Adaptive_Counter_Add(Data->Adaptive, 1);
+	return 0;
+}
+
+static double Benchmark_Counter_Ms(ak_thread_callback_func* Callback, benchmark_counter_data* Data, ak_thread** Threads, uint32_t ThreadCount) {
+	uint32_t i;
+	uint64_t Start = AK_Query_Performance_Counter();
+	for(i = 0; i < ThreadCount; i++) Threads[i] = AK_Thread_Create(Callback, Data);
+	for(i = 0; i < ThreadCount; i++) AK_Thread_Delete(Threads[i]);
+	return Benchmark_Elapsed_Ms(Start);
+}
+
+static void Benchmark_Counters(uint32_t ThreadCount) {
+	ak_atomic_u64 Shared;
+	ak_percpu_counter PerCPU;
+	ak_sharded_counter Sharded;
+	ak_adaptive_counter Adaptive;
+	benchmark_counter_data Data;
+	ak_thread** Threads = (ak_thread**)Allocate_Memory(sizeof(ak_thread*)*ThreadCount);
+	double SharedMs, PerCPUMs, ShardedMs, AdaptiveMs;
+
+	AK_Atomic_Store_U64(&Shared, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_PerCPU_Counter_Create(&PerCPU);
+	AK_Sharded_Counter_Create(&Sharded, 0);
+	AK_Adaptive_Counter_Create(&Adaptive, 0, 0);
+	Data.Shared = &Shared;
+	Data.PerCPU = &PerCPU;
+	Data.Sharded = &Sharded;
+	Data.Adaptive = &Adaptive;
+	Data.AddCount = BENCHMARK_COUNTER_ADDS/ThreadCount;
+
+	SharedMs = Benchmark_Counter_Ms(Benchmark_Shared_Counter_Thread, &Data, Threads, ThreadCount);
+	PerCPUMs = Benchmark_Counter_Ms(Benchmark_PerCPU_Counter_Thread, &Data, Threads, ThreadCount);
+	ShardedMs = Benchmark_Counter_Ms(Benchmark_Sharded_Counter_Thread, &Data, Threads, ThreadCount);
+	AdaptiveMs = Benchmark_Counter_Ms(Benchmark_Adaptive_Counter_Thread, &Data, Threads, ThreadCount);
+
+	printf("\nCounter benchmark (%u threads, %d adds, rseq %s)\n", ThreadCount, BENCHMARK_COUNTER_ADDS, 
+		   AK_PerCPU_Is_Accelerated() ? "on" : "off");
+	printf("%-10s %14s %14s %14s %14s\n", "", "atomic (ms)", "per cpu (ms)", "sharded (ms)", "adaptive (ms)");
+	printf("%-10s %14.3f %14.3f %14.3f %14.3f\n", "add", SharedMs, PerCPUMs, ShardedMs, AdaptiveMs);
+
+	AK_Adaptive_Counter_Delete(&Adaptive);
+	AK_Sharded_Counter_Delete(&Sharded);
+	AK_PerCPU_Counter_Delete(&PerCPU);
+	Free_Memory(Threads);
+}
+
+int main(void) {
+	ak_job_system* JobSystem = AK_Job_System_Create(0, 0);
+	uint32_t ThreadCount = AK_Job_System_Get_Thread_Count(JobSystem);
+	benchmark_static_chunk* Chunks = (benchmark_static_chunk*)Allocate_Memory(sizeof(benchmark_static_chunk)*ThreadCount);
+	ak_job* Jobs = (ak_job*)Allocate_Memory(sizeof(ak_job)*ThreadCount);
+	uint32_t w, i;
+
+	printf("Parallel for benchmark (%u threads, best of %d)\n", ThreadCount, BENCHMARK_ITERATIONS);
+	printf("%-10s %14s %14s\n", "workload", "static (ms)", "adaptive (ms)");
+
+	for(w = 0; w < BENCHMARK_WORKLOAD_COUNT; w++) {
+		benchmark_data Data;
+		double StaticMs = 1e30, AdaptiveMs = 1e30;
+
+		Data.Workload = (benchmark_workload)w;
+		Data.Count = G_Workload_Counts[w];
+		Data.Values = (uint32_t*)Allocate_Memory((uint32_t)(sizeof(uint32_t)*Data.Count));
+		for(i = 0; i < Data.Count; i++) Data.Values[i] = i;
+
+		for(i = 0; i < BENCHMARK_ITERATIONS; i++) {
+			double Elapsed;
+			uint64_t Start = AK_Query_Performance_Counter();
+			Benchmark_Static_For(JobSystem, &Data, Chunks, Jobs);
+			Elapsed = Benchmark_Elapsed_Ms(Start);
+			if(Elapsed < StaticMs) StaticMs = Elapsed;
+		}
+		AdaptiveMs = Benchmark_Adaptive_Ms(JobSystem, &Data, G_Workload_Grains[w]);
+
+		printf("%-10s %14.3f %14.3f\n", G_Workload_Names[w], StaticMs, AdaptiveMs);
+		Free_Memory(Data.Values);
+	}
+
+	Free_Memory(Jobs);
+	Free_Memory(Chunks);
+	AK_Job_System_Delete(JobSystem);
+
+	Benchmark_Numa(ThreadCount);
+	Benchmark_Counters(ThreadCount);
+	return 0;
+}
+
+#ifdef AK_ATOMIC_COMPILER_MSVC
+#pragma warning(pop)
+#endif
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+#ifndef AK_ATOMIC_IMPLEMENTATION
+#define AK_ATOMIC_IMPLEMENTATION
+#include <ak_atomic.h>
+#endif
@@ -0,0 +1 @@
+#include "ak_atomic_benchmark.c"
\ No newline at end of file
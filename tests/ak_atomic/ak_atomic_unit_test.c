@@ -2259,6 +2259,2360 @@ UTEST(CompareExchange, LinkList) {
 	Free_Memory(Context.Threads);
 }
 
+#ifdef AK_ATOMIC_OS_LINUX
+#include <sys/prctl.h>
+#endif
+
+typedef struct {
+	ak_atomic_u32 HasRun;
+	int8_t 		  NameMatches;
+	int8_t 		  Padding[3];
+} thread_create_ex_data;
+
+static AK_THREAD_CALLBACK_DEFINE(Thread_Create_Ex_Callback) {
+	thread_create_ex_data* Data = (thread_create_ex_data*)UserData;
+	Data->NameMatches = 1;
+#ifdef AK_ATOMIC_OS_LINUX
+	{
+		char Name[17] = {0};
+		prctl(PR_GET_NAME, (unsigned long)(size_t)Name, 0, 0, 0);
+		Data->NameMatches = strcmp(Name, "ak_test_worker_") == 0;
+	}
+#endif
+	AK_Atomic_Store_U32(&Data->HasRun, 1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	(void)Thread;
+	return 0;
+}
+
+UTEST(Thread, Create_Ex) {
+	ak_thread_storage Storage;
+	ak_thread_create_info CreateInfo;
+	thread_create_ex_data Data;
+	ak_thread* Thread;
+
+	Memory_Clear(&CreateInfo, sizeof(CreateInfo));
+	CreateInfo.AffinityMask = 1;
+	CreateInfo.StackSize = 64*1024;
+	CreateInfo.Name = "ak_test_worker_thread";
+	CreateInfo.Storage = &Storage;
+
+	AK_Atomic_Store_U32(&Data.HasRun, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Data.NameMatches = 0;
+
+	Thread = AK_Thread_Create_Ex(Thread_Create_Ex_Callback, &Data, &CreateInfo);
+	ASSERT_TRUE(Thread == &Storage.Base);
+	AK_Thread_Delete(Thread);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Data.HasRun, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 1);
+	ASSERT_TRUE(Data.NameMatches);
+
+	/*No create info behaves like AK_Thread_Create*/
+	AK_Atomic_Store_U32(&Data.HasRun, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Thread = AK_Thread_Create_Ex(Thread_Create_Ex_Callback, &Data, NULL);
+	ASSERT_TRUE(Thread != NULL);
+	AK_Thread_Delete(Thread);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Data.HasRun, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 1);
+}
+
+UTEST(CPUTopology, System) {
+	ak_cpu_topology Topology;
+	uint32_t i;
+	ASSERT_TRUE(AK_Get_CPU_Topology(&Topology));
+	ASSERT_TRUE(Topology.CPUCount >= 1);
+	ASSERT_TRUE(Topology.CoreCount >= 1 && Topology.CoreCount <= Topology.CPUCount);
+	for(i = 0; i < Topology.CPUCount; i++) {
+		ak_cpu_info* CPU = Topology.CPUs + i;
+		ASSERT_TRUE(CPU->CoreIndex < Topology.CoreCount);
+		ASSERT_TRUE(CPU->PackageIndex < Topology.PackageCount);
+		ASSERT_TRUE(CPU->NodeIndex < Topology.NodeCount);
+		ASSERT_TRUE(CPU->L2GroupIndex < Topology.L2GroupCount);
+		ASSERT_TRUE(CPU->L3GroupIndex < Topology.L3GroupCount);
+	}
+	AK_Free_CPU_Topology(&Topology);
+}
+
+#ifdef AK_ATOMIC_OS_LINUX
+#include <stdio.h>
+#include <sys/stat.h>
+#include <dirent.h>
+
+/*Writes a file into a fake sysfs/cgroup tree, creating the directories along the way*/
+static void Fake_FS_Write(const char* Root, const char* Path, const char* Contents) {
+	char FullPath[512];
+	char* At;
+	FILE* File;
+	strcpy(FullPath, Root);
+	strcat(FullPath, Path);
+	for(At = FullPath+1; *At; At++) {
+		if(*At == '/') {
+			*At = 0;
+			mkdir(FullPath, 0755);
+			*At = '/';
+		}
+	}
+	File = fopen(FullPath, "w");
+	if(File) {
+		fputs(Contents, File);
+		fclose(File);
+	}
+}
+
+static void Fake_FS_Write_CPU(const char* Root, uint32_t CPU, const char* File, const char* Contents) {
+	char Path[128];
+	sprintf(Path, "/cpu/cpu%u/%s", CPU, File);
+	Fake_FS_Write(Root, Path, Contents);
+}
+
+/*Removes a fake tree depth first. remove deletes files and empty directories*/
+static void Fake_FS_Remove(const char* Path) {
+	DIR* Directory = opendir(Path);
+	if(Directory) {
+		struct dirent* Entry;
+		while((Entry = readdir(Directory)) != NULL) {
+			char ChildPath[512];
+			if(!strcmp(Entry->d_name, ".") || !strcmp(Entry->d_name, "..")) continue;
+			sprintf(ChildPath, "%s/%s", Path, Entry->d_name);
+			Fake_FS_Remove(ChildPath);
+		}
+		closedir(Directory);
+	}
+	remove(Path);
+}
+
+/*The fixtures own the fake trees so the teardown removes them even when an assert fails*/
+struct CPUTopology {
+	char Root[64];
+};
+
+UTEST_F_SETUP(CPUTopology) {
+	sprintf(utest_fixture->Root, "/tmp/ak_atomic_sysfs_%u", (uint32_t)getpid());
+	Fake_FS_Remove(utest_fixture->Root);
+	(void)utest_result;
+}
+
+UTEST_F_TEARDOWN(CPUTopology) {
+	Fake_FS_Remove(utest_fixture->Root);
+	(void)utest_result;
+}
+
+/*Two packages on two nodes, each with two cores of two hardware threads. L2 per core, L3 per package*/
+UTEST_F(CPUTopology, Fake_Sysfs) {
+	const char* Root = utest_fixture->Root;
+	ak_cpu_topology Topology;
+	uint32_t i;
+
+	Fake_FS_Write(Root, "/cpu/online", "0-7\n");
+	Fake_FS_Write(Root, "/node/online", "0-1\n");
+	Fake_FS_Write(Root, "/node/node0/cpulist", "0-3\n");
+	Fake_FS_Write(Root, "/node/node1/cpulist", "4-7\n");
+	for(i = 0; i < 8; i++) {
+		char Value[32];
+		sprintf(Value, "%u\n", i/4);
+		Fake_FS_Write_CPU(Root, i, "topology/physical_package_id", Value);
+		sprintf(Value, "%u\n", (i%4)/2);
+		Fake_FS_Write_CPU(Root, i, "topology/core_id", Value);
+
+		Fake_FS_Write_CPU(Root, i, "cache/index0/level", "1\n");
+		Fake_FS_Write_CPU(Root, i, "cache/index0/type", "Instruction\n");
+		sprintf(Value, "%u\n", i);
+		Fake_FS_Write_CPU(Root, i, "cache/index0/shared_cpu_list", Value);
+
+		Fake_FS_Write_CPU(Root, i, "cache/index1/level", "2\n");
+		Fake_FS_Write_CPU(Root, i, "cache/index1/type", "Unified\n");
+		sprintf(Value, "%u-%u\n", i & ~1u, (i & ~1u)+1);
+		Fake_FS_Write_CPU(Root, i, "cache/index1/shared_cpu_list", Value);
+
+		Fake_FS_Write_CPU(Root, i, "cache/index2/level", "3\n");
+		Fake_FS_Write_CPU(Root, i, "cache/index2/type", "Unified\n");
+		Fake_FS_Write_CPU(Root, i, "cache/index2/shared_cpu_list", i < 4 ? "0-3\n" : "4-7\n");
+	}
+
+	ASSERT_TRUE(AK_Get_CPU_Topology_From_Path(&Topology, Root));
+	ASSERT_TRUE(Topology.CPUCount == 8);
+	ASSERT_TRUE(Topology.CoreCount == 4);
+	ASSERT_TRUE(Topology.PackageCount == 2);
+	ASSERT_TRUE(Topology.NodeCount == 2);
+	ASSERT_TRUE(Topology.L2GroupCount == 4);
+	ASSERT_TRUE(Topology.L3GroupCount == 2);
+	for(i = 0; i < 8; i++) {
+		ak_cpu_info* CPU = Topology.CPUs + i;
+		ASSERT_TRUE(CPU->ID == i);
+		ASSERT_TRUE(CPU->CoreIndex == i/2);
+		ASSERT_TRUE(CPU->SMTIndex == i%2);
+		ASSERT_TRUE(CPU->PackageIndex == i/4);
+		ASSERT_TRUE(CPU->NodeIndex == i/4);
+		ASSERT_TRUE(CPU->L2GroupIndex == i/2);
+		ASSERT_TRUE(CPU->L3GroupIndex == i/4);
+	}
+	AK_Free_CPU_Topology(&Topology);
+}
+
+struct EffectiveProcessorCount {
+	char Root[64];
+};
+
+UTEST_F_SETUP(EffectiveProcessorCount) {
+	sprintf(utest_fixture->Root, "/tmp/ak_atomic_cgroup_%u", (uint32_t)getpid());
+	Fake_FS_Remove(utest_fixture->Root);
+	(void)utest_result;
+}
+
+UTEST_F_TEARDOWN(EffectiveProcessorCount) {
+	Fake_FS_Remove(utest_fixture->Root);
+	(void)utest_result;
+}
+
+UTEST_F(EffectiveProcessorCount, Fake_CGroup) {
+	const char* Root = utest_fixture->Root;
+	uint32_t AffinityCount;
+
+	/*Nothing mounted means only the affinity mask counts*/
+	Fake_FS_Write(Root, "/proc/self/cgroup", "0::/\n");
+	AffinityCount = AK_Get_Effective_Processor_Thread_Count_From_Root(Root);
+	ASSERT_TRUE(AffinityCount >= 1);
+	ASSERT_TRUE(AffinityCount <= AK_Get_Processor_Thread_Count());
+	ASSERT_TRUE(AK_Get_Effective_Processor_Thread_Count() <= AffinityCount);
+
+	/*cgroup v2, the parent limit of 2.5 cpus rounds up to 3 and is lower than the child's*/
+	Fake_FS_Write(Root, "/proc/self/cgroup", "0::/pod/container\n");
+	Fake_FS_Write(Root, "/sys/fs/cgroup/pod/cpu.max", "250000 100000\n");
+	Fake_FS_Write(Root, "/sys/fs/cgroup/pod/container/cpu.max", "max 100000\n");
+	ASSERT_TRUE(AK_Get_Effective_Processor_Thread_Count_From_Root(Root) == (AffinityCount < 3 ? AffinityCount : 3));
+
+	Fake_FS_Write(Root, "/sys/fs/cgroup/pod/container/cpu.max", "100000 100000\n");
+	ASSERT_TRUE(AK_Get_Effective_Processor_Thread_Count_From_Root(Root) == 1);
+
+	/*cgroup v1 with a combined cpu,cpuacct hierarchy*/
+	Fake_FS_Write(Root, "/proc/self/cgroup", "5:memory:/docker/abc\n4:cpu,cpuacct:/docker/abc\n0::/\n");
+	Fake_FS_Write(Root, "/sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "-1\n");
+	Fake_FS_Write(Root, "/sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000\n");
+	ASSERT_TRUE(AK_Get_Effective_Processor_Thread_Count_From_Root(Root) == AffinityCount);
+
+	Fake_FS_Write(Root, "/sys/fs/cgroup/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "150000\n");
+	ASSERT_TRUE(AK_Get_Effective_Processor_Thread_Count_From_Root(Root) == (AffinityCount < 2 ? AffinityCount : 2));
+}
+#endif
+
+static AK_FUTURE_CALLBACK_DEFINE(Future_Add_Callback) {
+	ak_atomic_u64* Sum = (ak_atomic_u64*)UserData;
+	AK_Atomic_Fetch_Add_U64(Sum, (uint64_t)(size_t)Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+UTEST(Future, Then_Try_Get) {
+	ak_promise Promise;
+	ak_future* Future;
+	ak_atomic_u64 Sum;
+	void* Value = NULL;
+
+	AK_Atomic_Store_U64(&Sum, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	ASSERT_TRUE(AK_Promise_Create(&Promise));
+	Future = AK_Promise_Get_Future(&Promise);
+	ASSERT_FALSE(AK_Future_Try_Get(Future, &Value));
+
+	ASSERT_TRUE(AK_Future_Then(Future, Future_Add_Callback, &Sum));
+	ASSERT_TRUE(AK_Future_Then(Future, Future_Add_Callback, &Sum));
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+
+	AK_Promise_Set_Value(&Promise, (void*)(size_t)21);
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 42);
+	ASSERT_TRUE(AK_Future_Try_Get(Future, &Value));
+	ASSERT_TRUE(Value == (void*)(size_t)21);
+	ASSERT_TRUE(AK_Future_Wait(Future) == (void*)(size_t)21);
+
+	/*Continuations attached after the value is set run immediately*/
+	ASSERT_TRUE(AK_Future_Then(Future, Future_Add_Callback, &Sum));
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 63);
+	AK_Promise_Delete(&Promise);
+
+	/*Unset promises free their pending continuations*/
+	AK_Promise_Create(&Promise);
+	AK_Future_Then(AK_Promise_Get_Future(&Promise), Future_Add_Callback, &Sum);
+	AK_Promise_Delete(&Promise);
+}
+
+#define FUTURE_CHAIN_LENGTH 64
+#define FUTURE_WAITER_COUNT 4
+
+typedef struct {
+	ak_promise Promises[FUTURE_CHAIN_LENGTH];
+} future_chain;
+
+/*Each step forwards the value incremented by one into the next promise*/
+static AK_FUTURE_CALLBACK_DEFINE(Future_Chain_Callback) {
+	ak_promise* Next = (ak_promise*)UserData;
+	AK_Promise_Set_Value(Next, (void*)((size_t)Value+1));
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Future_Waiter_Thread) {
+	future_chain* Chain = (future_chain*)UserData;
+	void* Value = AK_Future_Wait(AK_Promise_Get_Future(&Chain->Promises[FUTURE_CHAIN_LENGTH-1]));
+	(void)Thread;
+	return (int32_t)(size_t)Value;
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Future_Setter_Thread) {
+	future_chain* Chain = (future_chain*)UserData;
+	AK_Sleep(10);
+	AK_Promise_Set_Value(&Chain->Promises[0], (void*)(size_t)1);
+	(void)Thread;
+	return 0;
+}
+
+UTEST(Future, Chain_Wait) {
+	future_chain Chain;
+	ak_thread* Waiters[FUTURE_WAITER_COUNT];
+	ak_thread* Setter;
+	uint32_t i;
+
+	for(i = 0; i < FUTURE_CHAIN_LENGTH; i++) AK_Promise_Create(&Chain.Promises[i]);
+	for(i = 0; i+1 < FUTURE_CHAIN_LENGTH; i++) {
+		ASSERT_TRUE(AK_Future_Then(AK_Promise_Get_Future(&Chain.Promises[i]), Future_Chain_Callback, &Chain.Promises[i+1]));
+	}
+
+	for(i = 0; i < FUTURE_WAITER_COUNT; i++) Waiters[i] = AK_Thread_Create(Future_Waiter_Thread, &Chain);
+	Setter = AK_Thread_Create(Future_Setter_Thread, &Chain);
+
+	ASSERT_TRUE(AK_Future_Wait(AK_Promise_Get_Future(&Chain.Promises[FUTURE_CHAIN_LENGTH-1])) == (void*)(size_t)FUTURE_CHAIN_LENGTH);
+	AK_Thread_Delete(Setter);
+	for(i = 0; i < FUTURE_WAITER_COUNT; i++) AK_Thread_Delete(Waiters[i]);
+	for(i = 0; i < FUTURE_CHAIN_LENGTH; i++) AK_Promise_Delete(&Chain.Promises[i]);
+}
+
+typedef struct {
+	ak_atomic_u32 ExecutedCount;
+} job_system_submit_context;
+
+static AK_JOB_CALLBACK_DEFINE(JobSystemSubmitJob) {
+	job_system_submit_context* Context = (job_system_submit_context*)UserData;
+	(void)JobSystem;
+	AK_Atomic_Increment_U32(&Context->ExecutedCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+UTEST(JobSystem, Submit) {
+	uint32_t i;
+	uint32_t JobCount = 100000;
+	job_system_submit_context Context;
+	ak_atomic_u32 Counter;
+	ak_job_system* JobSystem = AK_Job_System_Create(0, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	Memory_Clear(&Context, sizeof(job_system_submit_context));
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	/*More jobs than the queue can hold so the inline fallback is exercised as well*/
+	for(i = 0; i < JobCount; i++) {
+		AK_Job_System_Submit(JobSystem, JobSystemSubmitJob, &Context, &Counter);
+	}
+	AK_Job_System_Wait(JobSystem, &Counter);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Context.ExecutedCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == JobCount);
+	AK_Job_System_Delete(JobSystem);
+}
+
+UTEST(JobSystem, Submit_Batch) {
+	uint32_t i;
+	uint32_t JobCount = 1000;
+	job_system_submit_context Context;
+	ak_atomic_u32 Counter;
+	ak_job* Jobs = (ak_job*)Allocate_Memory(sizeof(ak_job)*JobCount);
+	ak_job_system* JobSystem = AK_Job_System_Create(0, 256);
+
+	Memory_Clear(&Context, sizeof(job_system_submit_context));
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	for(i = 0; i < JobCount; i++) {
+		Jobs[i].Callback = JobSystemSubmitJob;
+		Jobs[i].UserData = &Context;
+	}
+
+	for(i = 0; i < 10; i++) {
+		AK_Job_System_Submit_Batch(JobSystem, Jobs, JobCount, &Counter);
+		AK_Job_System_Wait(JobSystem, &Counter);
+		ASSERT_TRUE(AK_Atomic_Load_U32(&Context.ExecutedCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == JobCount*(i+1));
+	}
+
+	AK_Job_System_Delete(JobSystem);
+	Free_Memory(Jobs);
+}
+
+typedef struct {
+	ak_atomic_u32* LeafCount;
+	uint32_t Depth;
+} job_system_tree_node;
+
+static AK_JOB_CALLBACK_DEFINE(JobSystemTreeJob) {
+	job_system_tree_node* Node = (job_system_tree_node*)UserData;
+	if(Node->Depth == 0) {
+		AK_Atomic_Increment_U32(Node->LeafCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	} else {
+		job_system_tree_node Children[2];
+		ak_atomic_u32 Counter;
+		AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+		Children[0].LeafCount = Children[1].LeafCount = Node->LeafCount;
+		Children[0].Depth = Children[1].Depth = Node->Depth-1;
+		AK_Job_System_Submit(JobSystem, JobSystemTreeJob, &Children[0], &Counter);
+		AK_Job_System_Submit(JobSystem, JobSystemTreeJob, &Children[1], &Counter);
+		AK_Job_System_Wait(JobSystem, &Counter);
+	}
+}
+
+UTEST(JobSystem, Nested_Wait) {
+	ak_atomic_u32 LeafCount;
+	ak_atomic_u32 Counter;
+	job_system_tree_node Root;
+	ak_job_system* JobSystem = AK_Job_System_Create(0, 0);
+
+	AK_Atomic_Store_U32(&LeafCount, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Root.LeafCount = &LeafCount;
+	Root.Depth = 12;
+
+	AK_Job_System_Submit(JobSystem, JobSystemTreeJob, &Root, &Counter);
+	AK_Job_System_Wait(JobSystem, &Counter);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&LeafCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == (1u << 12));
+
+	AK_Job_System_Delete(JobSystem);
+}
+
+static AK_JOB_CALLBACK_DEFINE(JobSystemSlowJob) {
+	job_system_submit_context* Context = (job_system_submit_context*)UserData;
+	(void)JobSystem;
+	AK_Sleep(2);
+	AK_Atomic_Increment_U32(&Context->ExecutedCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+UTEST(JobSystem, Outside_Wait_Parks) {
+	uint32_t i;
+	job_system_submit_context Context;
+	ak_atomic_u32 Counter;
+	ak_job_system* JobSystem = AK_Job_System_Create(2, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	Memory_Clear(&Context, sizeof(job_system_submit_context));
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	/*The jobs outlast the spin budget, so the waiter has to be woken by the last decrement*/
+	for(i = 0; i < 20; i++) {
+		AK_Job_System_Submit(JobSystem, JobSystemSlowJob, &Context, &Counter);
+		AK_Job_System_Submit(JobSystem, JobSystemSlowJob, &Context, &Counter);
+		AK_Job_System_Submit(JobSystem, JobSystemSlowJob, &Context, &Counter);
+		AK_Job_System_Wait(JobSystem, &Counter);
+		ASSERT_TRUE(AK_Atomic_Load_U32(&Context.ExecutedCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == (i+1)*3);
+	}
+
+	AK_Job_System_Delete(JobSystem);
+}
+
+UTEST(JobSystem, Numa_Fake_Topology) {
+	uint32_t i;
+	ak_cpu_info CPUs[6];
+	ak_cpu_topology Topology;
+	ak_job_system_create_info CreateInfo;
+	ak_job_system* JobSystem;
+	job_system_submit_context Context;
+	ak_atomic_u32 LeafCount;
+	ak_atomic_u32 Counter;
+	job_system_tree_node Root;
+
+	/*Two sparse nodes that both point at processor 0 so the affinity is valid on any machine*/
+	Memory_Clear(CPUs, sizeof(CPUs));
+	for(i = 0; i < 6; i++) CPUs[i].NodeIndex = i < 4 ? 0 : 3;
+	Memory_Clear(&Topology, sizeof(ak_cpu_topology));
+	Topology.CPUs = CPUs;
+	Topology.CPUCount = 6;
+	Topology.NodeCount = 4;
+
+	Memory_Clear(&CreateInfo, sizeof(ak_job_system_create_info));
+	CreateInfo.ThreadCount = 5;
+	CreateInfo.QueueCapacity = 64;
+	CreateInfo.Flags = AK_JOB_SYSTEM_FLAG_NUMA;
+	CreateInfo.Topology = &Topology;
+	JobSystem = AK_Job_System_Create_Ex(&CreateInfo);
+	ASSERT_TRUE(JobSystem != NULL);
+	ASSERT_TRUE(AK_Job_System_Get_Thread_Count(JobSystem) == 5);
+
+	Memory_Clear(&Context, sizeof(job_system_submit_context));
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < 10000; i++) {
+		AK_Job_System_Submit(JobSystem, JobSystemSubmitJob, &Context, &Counter);
+	}
+	AK_Job_System_Wait(JobSystem, &Counter);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Context.ExecutedCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 10000);
+
+	AK_Atomic_Store_U32(&LeafCount, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Root.LeafCount = &LeafCount;
+	Root.Depth = 10;
+	AK_Job_System_Submit(JobSystem, JobSystemTreeJob, &Root, &Counter);
+	AK_Job_System_Wait(JobSystem, &Counter);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&LeafCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == (1u << 10));
+
+	AK_Job_System_Delete(JobSystem);
+}
+
+typedef struct {
+	ak_atomic_u32* Visits;
+	ak_atomic_u64* Sum;
+} parallel_for_data;
+
+static AK_PARALLEL_FOR_CALLBACK_DEFINE(Parallel_For_Visit) {
+	parallel_for_data* Data = (parallel_for_data*)UserData;
+	uint64_t i, Sum = 0;
+	for(i = Begin; i < End; i++) {
+		AK_Atomic_Increment_U32(&Data->Visits[i], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Sum += i;
+	}
+	AK_Atomic_Fetch_Add_U64(Data->Sum, Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+UTEST(ParallelFor, Visits_Every_Index_Once) {
+	const uint32_t Count = 100003;
+	uint32_t Grains[4] = {0, 1, 37, 100003};
+	uint32_t g, i;
+	parallel_for_data Data;
+	ak_atomic_u64 Sum;
+	ak_job_system* JobSystem = AK_Job_System_Create(4, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	Data.Visits = (ak_atomic_u32*)Allocate_Memory(sizeof(ak_atomic_u32)*Count);
+	Data.Sum = &Sum;
+	for(g = 0; g < 4; g++) {
+		for(i = 0; i < Count; i++) AK_Atomic_Store_U32(&Data.Visits[i], 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U64(&Sum, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+		AK_Parallel_For(JobSystem, 0, Count, Grains[g], Parallel_For_Visit, &Data);
+
+		for(i = 0; i < Count; i++) {
+			ASSERT_TRUE(AK_Atomic_Load_U32(&Data.Visits[i], AK_ATOMIC_MEMORY_ORDER_RELAXED) == 1);
+		}
+		ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == ((uint64_t)Count*(Count-1))/2);
+	}
+
+	/*Empty ranges never call back*/
+	AK_Parallel_For(JobSystem, 10, 10, 1, Parallel_For_Visit, &Data);
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == ((uint64_t)Count*(Count-1))/2);
+
+	Free_Memory(Data.Visits);
+	AK_Job_System_Delete(JobSystem);
+}
+
+typedef struct {
+	ak_job_system* JobSystem;
+	ak_atomic_u64* Sum;
+} parallel_for_nested_data;
+
+static AK_PARALLEL_FOR_CALLBACK_DEFINE(Parallel_For_Inner) {
+	ak_atomic_u64* Sum = (ak_atomic_u64*)UserData;
+	AK_Atomic_Fetch_Add_U64(Sum, End-Begin, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+static AK_PARALLEL_FOR_CALLBACK_DEFINE(Parallel_For_Outer) {
+	parallel_for_nested_data* Data = (parallel_for_nested_data*)UserData;
+	uint64_t i;
+	for(i = Begin; i < End; i++) {
+		AK_Parallel_For(Data->JobSystem, 0, 1000, 16, Parallel_For_Inner, Data->Sum);
+	}
+}
+
+UTEST(ParallelFor, Nested) {
+	parallel_for_nested_data Data;
+	ak_atomic_u64 Sum;
+	ak_job_system* JobSystem = AK_Job_System_Create(4, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	AK_Atomic_Store_U64(&Sum, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Data.JobSystem = JobSystem;
+	Data.Sum = &Sum;
+	AK_Parallel_For(JobSystem, 0, 256, 1, Parallel_For_Outer, &Data);
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 256*1000);
+
+	AK_Job_System_Delete(JobSystem);
+}
+
+UTEST(ParallelFor, Huge_Range) {
+	ak_atomic_u64 Sum;
+	uint64_t Begin = 1, End = (uint64_t)-1;
+	ak_job_system* JobSystem = AK_Job_System_Create(4, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	/*Ranges and grains close to 64 bits must neither overflow the chunk math nor lose items*/
+	AK_Atomic_Store_U64(&Sum, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Parallel_For(JobSystem, Begin, End, (uint64_t)1 << 60, Parallel_For_Inner, &Sum);
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == End-Begin);
+
+	AK_Atomic_Store_U64(&Sum, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Parallel_For(JobSystem, Begin, End, (uint64_t)-1, Parallel_For_Inner, &Sum);
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Sum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == End-Begin);
+
+	AK_Job_System_Delete(JobSystem);
+}
+
+#define TASK_GRAPH_LAYER_COUNT 20
+#define TASK_GRAPH_LAYER_WIDTH 100
+#define TASK_GRAPH_NODE_COUNT (TASK_GRAPH_LAYER_COUNT*TASK_GRAPH_LAYER_WIDTH)
+
+typedef struct {
+	ak_atomic_u32* Ticket;
+	uint32_t 	   Order;
+	uint32_t 	   RunCount;
+} task_graph_test_node;
+
+static AK_JOB_CALLBACK_DEFINE(Task_Graph_Test_Job) {
+	task_graph_test_node* Node = (task_graph_test_node*)UserData;
+	Node->Order = AK_Atomic_Increment_U32(Node->Ticket, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Node->RunCount++;
+	(void)JobSystem;
+}
+
+UTEST(TaskGraph, Dependencies) {
+	ak_atomic_u32 Ticket;
+	uint32_t Layer, i, Run;
+	task_graph_test_node* Nodes = (task_graph_test_node*)Allocate_Memory(sizeof(task_graph_test_node)*TASK_GRAPH_NODE_COUNT);
+	ak_task_graph* Graph = AK_Task_Graph_Create(TASK_GRAPH_NODE_COUNT, TASK_GRAPH_NODE_COUNT*2);
+	ak_job_system* JobSystem = AK_Job_System_Create(4, 0);
+	ASSERT_TRUE(Graph != NULL);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	for(i = 0; i < TASK_GRAPH_NODE_COUNT; i++) {
+		Nodes[i].Ticket = &Ticket;
+		Nodes[i].RunCount = 0;
+		ASSERT_TRUE(AK_Task_Graph_Add_Node(Graph, Task_Graph_Test_Job, Nodes + i) == i);
+	}
+
+	/*Every node depends on the node above it and the one above and to the left*/
+	for(Layer = 1; Layer < TASK_GRAPH_LAYER_COUNT; Layer++) {
+		for(i = 0; i < TASK_GRAPH_LAYER_WIDTH; i++) {
+			uint32_t Node = Layer*TASK_GRAPH_LAYER_WIDTH + i;
+			uint32_t Above = Node-TASK_GRAPH_LAYER_WIDTH;
+			ASSERT_TRUE(AK_Task_Graph_Add_Edge(Graph, Above, Node));
+			ASSERT_TRUE(AK_Task_Graph_Add_Edge(Graph, i ? Above-1 : Above+1, Node));
+		}
+	}
+
+	for(Run = 1; Run <= 10; Run++) {
+		AK_Atomic_Store_U32(&Ticket, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Task_Graph_Run(Graph, JobSystem);
+
+		for(Layer = 1; Layer < TASK_GRAPH_LAYER_COUNT; Layer++) {
+			for(i = 0; i < TASK_GRAPH_LAYER_WIDTH; i++) {
+				uint32_t Node = Layer*TASK_GRAPH_LAYER_WIDTH + i;
+				uint32_t Above = Node-TASK_GRAPH_LAYER_WIDTH;
+				ASSERT_TRUE(Nodes[Node].Order > Nodes[Above].Order);
+				ASSERT_TRUE(Nodes[Node].Order > Nodes[i ? Above-1 : Above+1].Order);
+			}
+		}
+
+		for(i = 0; i < TASK_GRAPH_NODE_COUNT; i++) {
+			ASSERT_TRUE(Nodes[i].RunCount == Run);
+		}
+	}
+
+	/*Rebuilding an empty graph is a no op to run*/
+	AK_Task_Graph_Clear(Graph);
+	AK_Task_Graph_Run(Graph, JobSystem);
+
+	AK_Job_System_Delete(JobSystem);
+	AK_Task_Graph_Delete(Graph);
+	Free_Memory(Nodes);
+}
+
+UTEST(CacheLine, Padded_Types) {
+	ak_atomic_u32_padded Slots[4];
+	uint32_t LineSize = AK_Get_Cache_Line_Size();
+
+	ASSERT_TRUE(sizeof(ak_atomic_u8_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+	ASSERT_TRUE(sizeof(ak_atomic_u64_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+	ASSERT_TRUE(sizeof(ak_atomic_ptr_padded) == AK_ATOMIC_CACHE_LINE_SIZE);
+	ASSERT_TRUE((size_t)((uint8_t*)&Slots[1].Value - (uint8_t*)&Slots[0].Value) == AK_ATOMIC_CACHE_LINE_SIZE);
+	/*The types are aligned too, so even a stack array starts on its own line*/
+	ASSERT_TRUE(((size_t)&Slots[0] & (AK_ATOMIC_CACHE_LINE_SIZE-1)) == 0);
+
+	AK_Atomic_Store_U32(&Slots[3].Value, 42, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	ASSERT_TRUE(AK_Atomic_Fetch_Add_U32(&Slots[3].Value, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 42);
+
+	/*Whatever the machine reports, it has to be a sane power of two*/
+	ASSERT_TRUE(LineSize >= 16 && LineSize <= 1024);
+	ASSERT_TRUE((LineSize & (LineSize-1)) == 0);
+}
+
+#define ASYMMETRIC_FENCE_ITERATIONS 20000
+
+typedef struct {
+	ak_atomic_u32 X;
+	ak_atomic_u32 Y;
+	ak_atomic_u32 Round;
+	ak_atomic_u32 Done;
+	uint32_t 	  Results[ASYMMETRIC_FENCE_ITERATIONS];
+} asymmetric_fence_data;
+
+/*Store buffering litmus test. The slow side stores Y, runs a heavy fence and reads X while the
+  fast side does the same with X, a light fence and Y. Both reading 0 would mean the light fence
+  did not order the fast side's store before its load*/
+static AK_THREAD_CALLBACK_DEFINE(Asymmetric_Fence_Slow_Thread) {
+	asymmetric_fence_data* Data = (asymmetric_fence_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < ASYMMETRIC_FENCE_ITERATIONS; i++) {
+		while(AK_Atomic_Load_U32(&Data->Round, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != i+1) AK_Thread_Yield();
+		AK_Atomic_Store_U32(&Data->Y, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Fence_Heavy();
+		Data->Results[i] = AK_Atomic_Load_U32(&Data->X, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Increment_U32(&Data->Done, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	}
+	return 0;
+}
+
+UTEST(AsymmetricFence, Store_Buffering) {
+	asymmetric_fence_data* Data = (asymmetric_fence_data*)Allocate_Memory(sizeof(asymmetric_fence_data));
+	ak_thread* Thread;
+	uint32_t i, Failures = 0;
+
+	Memory_Clear(Data, sizeof(asymmetric_fence_data));
+	Thread = AK_Thread_Create(Asymmetric_Fence_Slow_Thread, Data);
+
+	for(i = 0; i < ASYMMETRIC_FENCE_ITERATIONS; i++) {
+		uint32_t Y;
+		AK_Atomic_Store_U32(&Data->X, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U32(&Data->Y, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Store_U32(&Data->Round, i+1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+
+		AK_Atomic_Store_U32(&Data->X, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Atomic_Fence_Light();
+		Y = AK_Atomic_Load_U32(&Data->Y, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+		while(AK_Atomic_Load_U32(&Data->Done, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != i+1) AK_Thread_Yield();
+		if(Y == 0 && Data->Results[i] == 0) Failures++;
+	}
+
+	AK_Thread_Delete(Thread);
+	ASSERT_TRUE(Failures == 0);
+	Free_Memory(Data);
+}
+
+static ak_atomic_u32 G_Reclaim_Free_Count;
+
+static AK_RECLAIM_CALLBACK_DEFINE(Reclaim_Test_Free) {
+	AK_Atomic_Increment_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Free_Memory(Pointer);
+}
+
+UTEST(Hazard, Protect_Blocks_Reclaim) {
+	ak_atomic_ptr Source;
+	void* Object = Allocate_Memory(16);
+	uint32_t StartCount = AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	AK_Atomic_Store_Ptr(&Source, Object, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	ASSERT_TRUE(AK_Hazard_Protect(0, &Source) == Object);
+
+	/*Unlink and retire while still protected*/
+	AK_Atomic_Store_Ptr(&Source, NULL, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	ASSERT_TRUE(AK_Hazard_Retire(Object, Reclaim_Test_Free));
+	AK_Hazard_Scan();
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED) == StartCount);
+
+	AK_Hazard_Clear(0);
+	AK_Hazard_Scan();
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED) == StartCount+1);
+	AK_Hazard_Thread_Exit();
+}
+
+#define HAZARD_STACK_THREAD_COUNT 4
+#define HAZARD_STACK_ITERATIONS 20000
+
+typedef struct hazard_stack_node {
+	struct hazard_stack_node* Next;
+	uint32_t 				  Value;
+	uint32_t 				  Padding;
+} hazard_stack_node;
+
+typedef struct {
+	ak_atomic_ptr Head;
+	ak_atomic_u64 PushedSum;
+	ak_atomic_u64 PoppedSum;
+	ak_atomic_u32 PopCount;
+	uint32_t 	  Padding;
+} hazard_stack;
+
+/*Treiber stack. Without hazard pointers reading Head->Next in pop could touch freed memory*/
+static void Hazard_Stack_Push(hazard_stack* Stack, uint32_t Value) {
+	hazard_stack_node* Node = (hazard_stack_node*)Allocate_Memory(sizeof(hazard_stack_node));
+	void* Head = AK_Atomic_Load_Ptr(&Stack->Head, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Node->Value = Value;
+	do {
+		Node->Next = (hazard_stack_node*)Head;
+	} while(!AK_Atomic_Compare_Exchange_Weak_Ptr(&Stack->Head, &Head, Node, AK_ATOMIC_MEMORY_ORDER_RELEASE));
+	AK_Atomic_Fetch_Add_U64(&Stack->PushedSum, Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+static int8_t Hazard_Stack_Pop(hazard_stack* Stack) {
+	for(;;) {
+		hazard_stack_node* Head = (hazard_stack_node*)AK_Hazard_Protect(0, &Stack->Head);
+		void* Expected = Head;
+		if(!Head) return 0;
+		if(AK_Atomic_Compare_Exchange_Strong_Ptr(&Stack->Head, &Expected, Head->Next, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+			AK_Hazard_Clear(0);
+			AK_Atomic_Fetch_Add_U64(&Stack->PoppedSum, Head->Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Atomic_Increment_U32(&Stack->PopCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Hazard_Retire(Head, Reclaim_Test_Free);
+			return 1;
+		}
+	}
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Hazard_Stack_Thread) {
+	hazard_stack* Stack = (hazard_stack*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < HAZARD_STACK_ITERATIONS; i++) {
+		Hazard_Stack_Push(Stack, i);
+		if(i & 1) {
+			Hazard_Stack_Pop(Stack);
+			Hazard_Stack_Pop(Stack);
+		}
+	}
+	AK_Hazard_Thread_Exit();
+	return 0;
+}
+
+UTEST(Hazard, Treiber_Stack) {
+	hazard_stack Stack;
+	ak_thread* Threads[HAZARD_STACK_THREAD_COUNT];
+	uint32_t i, StartCount = AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	Memory_Clear(&Stack, sizeof(hazard_stack));
+	for(i = 0; i < HAZARD_STACK_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Hazard_Stack_Thread, &Stack);
+	}
+	for(i = 0; i < HAZARD_STACK_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	while(Hazard_Stack_Pop(&Stack)) {}
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Stack.PushedSum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 
+				AK_Atomic_Load_U64(&Stack.PoppedSum, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+
+	/*Exited threads handed their leftovers over, so one scan reclaims everything*/
+	AK_Hazard_Scan();
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED)-StartCount == 
+				AK_Atomic_Load_U32(&Stack.PopCount, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	AK_Hazard_Thread_Exit();
+}
+
+UTEST(Epoch, Critical_Section_Blocks_Reclaim) {
+	void* Object = Allocate_Memory(16);
+	uint32_t StartCount = AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint64_t Epoch;
+
+	/*Nested critical sections only announce once*/
+	AK_Epoch_Enter();
+	AK_Epoch_Enter();
+	AK_Epoch_Retire(Object, Reclaim_Test_Free);
+
+	/*The epoch can move one ahead of our announcement but never two*/
+	Epoch = AK_Epoch_Collect();
+	Epoch = AK_Epoch_Collect();
+	ASSERT_TRUE(AK_Epoch_Collect() == Epoch);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED) == StartCount);
+
+	AK_Epoch_Exit();
+	ASSERT_TRUE(AK_Epoch_Collect() == Epoch);
+	AK_Epoch_Exit();
+
+	AK_Epoch_Collect();
+	ASSERT_TRUE(AK_Epoch_Collect() == Epoch+2);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED) == StartCount+1);
+	AK_Epoch_Thread_Exit();
+}
+
+/*Same stack as above. Pop reads Head->Next inside a critical section instead of protecting Head*/
+static int8_t Epoch_Stack_Pop(hazard_stack* Stack) {
+	int8_t Result = 0;
+	AK_Epoch_Enter();
+	for(;;) {
+		hazard_stack_node* Head = (hazard_stack_node*)AK_Atomic_Load_Ptr(&Stack->Head, AK_ATOMIC_MEMORY_ORDER_ACQUIRE);
+		void* Expected = Head;
+		if(!Head) break;
+		if(AK_Atomic_Compare_Exchange_Strong_Ptr(&Stack->Head, &Expected, Head->Next, AK_ATOMIC_MEMORY_ORDER_ACQ_REL)) {
+			AK_Atomic_Fetch_Add_U64(&Stack->PoppedSum, Head->Value, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Atomic_Increment_U32(&Stack->PopCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Epoch_Retire(Head, Reclaim_Test_Free);
+			Result = 1;
+			break;
+		}
+	}
+	AK_Epoch_Exit();
+	return Result;
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Epoch_Stack_Thread) {
+	hazard_stack* Stack = (hazard_stack*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < HAZARD_STACK_ITERATIONS; i++) {
+		Hazard_Stack_Push(Stack, i);
+		if(i & 1) {
+			Epoch_Stack_Pop(Stack);
+			Epoch_Stack_Pop(Stack);
+		}
+	}
+	AK_Epoch_Thread_Exit();
+	return 0;
+}
+
+UTEST(Epoch, Treiber_Stack) {
+	hazard_stack Stack;
+	ak_thread* Threads[HAZARD_STACK_THREAD_COUNT];
+	uint32_t i, StartCount = AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	Memory_Clear(&Stack, sizeof(hazard_stack));
+	for(i = 0; i < HAZARD_STACK_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Epoch_Stack_Thread, &Stack);
+	}
+	for(i = 0; i < HAZARD_STACK_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	while(Epoch_Stack_Pop(&Stack)) {}
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Stack.PushedSum, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 
+				AK_Atomic_Load_U64(&Stack.PoppedSum, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+
+	/*Nobody is in a critical section anymore, so two advances make everything safe*/
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED)-StartCount == 
+				AK_Atomic_Load_U32(&Stack.PopCount, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	AK_Epoch_Thread_Exit();
+}
+
+typedef struct {
+	ak_atomic_ptr Config;
+	ak_atomic_u32 IsReading;
+	ak_atomic_u32 IsReleased;
+	ak_atomic_u32 IsSynchronized;
+	uint32_t 	  ReadValue;
+} rcu_wait_test;
+
+static AK_THREAD_CALLBACK_DEFINE(RCU_Wait_Reader_Thread) {
+	rcu_wait_test* Test = (rcu_wait_test*)UserData;
+	uint32_t* Config;
+	(void)Thread;
+
+	AK_RCU_Thread_Online();
+	Config = (uint32_t*)AK_RCU_Dereference(&Test->Config);
+	AK_Atomic_Store_U32(&Test->IsReading, 1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	while(!AK_Atomic_Load_U32(&Test->IsReleased, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) AK_Thread_Yield();
+
+	/*Still alive since we haven't passed a quiescent state yet*/
+	Test->ReadValue = *Config;
+	AK_RCU_Quiescent_State();
+	AK_RCU_Thread_Exit();
+	return 0;
+}
+
+static AK_THREAD_CALLBACK_DEFINE(RCU_Wait_Writer_Thread) {
+	rcu_wait_test* Test = (rcu_wait_test*)UserData;
+	uint32_t* Config = (uint32_t*)Allocate_Memory(sizeof(uint32_t));
+	void* OldConfig = AK_Atomic_Load_Ptr(&Test->Config, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	(void)Thread;
+
+	*Config = 2;
+	AK_RCU_Assign(&Test->Config, Config);
+	AK_RCU_Call(OldConfig, Reclaim_Test_Free);
+	AK_RCU_Synchronize();
+	AK_Atomic_Store_U32(&Test->IsSynchronized, 1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	AK_RCU_Thread_Exit();
+	return 0;
+}
+
+UTEST(RCU, Synchronize_Waits_For_Quiescent_State) {
+	rcu_wait_test Test;
+	ak_thread* Reader;
+	ak_thread* Writer;
+	uint32_t* Config = (uint32_t*)Allocate_Memory(sizeof(uint32_t));
+	uint32_t StartCount = AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	*Config = 1;
+	Memory_Clear(&Test, sizeof(rcu_wait_test));
+	AK_Atomic_Store_Ptr(&Test.Config, Config, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	Reader = AK_Thread_Create(RCU_Wait_Reader_Thread, &Test);
+	while(!AK_Atomic_Load_U32(&Test.IsReading, AK_ATOMIC_MEMORY_ORDER_ACQUIRE)) AK_Thread_Yield();
+	Writer = AK_Thread_Create(RCU_Wait_Writer_Thread, &Test);
+
+	AK_Sleep(10);
+	ASSERT_FALSE(AK_Atomic_Load_U32(&Test.IsSynchronized, AK_ATOMIC_MEMORY_ORDER_ACQUIRE));
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED) == StartCount);
+
+	AK_Atomic_Store_U32(&Test.IsReleased, 1, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	AK_Thread_Delete(Reader);
+	AK_Thread_Delete(Writer);
+	ASSERT_TRUE(Test.ReadValue == 1);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.IsSynchronized, AK_ATOMIC_MEMORY_ORDER_ACQUIRE));
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED) == StartCount+1);
+	Free_Memory(AK_Atomic_Load_Ptr(&Test.Config, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+}
+
+#define RCU_READER_COUNT 3
+#define RCU_SWAP_COUNT 5000
+
+typedef struct {
+	uint64_t A;
+	uint64_t B;
+} rcu_config;
+
+typedef struct {
+	ak_atomic_ptr Config;
+	ak_atomic_u32 IsDone;
+	ak_atomic_u32 FailureCount;
+} rcu_swap_test;
+
+static AK_THREAD_CALLBACK_DEFINE(RCU_Swap_Reader_Thread) {
+	rcu_swap_test* Test = (rcu_swap_test*)UserData;
+	(void)Thread;
+
+	AK_RCU_Thread_Online();
+	while(!AK_Atomic_Load_U32(&Test->IsDone, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+		rcu_config* Config = (rcu_config*)AK_RCU_Dereference(&Test->Config);
+		if(Config->B != Config->A*2) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_RCU_Quiescent_State();
+	}
+	AK_RCU_Thread_Exit();
+	return 0;
+}
+
+UTEST(RCU, Config_Swap) {
+	rcu_swap_test Test;
+	ak_thread* Threads[RCU_READER_COUNT];
+	rcu_config* Config = (rcu_config*)Allocate_Memory(sizeof(rcu_config));
+	uint32_t i, StartCount = AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+	Config->A = 0;
+	Config->B = 0;
+	Memory_Clear(&Test, sizeof(rcu_swap_test));
+	AK_Atomic_Store_Ptr(&Test.Config, Config, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < RCU_READER_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(RCU_Swap_Reader_Thread, &Test);
+	}
+
+	/*A reader that could still see an old version after its grace period would read freed memory*/
+	for(i = 1; i <= RCU_SWAP_COUNT; i++) {
+		rcu_config* OldConfig = (rcu_config*)AK_Atomic_Load_Ptr(&Test.Config, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		Config = (rcu_config*)Allocate_Memory(sizeof(rcu_config));
+		Config->A = i;
+		Config->B = i*2;
+		AK_RCU_Assign(&Test.Config, Config);
+		AK_RCU_Call(OldConfig, Reclaim_Test_Free);
+	}
+
+	AK_Atomic_Store_U32(&Test.IsDone, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	for(i = 0; i < RCU_READER_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+
+	AK_RCU_Synchronize();
+	ASSERT_TRUE(AK_Atomic_Load_U32(&G_Reclaim_Free_Count, AK_ATOMIC_MEMORY_ORDER_RELAXED)-StartCount == RCU_SWAP_COUNT);
+	Free_Memory(AK_Atomic_Load_Ptr(&Test.Config, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	AK_RCU_Thread_Exit();
+}
+
+UTEST(LF_Hashmap, Basic) {
+	ak_lf_hashmap Map;
+	uint64_t i;
+	ASSERT_TRUE(AK_LF_Hashmap_Create(&Map, 4));
+
+	/*Starts at the minimum capacity so this goes through a couple of resizes*/
+	for(i = 1; i <= 1000; i++) ASSERT_TRUE(AK_LF_Hashmap_Put(&Map, i, i*2) == 0);
+	ASSERT_TRUE(AK_LF_Hashmap_Size(&Map) == 1000);
+	for(i = 1; i <= 1000; i++) ASSERT_TRUE(AK_LF_Hashmap_Get(&Map, i) == i*2);
+	ASSERT_TRUE(AK_LF_Hashmap_Get(&Map, 1001) == 0);
+
+	ASSERT_TRUE(AK_LF_Hashmap_Put(&Map, 7, 70) == 14);
+	ASSERT_TRUE(AK_LF_Hashmap_Insert(&Map, 7, 700) == 70);
+	ASSERT_TRUE(AK_LF_Hashmap_Get(&Map, 7) == 70);
+	ASSERT_TRUE(AK_LF_Hashmap_Insert(&Map, 2000, 1) == 0);
+	ASSERT_TRUE(AK_LF_Hashmap_Get(&Map, 2000) == 1);
+
+	for(i = 2; i <= 1000; i += 2) ASSERT_TRUE(AK_LF_Hashmap_Remove(&Map, i) == i*2);
+	ASSERT_TRUE(AK_LF_Hashmap_Remove(&Map, 2) == 0);
+	ASSERT_TRUE(AK_LF_Hashmap_Size(&Map) == 501);
+	for(i = 1; i <= 1000; i++) {
+		if(i == 7) continue;
+		ASSERT_TRUE(AK_LF_Hashmap_Get(&Map, i) == ((i & 1) ? i*2 : 0));
+	}
+
+	/*Tombstoned keys can be written again*/
+	ASSERT_TRUE(AK_LF_Hashmap_Insert(&Map, 2, 3) == 0);
+	ASSERT_TRUE(AK_LF_Hashmap_Get(&Map, 2) == 3);
+
+	AK_LF_Hashmap_Delete(&Map);
+	AK_Epoch_Thread_Exit();
+}
+
+#define LF_HASHMAP_THREAD_COUNT 4
+#define LF_HASHMAP_KEY_COUNT 20000
+
+typedef struct {
+	ak_lf_hashmap Map;
+	ak_atomic_u32 ThreadIndex;
+	ak_atomic_u32 FailureCount;
+} lf_hashmap_test;
+
+/*Every thread owns a key range and reads other threads' keys while the map keeps resizing. A key
+  always maps to twice itself, so any other value that is read is a lost or torn write*/
+static AK_THREAD_CALLBACK_DEFINE(LF_Hashmap_Thread) {
+	lf_hashmap_test* Test = (lf_hashmap_test*)UserData;
+	uint64_t ThreadIndex = AK_Atomic_Fetch_Add_U32(&Test->ThreadIndex, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint64_t i, BaseKey = ThreadIndex*LF_HASHMAP_KEY_COUNT+1;
+	uint64_t OtherBaseKey = ((ThreadIndex+1) % LF_HASHMAP_THREAD_COUNT)*LF_HASHMAP_KEY_COUNT+1;
+	(void)Thread;
+
+	for(i = 0; i < LF_HASHMAP_KEY_COUNT; i++) {
+		uint64_t Key = BaseKey+i;
+		uint64_t Other = AK_LF_Hashmap_Get(&Test->Map, OtherBaseKey+i);
+		if(AK_LF_Hashmap_Insert(&Test->Map, Key, Key*2) != 0) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(Other != 0 && Other != (OtherBaseKey+i)*2) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if((i & 3) == 3 && AK_LF_Hashmap_Remove(&Test->Map, Key-1) != (Key-1)*2) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+	}
+
+	AK_Epoch_Thread_Exit();
+	return 0;
+}
+
+UTEST(LF_Hashmap, Concurrent_Resize) {
+	lf_hashmap_test Test;
+	ak_thread* Threads[LF_HASHMAP_THREAD_COUNT];
+	uint64_t i;
+
+	Memory_Clear(&Test, sizeof(lf_hashmap_test));
+	ASSERT_TRUE(AK_LF_Hashmap_Create(&Test.Map, 0));
+	for(i = 0; i < LF_HASHMAP_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(LF_Hashmap_Thread, &Test);
+	}
+	for(i = 0; i < LF_HASHMAP_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+	ASSERT_TRUE(AK_LF_Hashmap_Size(&Test.Map) == LF_HASHMAP_THREAD_COUNT*LF_HASHMAP_KEY_COUNT/4*3);
+	for(i = 0; i < LF_HASHMAP_THREAD_COUNT*LF_HASHMAP_KEY_COUNT; i++) {
+		uint64_t Key = i+1;
+		ASSERT_TRUE(AK_LF_Hashmap_Get(&Test.Map, Key) == ((i & 3) == 2 ? 0 : Key*2));
+	}
+
+	AK_LF_Hashmap_Delete(&Test.Map);
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Thread_Exit();
+}
+
+#define LF_HASHMAP_INSERT_KEY_COUNT 20000
+
+typedef struct {
+	ak_lf_hashmap Map;
+	ak_atomic_u32 ThreadIndex;
+	ak_atomic_u32 FailureCount;
+	ak_atomic_u32 WinCounts[LF_HASHMAP_INSERT_KEY_COUNT];
+	ak_atomic_u32 Winners[LF_HASHMAP_INSERT_KEY_COUNT];
+} lf_hashmap_insert_test;
+
+/*Every thread inserts the same keys while the map keeps resizing from its minimum capacity. 
+  Exactly one insert per key may succeed and every other one has to return the winner's value*/
+static AK_THREAD_CALLBACK_DEFINE(LF_Hashmap_Insert_Thread) {
+	lf_hashmap_insert_test* Test = (lf_hashmap_insert_test*)UserData;
+	uint32_t ThreadIndex = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint64_t i;
+	(void)Thread;
+
+	for(i = 0; i < LF_HASHMAP_INSERT_KEY_COUNT; i++) {
+		uint64_t Existing = AK_LF_Hashmap_Insert(&Test->Map, i+1, ThreadIndex);
+		if(!Existing) {
+			AK_Atomic_Increment_U32(&Test->WinCounts[i], AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_Atomic_Store_U32(&Test->Winners[i], ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		} else if(Existing > LF_HASHMAP_THREAD_COUNT) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		if((i & 255) == 0) AK_Thread_Yield();
+	}
+	return 0;
+}
+
+UTEST(LF_Hashmap, Concurrent_Insert) {
+	lf_hashmap_insert_test* Test = (lf_hashmap_insert_test*)Allocate_Memory(sizeof(lf_hashmap_insert_test));
+	ak_thread* Threads[LF_HASHMAP_THREAD_COUNT];
+	uint64_t i;
+
+	Memory_Clear(Test, sizeof(lf_hashmap_insert_test));
+	ASSERT_TRUE(AK_LF_Hashmap_Create(&Test->Map, 0));
+	for(i = 0; i < LF_HASHMAP_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(LF_Hashmap_Insert_Thread, Test);
+	}
+	for(i = 0; i < LF_HASHMAP_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+	ASSERT_TRUE(AK_LF_Hashmap_Size(&Test->Map) == LF_HASHMAP_INSERT_KEY_COUNT);
+	for(i = 0; i < LF_HASHMAP_INSERT_KEY_COUNT; i++) {
+		ASSERT_TRUE(AK_Atomic_Load_U32(&Test->WinCounts[i], AK_ATOMIC_MEMORY_ORDER_RELAXED) == 1);
+		ASSERT_TRUE(AK_LF_Hashmap_Get(&Test->Map, i+1) == AK_Atomic_Load_U32(&Test->Winners[i], AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	}
+
+	AK_LF_Hashmap_Delete(&Test->Map);
+	Free_Memory(Test);
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Thread_Exit();
+}
+
+/*Put and remove pairs keep the live size at zero, tombstones have to be dropped by migrating into
+  a table of the same size instead of doubling every time*/
+UTEST(LF_Hashmap, Churn) {
+	ak_lf_hashmap Map;
+	uint64_t i;
+	ASSERT_TRUE(AK_LF_Hashmap_Create(&Map, 64));
+
+	for(i = 1; i <= 200000; i++) {
+		ASSERT_TRUE(AK_LF_Hashmap_Put(&Map, i, i) == 0);
+		ASSERT_TRUE(AK_LF_Hashmap_Remove(&Map, i) == i);
+	}
+	ASSERT_TRUE(AK_LF_Hashmap_Size(&Map) == 0);
+	/*The capacity is the first member of the table header*/
+	ASSERT_TRUE(*(uint64_t*)AK_Atomic_Load_Ptr(&Map.Table, AK_ATOMIC_MEMORY_ORDER_RELAXED) <= 128);
+
+	AK_LF_Hashmap_Delete(&Map);
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Thread_Exit();
+}
+
+UTEST(Swiss_Set, Basic) {
+	ak_swiss_set Set;
+	uint64_t i;
+	ASSERT_TRUE(AK_Swiss_Set_Create(&Set, 1000));
+
+	for(i = 0; i < 1000; i++) ASSERT_TRUE(AK_Swiss_Set_Insert(&Set, i*7919));
+	ASSERT_FALSE(AK_Swiss_Set_Insert(&Set, 7919));
+	ASSERT_TRUE(AK_Swiss_Set_Count(&Set) == 1000);
+	for(i = 0; i < 1000; i++) {
+		ASSERT_TRUE(AK_Swiss_Set_Contains(&Set, i*7919));
+		ASSERT_FALSE(AK_Swiss_Set_Contains(&Set, i*7919+1));
+	}
+
+	for(i = 0; i < 1000; i += 2) ASSERT_TRUE(AK_Swiss_Set_Remove(&Set, i*7919));
+	ASSERT_FALSE(AK_Swiss_Set_Remove(&Set, 0));
+	ASSERT_TRUE(AK_Swiss_Set_Count(&Set) == 500);
+	for(i = 0; i < 1000; i++) ASSERT_TRUE(AK_Swiss_Set_Contains(&Set, i*7919) == (int8_t)(i & 1));
+
+	/*Deleted slots get reused*/
+	for(i = 0; i < 1000; i += 2) ASSERT_TRUE(AK_Swiss_Set_Insert(&Set, i*7919+3));
+	for(i = 0; i < 1000; i += 2) ASSERT_TRUE(AK_Swiss_Set_Contains(&Set, i*7919+3));
+	ASSERT_TRUE(AK_Swiss_Set_Count(&Set) == 1000);
+
+	AK_Swiss_Set_Delete(&Set);
+}
+
+#define SWISS_SET_THREAD_COUNT 4
+#define SWISS_SET_KEY_COUNT 50000
+
+typedef struct {
+	ak_swiss_set  Set;
+	ak_atomic_u32 InsertCount;
+	ak_atomic_u32 RemoveCount;
+	ak_atomic_u32 FailureCount;
+	ak_atomic_u32 InsertedThreadCount;
+} swiss_set_test;
+
+/*Every thread inserts the same keys, waits for the others and then removes them again, so exactly 
+  one insert and one remove per key has to succeed. Keys below that range are never touched and 
+  must always be found*/
+static AK_THREAD_CALLBACK_DEFINE(Swiss_Set_Thread) {
+	swiss_set_test* Test = (swiss_set_test*)UserData;
+	uint64_t i;
+	(void)Thread;
+
+	for(i = 1; i <= SWISS_SET_KEY_COUNT; i++) {
+		uint64_t Key = SWISS_SET_KEY_COUNT+i;
+		if(AK_Swiss_Set_Insert(&Test->Set, Key)) AK_Atomic_Increment_U32(&Test->InsertCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(!AK_Swiss_Set_Contains(&Test->Set, i)) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+
+	AK_Atomic_Increment_U32(&Test->InsertedThreadCount, AK_ATOMIC_MEMORY_ORDER_RELEASE);
+	while(AK_Atomic_Load_U32(&Test->InsertedThreadCount, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) != SWISS_SET_THREAD_COUNT) {
+		AK_Thread_Yield();
+	}
+
+	for(i = 1; i <= SWISS_SET_KEY_COUNT; i++) {
+		uint64_t Key = SWISS_SET_KEY_COUNT+i;
+		if(AK_Swiss_Set_Remove(&Test->Set, Key)) AK_Atomic_Increment_U32(&Test->RemoveCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		if(!AK_Swiss_Set_Contains(&Test->Set, i)) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	}
+	return 0;
+}
+
+UTEST(Swiss_Set, Concurrent) {
+	swiss_set_test Test;
+	ak_thread* Threads[SWISS_SET_THREAD_COUNT];
+	uint64_t i;
+
+	Memory_Clear(&Test, sizeof(swiss_set_test));
+	ASSERT_TRUE(AK_Swiss_Set_Create(&Test.Set, SWISS_SET_KEY_COUNT*2));
+	for(i = 1; i <= SWISS_SET_KEY_COUNT; i++) AK_Swiss_Set_Insert(&Test.Set, i);
+
+	for(i = 0; i < SWISS_SET_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Swiss_Set_Thread, &Test);
+	}
+	for(i = 0; i < SWISS_SET_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.InsertCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == SWISS_SET_KEY_COUNT);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.RemoveCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == SWISS_SET_KEY_COUNT);
+	ASSERT_TRUE(AK_Swiss_Set_Count(&Test.Set) == SWISS_SET_KEY_COUNT);
+	AK_Swiss_Set_Delete(&Test.Set);
+}
+
+#define SWISS_SET_CHURN_CAPACITY 1792
+#define SWISS_SET_CHURN_WINDOW 256
+#define SWISS_SET_CHURN_ITERATIONS 100000
+
+/*Every thread slides a window of live keys over its own key range. The set has 2048 slots, so 
+  tombstones have to be reused for the inserts to keep succeeding*/
+static AK_THREAD_CALLBACK_DEFINE(Swiss_Set_Churn_Thread) {
+	swiss_set_test* Test = (swiss_set_test*)UserData;
+	uint64_t Base = (uint64_t)AK_Atomic_Increment_U32(&Test->InsertedThreadCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) << 32;
+	uint64_t i;
+	(void)Thread;
+
+	for(i = 0; i < SWISS_SET_CHURN_ITERATIONS; i++) {
+		if(i >= SWISS_SET_CHURN_WINDOW && !AK_Swiss_Set_Remove(&Test->Set, Base+i-SWISS_SET_CHURN_WINDOW)) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		if(!AK_Swiss_Set_Insert(&Test->Set, Base+i) || !AK_Swiss_Set_Contains(&Test->Set, Base+i)) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		if(i >= SWISS_SET_CHURN_WINDOW && AK_Swiss_Set_Contains(&Test->Set, Base+i-SWISS_SET_CHURN_WINDOW)) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+		if((i & 1023) == 0) AK_Thread_Yield();
+	}
+	return 0;
+}
+
+UTEST(Swiss_Set, Churn) {
+	swiss_set_test Test;
+	ak_thread* Threads[SWISS_SET_THREAD_COUNT];
+	uint64_t i;
+
+	Memory_Clear(&Test, sizeof(swiss_set_test));
+	ASSERT_TRUE(AK_Swiss_Set_Create(&Test.Set, SWISS_SET_CHURN_CAPACITY));
+	ASSERT_TRUE(Test.Set.GroupMask == 127);
+	for(i = 0; i < SWISS_SET_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Swiss_Set_Churn_Thread, &Test);
+	}
+	for(i = 0; i < SWISS_SET_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+	ASSERT_TRUE(AK_Swiss_Set_Count(&Test.Set) == SWISS_SET_THREAD_COUNT*SWISS_SET_CHURN_WINDOW);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.Set.Generation, AK_ATOMIC_MEMORY_ORDER_RELAXED) != 0);
+
+	AK_Swiss_Set_Delete(&Test.Set);
+
+	/*A single thread with a window of half the slots*/
+	ASSERT_TRUE(AK_Swiss_Set_Create(&Test.Set, SWISS_SET_CHURN_CAPACITY));
+	for(i = 0; i < 200000; i++) {
+		if(i >= 1024) ASSERT_TRUE(AK_Swiss_Set_Remove(&Test.Set, i-1024));
+		ASSERT_TRUE(AK_Swiss_Set_Insert(&Test.Set, i));
+	}
+	AK_Swiss_Set_Delete(&Test.Set);
+}
+
+UTEST(LF_Skiplist, Basic) {
+	ak_lf_skiplist List;
+	ak_lf_skiplist_iterator Iterator;
+	uint64_t i, Value, ExpectedKey;
+	ASSERT_TRUE(AK_LF_Skiplist_Create(&List));
+
+	/*Insert out of order*/
+	for(i = 0; i < 1000; i++) ASSERT_TRUE(AK_LF_Skiplist_Insert(&List, (i*7) % 1000, i));
+	ASSERT_FALSE(AK_LF_Skiplist_Insert(&List, 7, 0));
+	ASSERT_TRUE(AK_LF_Skiplist_Count(&List) == 1000);
+	ASSERT_TRUE(AK_LF_Skiplist_Find(&List, 7, &Value));
+	ASSERT_TRUE(Value == 1);
+	ASSERT_FALSE(AK_LF_Skiplist_Find(&List, 1000, &Value));
+
+	for(i = 0; i < 1000; i += 2) ASSERT_TRUE(AK_LF_Skiplist_Remove(&List, i));
+	ASSERT_FALSE(AK_LF_Skiplist_Remove(&List, 0));
+	ASSERT_TRUE(AK_LF_Skiplist_Count(&List) == 500);
+	ASSERT_FALSE(AK_LF_Skiplist_Find(&List, 10, NULL));
+
+	/*Range scan from the middle*/
+	ExpectedKey = 501;
+	for(AK_LF_Skiplist_Iterator_Begin(&List, &Iterator, 500); Iterator.Node; AK_LF_Skiplist_Iterator_Next(&Iterator)) {
+		ASSERT_TRUE(Iterator.Key == ExpectedKey);
+		ExpectedKey += 2;
+	}
+	AK_LF_Skiplist_Iterator_End(&Iterator);
+	ASSERT_TRUE(ExpectedKey == 1001);
+
+	ASSERT_FALSE(AK_LF_Skiplist_Iterator_Begin(&List, &Iterator, 1000));
+	AK_LF_Skiplist_Iterator_End(&Iterator);
+
+	AK_LF_Skiplist_Delete(&List);
+	AK_Epoch_Thread_Exit();
+}
+
+#define LF_SKIPLIST_THREAD_COUNT 4
+#define LF_SKIPLIST_KEY_COUNT 4096
+#define LF_SKIPLIST_ITERATIONS 20000
+
+typedef struct {
+	ak_lf_skiplist List;
+	ak_atomic_u32  ThreadIndex;
+	ak_atomic_u32  FailureCount;
+	ak_atomic_u64  InsertCount;
+	ak_atomic_u64  RemoveCount;
+} lf_skiplist_test;
+
+/*Threads insert and remove random keys while scanning ranges. Scans have to see keys in strictly 
+  increasing order and the number of successful inserts minus removes has to match what is left*/
+static AK_THREAD_CALLBACK_DEFINE(LF_Skiplist_Thread) {
+	lf_skiplist_test* Test = (lf_skiplist_test*)UserData;
+	uint64_t State = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED)*0x9E3779B97F4A7C15ull;
+	uint32_t i;
+	(void)Thread;
+
+	for(i = 0; i < LF_SKIPLIST_ITERATIONS; i++) {
+		uint64_t Key;
+		State ^= State << 13;
+		State ^= State >> 7;
+		State ^= State << 17;
+		Key = State % LF_SKIPLIST_KEY_COUNT;
+
+		if(State & (1ull << 40)) {
+			if(AK_LF_Skiplist_Insert(&Test->List, Key, Key*3)) AK_Atomic_Increment_U64(&Test->InsertCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		} else {
+			if(AK_LF_Skiplist_Remove(&Test->List, Key)) AK_Atomic_Increment_U64(&Test->RemoveCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+
+		if((i & 255) == 0) {
+			ak_lf_skiplist_iterator Iterator;
+			uint64_t LastKey = Key;
+			uint32_t Steps = 0;
+			if(AK_LF_Skiplist_Iterator_Begin(&Test->List, &Iterator, Key)) {
+				if(Iterator.Key < Key) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				LastKey = Iterator.Key;
+				while(Steps++ < 64 && AK_LF_Skiplist_Iterator_Next(&Iterator)) {
+					if(Iterator.Key <= LastKey || Iterator.Value != Iterator.Key*3) {
+						AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+					}
+					LastKey = Iterator.Key;
+				}
+			}
+			AK_LF_Skiplist_Iterator_End(&Iterator);
+		}
+	}
+
+	AK_Epoch_Thread_Exit();
+	return 0;
+}
+
+UTEST(LF_Skiplist, Concurrent) {
+	lf_skiplist_test Test;
+	ak_thread* Threads[LF_SKIPLIST_THREAD_COUNT];
+	ak_lf_skiplist_iterator Iterator;
+	uint64_t i, Count = 0;
+
+	Memory_Clear(&Test, sizeof(lf_skiplist_test));
+	ASSERT_TRUE(AK_LF_Skiplist_Create(&Test.List));
+	for(i = 0; i < LF_SKIPLIST_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(LF_Skiplist_Thread, &Test);
+	}
+	for(i = 0; i < LF_SKIPLIST_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+	for(AK_LF_Skiplist_Iterator_Begin(&Test.List, &Iterator, 0); Iterator.Node; AK_LF_Skiplist_Iterator_Next(&Iterator)) Count++;
+	AK_LF_Skiplist_Iterator_End(&Iterator);
+	ASSERT_TRUE(Count == AK_Atomic_Load_U64(&Test.InsertCount, AK_ATOMIC_MEMORY_ORDER_RELAXED)-AK_Atomic_Load_U64(&Test.RemoveCount, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	ASSERT_TRUE(Count == AK_LF_Skiplist_Count(&Test.List));
+
+	AK_LF_Skiplist_Delete(&Test.List);
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Collect();
+	AK_Epoch_Thread_Exit();
+}
+
+UTEST(OLC_BTree, Basic) {
+	ak_olc_btree Tree;
+	uint64_t Keys[100];
+	uint64_t Values[100];
+	uint64_t i, Value, ExpectedKey;
+	uint32_t j, Count;
+	ASSERT_TRUE(AK_OLC_BTree_Create(&Tree));
+
+	/*Insert out of order, enough for a few levels*/
+	for(i = 0; i < 10000; i++) ASSERT_TRUE(AK_OLC_BTree_Insert(&Tree, (i*7) % 10000, i));
+	ASSERT_FALSE(AK_OLC_BTree_Insert(&Tree, 7, 0));
+	ASSERT_TRUE(AK_OLC_BTree_Count(&Tree) == 10000);
+	ASSERT_TRUE(AK_OLC_BTree_Find(&Tree, 7, &Value));
+	ASSERT_TRUE(Value == 1);
+	ASSERT_FALSE(AK_OLC_BTree_Find(&Tree, 10000, &Value));
+
+	for(i = 0; i < 10000; i += 2) ASSERT_TRUE(AK_OLC_BTree_Remove(&Tree, i));
+	ASSERT_FALSE(AK_OLC_BTree_Remove(&Tree, 0));
+	ASSERT_TRUE(AK_OLC_BTree_Count(&Tree) == 5000);
+	ASSERT_FALSE(AK_OLC_BTree_Find(&Tree, 10, NULL));
+
+	/*Range scan from the middle in chunks*/
+	ExpectedKey = 5001;
+	while((Count = AK_OLC_BTree_Scan(&Tree, ExpectedKey, Keys, Values, 100)) != 0) {
+		for(j = 0; j < Count; j++) {
+			ASSERT_TRUE(Keys[j] == ExpectedKey);
+			ASSERT_TRUE(Values[j] == (ExpectedKey*7143) % 10000);
+			ExpectedKey += 2;
+		}
+	}
+	ASSERT_TRUE(ExpectedKey == 10001);
+	ASSERT_TRUE(AK_OLC_BTree_Scan(&Tree, 10000, Keys, NULL, 100) == 0);
+
+	AK_OLC_BTree_Delete(&Tree);
+}
+
+#define OLC_BTREE_THREAD_COUNT 4
+#define OLC_BTREE_KEY_COUNT 8192
+#define OLC_BTREE_ITERATIONS 50000
+
+typedef struct {
+	ak_olc_btree  Tree;
+	ak_atomic_u32 ThreadIndex;
+	ak_atomic_u32 FailureCount;
+	ak_atomic_u64 InsertCount;
+	ak_atomic_u64 RemoveCount;
+} olc_btree_test;
+
+/*Threads insert, remove and look up random keys while scanning ranges. Scans have to see keys in 
+  strictly increasing order and the number of successful inserts minus removes has to match what is 
+  left*/
+static AK_THREAD_CALLBACK_DEFINE(OLC_BTree_Thread) {
+	olc_btree_test* Test = (olc_btree_test*)UserData;
+	uint64_t State = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED)*0x9E3779B97F4A7C15ull;
+	uint64_t Keys[64];
+	uint64_t Values[64];
+	uint32_t i;
+	(void)Thread;
+
+	for(i = 0; i < OLC_BTREE_ITERATIONS; i++) {
+		uint64_t Key, Value;
+		State ^= State << 13;
+		State ^= State >> 7;
+		State ^= State << 17;
+		Key = State % OLC_BTREE_KEY_COUNT;
+
+		switch((State >> 40) & 3) {
+			case 0:
+			case 1: {
+				if(AK_OLC_BTree_Insert(&Test->Tree, Key, Key*3)) AK_Atomic_Increment_U64(&Test->InsertCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			} break;
+
+			case 2: {
+				if(AK_OLC_BTree_Remove(&Test->Tree, Key)) AK_Atomic_Increment_U64(&Test->RemoveCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			} break;
+
+			default: {
+				if(AK_OLC_BTree_Find(&Test->Tree, Key, &Value) && Value != Key*3) {
+					AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				}
+			} break;
+		}
+
+		if((i & 255) == 0) {
+			uint32_t j, Count = AK_OLC_BTree_Scan(&Test->Tree, Key, Keys, Values, 64);
+			for(j = 0; j < Count; j++) {
+				if(Keys[j] < Key || (j && Keys[j] <= Keys[j-1]) || Values[j] != Keys[j]*3) {
+					AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+UTEST(OLC_BTree, Concurrent) {
+	olc_btree_test Test;
+	ak_thread* Threads[OLC_BTREE_THREAD_COUNT];
+	uint64_t Keys[256];
+	uint64_t i, StartKey = 0, Count = 0;
+	uint32_t ScanCount;
+
+	Memory_Clear(&Test, sizeof(olc_btree_test));
+	ASSERT_TRUE(AK_OLC_BTree_Create(&Test.Tree));
+	for(i = 0; i < OLC_BTREE_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(OLC_BTree_Thread, &Test);
+	}
+	for(i = 0; i < OLC_BTREE_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+	while((ScanCount = AK_OLC_BTree_Scan(&Test.Tree, StartKey, Keys, NULL, 256)) != 0) {
+		Count += ScanCount;
+		StartKey = Keys[ScanCount-1]+1;
+	}
+	ASSERT_TRUE(Count == AK_Atomic_Load_U64(&Test.InsertCount, AK_ATOMIC_MEMORY_ORDER_RELAXED)-AK_Atomic_Load_U64(&Test.RemoveCount, AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	ASSERT_TRUE(Count == AK_OLC_BTree_Count(&Test.Tree));
+	AK_OLC_BTree_Delete(&Test.Tree);
+}
+
+UTEST(Object_Pool, Basic) {
+	ak_object_pool Pool;
+	void* Objects[1000];
+	uint32_t i, j, ReuseCount = 0;
+	ASSERT_TRUE(AK_Object_Pool_Create(&Pool, 24));
+
+	for(i = 0; i < 1000; i++) {
+		Objects[i] = AK_Object_Pool_Allocate(&Pool);
+		ASSERT_TRUE(Objects[i] != NULL);
+		ASSERT_TRUE(((size_t)Objects[i] & 15) == 0 || sizeof(void*) == 4);
+		Memory_Clear(Objects[i], 24);
+	}
+	for(i = 1; i < 1000; i++) ASSERT_TRUE(Objects[i] != Objects[i-1]);
+	for(i = 0; i < 1000; i++) AK_Object_Pool_Free(&Pool, Objects[i]);
+
+	/*Everything freed has to come back before the pool grows*/
+	for(i = 0; i < 1000; i++) {
+		void* Object = AK_Object_Pool_Allocate(&Pool);
+		for(j = 0; j < 1000; j++) {
+			if(Objects[j] == Object) {
+				ReuseCount++;
+				break;
+			}
+		}
+	}
+	ASSERT_TRUE(ReuseCount == 1000);
+
+	AK_Object_Pool_Thread_Exit(&Pool);
+	AK_Object_Pool_Delete(&Pool);
+}
+
+#define OBJECT_POOL_THREAD_COUNT 4
+#define OBJECT_POOL_SLOT_COUNT 256
+#define OBJECT_POOL_ITERATIONS 200000
+
+typedef struct {
+	uint64_t Token;
+	uint64_t Padding;
+} object_pool_item;
+
+typedef struct {
+	ak_object_pool Pool;
+	ak_atomic_ptr  Slots[OBJECT_POOL_SLOT_COUNT];
+	ak_atomic_u32  ThreadIndex;
+	ak_atomic_u32  FailureCount;
+} object_pool_test;
+
+/*Threads allocate objects and swap them into shared slots, freeing whatever another thread left 
+  there, so most objects are freed on a different thread. An object handed out twice gets its token
+  overwritten before it is published*/
+static AK_THREAD_CALLBACK_DEFINE(Object_Pool_Thread) {
+	object_pool_test* Test = (object_pool_test*)UserData;
+	uint64_t ThreadIndex = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t i;
+	(void)Thread;
+
+	for(i = 0; i < OBJECT_POOL_ITERATIONS; i++) {
+		uint64_t Token = (ThreadIndex << 32) | i;
+		object_pool_item* Item = (object_pool_item*)AK_Object_Pool_Allocate(&Test->Pool);
+		object_pool_item* Old;
+		if(!Item) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			break;
+		}
+
+		Item->Token = Token;
+		if((i & 7) == 0) AK_Thread_Yield();
+		if(Item->Token != Token) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+		Old = (object_pool_item*)AK_Atomic_Exchange_Ptr(&Test->Slots[(i*7+ThreadIndex) % OBJECT_POOL_SLOT_COUNT], Item, AK_ATOMIC_MEMORY_ORDER_ACQ_REL);
+		AK_Object_Pool_Free(&Test->Pool, Old);
+	}
+
+	AK_Object_Pool_Thread_Exit(&Test->Pool);
+	return 0;
+}
+
+UTEST(Object_Pool, Cross_Thread_Free) {
+	object_pool_test Test;
+	ak_thread* Threads[OBJECT_POOL_THREAD_COUNT];
+	uint32_t i;
+
+	Memory_Clear(&Test, sizeof(object_pool_test));
+	ASSERT_TRUE(AK_Object_Pool_Create(&Test.Pool, sizeof(object_pool_item)));
+	for(i = 0; i < OBJECT_POOL_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Object_Pool_Thread, &Test);
+	}
+	for(i = 0; i < OBJECT_POOL_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+
+	for(i = 0; i < OBJECT_POOL_SLOT_COUNT; i++) {
+		AK_Object_Pool_Free(&Test.Pool, AK_Atomic_Load_Ptr(&Test.Slots[i], AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	}
+	AK_Object_Pool_Thread_Exit(&Test.Pool);
+	AK_Object_Pool_Delete(&Test.Pool);
+}
+
+UTEST(Arena, Basic) {
+	ak_arena Arena;
+	uint8_t* First;
+	uint8_t* Second;
+	uint8_t* Big;
+	uint32_t i;
+	ASSERT_TRUE(AK_Arena_Create(&Arena, 1024*1024));
+
+	First = (uint8_t*)AK_Arena_Allocate(&Arena, 13, 1);
+	Second = (uint8_t*)AK_Arena_Allocate(&Arena, 32, 16);
+	ASSERT_TRUE(First && Second);
+	ASSERT_TRUE(((size_t)Second & 15) == 0);
+	ASSERT_TRUE(Second >= First+13);
+	for(i = 0; i < 13; i++) First[i] = 1;
+	for(i = 0; i < 32; i++) Second[i] = 2;
+
+	/*Doesn't fit in a chunk, comes straight from the shared offset*/
+	Big = (uint8_t*)AK_Arena_Allocate(&Arena, AK_ARENA_CHUNK_SIZE, 4096);
+	ASSERT_TRUE(Big != NULL);
+	ASSERT_TRUE(((size_t)Big & 4095) == 0);
+	for(i = 0; i < AK_ARENA_CHUNK_SIZE; i++) Big[i] = 3;
+	for(i = 0; i < 13; i++) ASSERT_TRUE(First[i] == 1);
+	for(i = 0; i < 32; i++) ASSERT_TRUE(Second[i] == 2);
+
+	/*Sizes and alignments that would wrap once padded are rejected instead of handing out memory*/
+	ASSERT_TRUE(AK_Arena_Allocate(&Arena, (size_t)-1, 1) == NULL);
+	ASSERT_TRUE(AK_Arena_Allocate(&Arena, (size_t)-1 - 64, 4096) == NULL);
+	ASSERT_TRUE(AK_Arena_Allocate(&Arena, 16, (size_t)1 << (sizeof(size_t)*8-1)) == NULL);
+	for(i = 0; i < 13; i++) ASSERT_TRUE(First[i] == 1);
+
+	/*Runs out of the reservation*/
+	ASSERT_TRUE(AK_Arena_Allocate(&Arena, 1024*1024, 1) == NULL);
+	ASSERT_TRUE(AK_Arena_Used(&Arena) <= 1024*1024);
+
+	AK_Arena_Reset(&Arena);
+	ASSERT_TRUE(AK_Arena_Used(&Arena) == 0);
+	ASSERT_TRUE(AK_Arena_Allocate(&Arena, 13, 1) == First);
+
+	AK_Arena_Delete(&Arena);
+}
+
+#define ARENA_THREAD_COUNT 4
+#define ARENA_ALLOCATION_COUNT 20000
+
+typedef struct {
+	ak_arena 	  Arena;
+	ak_atomic_u32 ThreadIndex;
+	ak_atomic_u32 FailureCount;
+} arena_test;
+
+/*Every thread stamps its allocations with its index and checks them afterwards, overlapping 
+  allocations overwrite each other's stamps*/
+static AK_THREAD_CALLBACK_DEFINE(Arena_Thread) {
+	arena_test* Test = (arena_test*)UserData;
+	uint32_t ThreadIndex = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t** Allocations = (uint32_t**)AK_Arena_Allocate(&Test->Arena, sizeof(uint32_t*)*ARENA_ALLOCATION_COUNT, sizeof(void*));
+	uint32_t i, j;
+	(void)Thread;
+
+	if(!Allocations) {
+		AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		return 0;
+	}
+
+	for(i = 0; i < ARENA_ALLOCATION_COUNT; i++) {
+		uint32_t Count = 1+(i % 9);
+		Allocations[i] = (uint32_t*)AK_Arena_Allocate(&Test->Arena, sizeof(uint32_t)*Count, sizeof(uint32_t));
+		if(!Allocations[i]) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			return 0;
+		}
+		for(j = 0; j < Count; j++) Allocations[i][j] = ThreadIndex;
+	}
+
+	for(i = 0; i < ARENA_ALLOCATION_COUNT; i++) {
+		for(j = 0; j < 1+(i % 9); j++) {
+			if(Allocations[i][j] != ThreadIndex) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		}
+	}
+	return 0;
+}
+
+UTEST(Arena, Concurrent) {
+	arena_test Test;
+	ak_thread* Threads[ARENA_THREAD_COUNT];
+	uint32_t i, Round;
+
+	Memory_Clear(&Test, sizeof(arena_test));
+	ASSERT_TRUE(AK_Arena_Create(&Test.Arena, 64*1024*1024));
+
+	/*The second round runs on the memory of the first*/
+	for(Round = 0; Round < 2; Round++) {
+		for(i = 0; i < ARENA_THREAD_COUNT; i++) {
+			Threads[i] = AK_Thread_Create(Arena_Thread, &Test);
+		}
+		for(i = 0; i < ARENA_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+		ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+		ASSERT_TRUE(AK_Arena_Used(&Test.Arena) >= ARENA_THREAD_COUNT*ARENA_ALLOCATION_COUNT*sizeof(uint32_t));
+		AK_Arena_Reset(&Test.Arena);
+	}
+
+	AK_Arena_Delete(&Test.Arena);
+}
+
+UTEST(Arena, Heap_Allocated) {
+	ak_arena* Arena = (ak_arena*)AK_Atomic_Aligned_Allocate(sizeof(ak_arena), AK_ATOMIC_CACHE_LINE_SIZE);
+	void* Memory;
+	ASSERT_TRUE(Arena != NULL);
+	ASSERT_TRUE(((size_t)Arena & (AK_ATOMIC_CACHE_LINE_SIZE-1)) == 0);
+	ASSERT_TRUE(AK_Arena_Create(Arena, 1024*1024));
+	Memory = AK_Arena_Allocate(Arena, 64, 16);
+	ASSERT_TRUE(Memory != NULL);
+	AK_Arena_Delete(Arena);
+	AK_Atomic_Aligned_Free(Arena);
+
+	/*Small alignments still leave room for the stored pointer*/
+	Memory = AK_Atomic_Aligned_Allocate(1, 1);
+	ASSERT_TRUE(Memory != NULL);
+	AK_Atomic_Aligned_Free(Memory);
+	ASSERT_TRUE(AK_Atomic_Aligned_Allocate((size_t)-1, 64) == NULL);
+	AK_Atomic_Aligned_Free(NULL);
+}
+
+UTEST(Slab, Basic) {
+	ak_slab Slab;
+	uint8_t* Blocks[512];
+	uint8_t* Large;
+	uint32_t i, j;
+	ASSERT_TRUE(AK_Slab_Create(&Slab, 16*1024*1024));
+
+	/*Every size class once, and a few pages worth of the small ones*/
+	for(i = 0; i < 512; i++) {
+		size_t Size = i < 256 ? 1+i*(AK_SLAB_MAX_SIZE/256) : 1+(i % 48);
+		Blocks[i] = (uint8_t*)AK_Slab_Allocate(&Slab, Size);
+		ASSERT_TRUE(Blocks[i] != NULL);
+		ASSERT_TRUE(((size_t)Blocks[i] & 15) == 0);
+		for(j = 0; j < Size; j++) Blocks[i][j] = (uint8_t)i;
+	}
+	for(i = 0; i < 512; i++) {
+		size_t Size = i < 256 ? 1+i*(AK_SLAB_MAX_SIZE/256) : 1+(i % 48);
+		for(j = 0; j < Size; j++) ASSERT_TRUE(Blocks[i][j] == (uint8_t)i);
+	}
+
+	/*A freed block is the next one handed out for its class*/
+	AK_Slab_Free(&Slab, Blocks[300]);
+	ASSERT_TRUE(AK_Slab_Allocate(&Slab, 1+(300 % 48)) == Blocks[300]);
+	for(i = 0; i < 512; i++) AK_Slab_Free(&Slab, Blocks[i]);
+
+	Large = (uint8_t*)AK_Slab_Allocate(&Slab, AK_SLAB_MAX_SIZE*4);
+	ASSERT_TRUE(Large != NULL);
+	ASSERT_TRUE(((size_t)Large & 15) == 0);
+	for(i = 0; i < AK_SLAB_MAX_SIZE*4; i++) Large[i] = 1;
+	AK_Slab_Free(&Slab, Large);
+	AK_Slab_Free(&Slab, NULL);
+
+	AK_Slab_Thread_Exit(&Slab);
+	AK_Slab_Delete(&Slab);
+}
+
+#define SLAB_THREAD_COUNT 4
+#define SLAB_SLOT_COUNT 1024
+#define SLAB_ITERATIONS 200000
+
+typedef struct {
+	ak_slab 	  Slab;
+	ak_atomic_ptr Slots[SLAB_SLOT_COUNT];
+	ak_atomic_u32 ThreadIndex;
+	ak_atomic_u32 FailureCount;
+} slab_test;
+
+/*Producer and consumer pipeline: threads allocate blocks of varying size, stamp them and swap them 
+  into shared slots, freeing whatever another thread left there. Nearly every free is remote and a 
+  block that is handed out twice loses its stamp*/
+static AK_THREAD_CALLBACK_DEFINE(Slab_Thread) {
+	slab_test* Test = (slab_test*)UserData;
+	uint32_t ThreadIndex = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t i;
+	(void)Thread;
+
+	for(i = 0; i < SLAB_ITERATIONS; i++) {
+		uint32_t Stamp = (ThreadIndex << 24) | (i & 0xFFFFFF);
+		uint32_t Size = 8+((i*37) % 500);
+		uint32_t* Block = (uint32_t*)AK_Slab_Allocate(&Test->Slab, Size);
+		uint32_t* Old;
+		if(!Block) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			break;
+		}
+
+		Block[0] = Stamp;
+		Block[1] = Size;
+		if((i & 15) == 0) AK_Thread_Yield();
+		if(Block[0] != Stamp || Block[1] != Size) AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+
+		Old = (uint32_t*)AK_Atomic_Exchange_Ptr(&Test->Slots[(i*13+ThreadIndex) % SLAB_SLOT_COUNT], Block, AK_ATOMIC_MEMORY_ORDER_ACQ_REL);
+		AK_Slab_Free(&Test->Slab, Old);
+	}
+
+	AK_Slab_Thread_Exit(&Test->Slab);
+	return 0;
+}
+
+UTEST(Slab, Cross_Thread_Free) {
+	slab_test Test;
+	ak_thread* Threads[SLAB_THREAD_COUNT];
+	uint32_t i;
+
+	Memory_Clear(&Test, sizeof(slab_test));
+	ASSERT_TRUE(AK_Slab_Create(&Test.Slab, 256*1024*1024));
+	for(i = 0; i < SLAB_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Slab_Thread, &Test);
+	}
+	for(i = 0; i < SLAB_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+
+	/*Remote frees have to be reused, otherwise the pipeline would have gone through about 200 MiB*/
+	ASSERT_TRUE(AK_Atomic_Load_U64(&Test.Slab.Offset.Value, AK_ATOMIC_MEMORY_ORDER_RELAXED) < 32*1024*1024);
+
+	/*Adopts one of the abandoned heaps*/
+	for(i = 0; i < SLAB_SLOT_COUNT; i++) {
+		AK_Slab_Free(&Test.Slab, AK_Atomic_Load_Ptr(&Test.Slots[i], AK_ATOMIC_MEMORY_ORDER_RELAXED));
+	}
+	ASSERT_TRUE(AK_Slab_Allocate(&Test.Slab, 64) != NULL);
+	AK_Slab_Thread_Exit(&Test.Slab);
+	AK_Slab_Delete(&Test.Slab);
+}
+
+UTEST(Page, Allocate) {
+	size_t Size = 2*AK_PAGE_HUGE_SIZE+4096;
+	size_t i;
+	uint8_t* Memory = (uint8_t*)AK_Page_Allocate(Size);
+	ASSERT_TRUE(Memory != NULL);
+	ASSERT_TRUE(((size_t)Memory & (AK_PAGE_HUGE_SIZE-1)) == 0);
+
+	AK_Page_Prefault(Memory, Size);
+	for(i = 0; i < Size; i += 4096) {
+		ASSERT_TRUE(Memory[i] == 0);
+		Memory[i] = (uint8_t)(i >> 12);
+	}
+	for(i = 0; i < Size; i += 4096) {
+		ASSERT_TRUE(Memory[i] == (uint8_t)(i >> 12));
+	}
+	AK_Page_Free(Memory, Size);
+
+	Memory = (uint8_t*)AK_Page_Allocate(64);
+	ASSERT_TRUE(Memory != NULL);
+	Memory[63] = 1;
+	AK_Page_Free(Memory, 64);
+	ASSERT_TRUE(AK_Page_Allocate(0) == NULL);
+}
+
+UTEST(ID_Pool, Basic) {
+	ak_id_pool Pool;
+	uint8_t Seen[100];
+	uint32_t i, ID;
+
+	Memory_Clear(Seen, sizeof(Seen));
+	ASSERT_TRUE(AK_ID_Pool_Create(&Pool, 100));
+	ASSERT_TRUE(Pool.Summary == NULL);
+	for(i = 0; i < 100; i++) {
+		ID = AK_ID_Pool_Allocate(&Pool);
+		ASSERT_TRUE(ID < 100);
+		ASSERT_FALSE(Seen[ID]);
+		ASSERT_TRUE(AK_ID_Pool_Is_Allocated(&Pool, ID));
+		Seen[ID] = 1;
+	}
+	ASSERT_TRUE(AK_ID_Pool_Allocate(&Pool) == AK_ID_POOL_INVALID);
+
+	AK_ID_Pool_Free(&Pool, 7);
+	AK_ID_Pool_Free(&Pool, 99);
+	ASSERT_FALSE(AK_ID_Pool_Is_Allocated(&Pool, 7));
+	ID = AK_ID_Pool_Allocate(&Pool);
+	ASSERT_TRUE(ID == 7 || ID == 99);
+	ID = AK_ID_Pool_Allocate(&Pool);
+	ASSERT_TRUE(ID == 7 || ID == 99);
+	ASSERT_TRUE(AK_ID_Pool_Allocate(&Pool) == AK_ID_POOL_INVALID);
+	AK_ID_Pool_Delete(&Pool);
+}
+
+#define ID_POOL_SUMMARY_CAPACITY 1000003
+
+/*Capacity that isn't a multiple of 64 words, so both the last word and the last summary word have 
+  padding bits*/
+UTEST(ID_Pool, Summary) {
+	ak_id_pool Pool;
+	uint32_t i, ID;
+	uint64_t Sum = 0;
+
+	ASSERT_TRUE(AK_ID_Pool_Create(&Pool, ID_POOL_SUMMARY_CAPACITY));
+	ASSERT_TRUE(Pool.Summary != NULL);
+	for(i = 0; i < ID_POOL_SUMMARY_CAPACITY; i++) {
+		ID = AK_ID_Pool_Allocate(&Pool);
+		ASSERT_TRUE(ID < ID_POOL_SUMMARY_CAPACITY);
+		Sum += ID;
+	}
+	/*Every ID exactly once*/
+	ASSERT_TRUE(Sum == (uint64_t)ID_POOL_SUMMARY_CAPACITY*(ID_POOL_SUMMARY_CAPACITY-1)/2);
+	ASSERT_TRUE(AK_ID_Pool_Allocate(&Pool) == AK_ID_POOL_INVALID);
+
+	/*A single free ID far away from the hint is found through the summary*/
+	AK_ID_Pool_Free(&Pool, 500000);
+	ASSERT_TRUE(AK_ID_Pool_Allocate(&Pool) == 500000);
+	AK_ID_Pool_Free(&Pool, ID_POOL_SUMMARY_CAPACITY-1);
+	AK_ID_Pool_Free(&Pool, 3);
+	ID = AK_ID_Pool_Allocate(&Pool);
+	ASSERT_TRUE(ID == 3 || ID == ID_POOL_SUMMARY_CAPACITY-1);
+	ID = AK_ID_Pool_Allocate(&Pool);
+	ASSERT_TRUE(ID == 3 || ID == ID_POOL_SUMMARY_CAPACITY-1);
+	ASSERT_TRUE(AK_ID_Pool_Allocate(&Pool) == AK_ID_POOL_INVALID);
+	AK_ID_Pool_Delete(&Pool);
+}
+
+#define ID_POOL_THREAD_COUNT 4
+#define ID_POOL_CAPACITY 5000
+#define ID_POOL_HELD 1000
+#define ID_POOL_ITERATIONS 100000
+
+typedef struct {
+	ak_id_pool 	  Pool;
+	ak_atomic_u32 Owners[ID_POOL_CAPACITY];
+	ak_atomic_u32 ThreadIndex;
+	ak_atomic_u32 FailureCount;
+} id_pool_test;
+
+/*Threads keep a window of IDs and recycle the oldest one every iteration. The pool runs nearly full,
+  so words fill up and drain constantly. An ID handed out twice shows up as an owner that is already 
+  set*/
+static AK_THREAD_CALLBACK_DEFINE(ID_Pool_Thread) {
+	id_pool_test* Test = (id_pool_test*)UserData;
+	uint32_t ThreadIndex = AK_Atomic_Increment_U32(&Test->ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	uint32_t Held[ID_POOL_HELD];
+	uint32_t i;
+	(void)Thread;
+
+	for(i = 0; i < ID_POOL_ITERATIONS; i++) {
+		uint32_t Slot = i % ID_POOL_HELD;
+		uint32_t ID, Expected = 0;
+		if(i >= ID_POOL_HELD) {
+			AK_Atomic_Store_U32(&Test->Owners[Held[Slot]], 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_ID_Pool_Free(&Test->Pool, Held[Slot]);
+		}
+
+		ID = AK_ID_Pool_Allocate(&Test->Pool);
+		if(ID >= ID_POOL_CAPACITY || !AK_Atomic_Compare_Exchange_Strong_U32(&Test->Owners[ID], &Expected, ThreadIndex, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+			AK_Atomic_Increment_U32(&Test->FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			break;
+		}
+		Held[Slot] = ID;
+		if((i & 255) == 0) AK_Thread_Yield();
+	}
+	return 0;
+}
+
+UTEST(ID_Pool, Concurrent) {
+	id_pool_test Test;
+	ak_thread* Threads[ID_POOL_THREAD_COUNT];
+	uint32_t i, Count = 0;
+
+	Memory_Clear(&Test, sizeof(id_pool_test));
+	ASSERT_TRUE(AK_ID_Pool_Create(&Test.Pool, ID_POOL_CAPACITY));
+	ASSERT_TRUE(Test.Pool.Summary != NULL);
+	for(i = 0; i < ID_POOL_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(ID_Pool_Thread, &Test);
+	}
+	for(i = 0; i < ID_POOL_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Test.FailureCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+
+	for(i = 0; i < ID_POOL_CAPACITY; i++) {
+		if(AK_ID_Pool_Is_Allocated(&Test.Pool, i)) Count++;
+	}
+	ASSERT_TRUE(Count == ID_POOL_THREAD_COUNT*ID_POOL_HELD);
+	AK_ID_Pool_Delete(&Test.Pool);
+}
+
+#define PERCPU_THREAD_COUNT 4
+#define PERCPU_ITERATIONS 100000
+#define PERCPU_NODE_COUNT 64
+
+static AK_THREAD_CALLBACK_DEFINE(PerCPU_Counter_Thread) {
+	ak_percpu_counter* Counter = (ak_percpu_counter*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < PERCPU_ITERATIONS; i++) {
+		AK_PerCPU_Add_U64(Counter, i & 1 ? 3 : 1);
+	}
+	return 0;
+}
+
+UTEST(PerCPU, Counter) {
+	ak_percpu_counter Counter;
+	ak_thread* Threads[PERCPU_THREAD_COUNT];
+	uint32_t i;
+
+	ASSERT_TRUE(AK_PerCPU_Counter_Create(&Counter));
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(PerCPU_Counter_Thread, &Counter);
+	}
+	AK_PerCPU_Add_U64(&Counter, 7);
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_PerCPU_Counter_Load(&Counter) == 7ull + (uint64_t)PERCPU_THREAD_COUNT*PERCPU_ITERATIONS*2);
+	AK_PerCPU_Counter_Delete(&Counter);
+}
+
+typedef struct {
+	ak_percpu_list_node Node;
+	ak_atomic_u32 		IsOwned;
+	uint32_t 			Padding;
+} percpu_list_item;
+
+typedef struct {
+	ak_percpu_list*   List;
+	percpu_list_item* Items;
+	ak_atomic_u32 	  ErrorCount;
+	int32_t 		  LIFOResult;
+} percpu_list_data;
+
+static AK_THREAD_CALLBACK_DEFINE(PerCPU_List_Thread) {
+	percpu_list_data* Data = (percpu_list_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < PERCPU_ITERATIONS; i++) {
+		percpu_list_item* Item = (percpu_list_item*)AK_PerCPU_List_Pop(Data->List);
+		if(Item) {
+			if(Item < Data->Items || Item >= Data->Items+PERCPU_NODE_COUNT || 
+			   AK_Atomic_Exchange_U32(&Item->IsOwned, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED)) {
+				AK_Atomic_Increment_U32(&Data->ErrorCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+				break;
+			}
+			AK_Atomic_Store_U32(&Item->IsOwned, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+			AK_PerCPU_List_Push(Data->List, &Item->Node);
+		}
+	}
+	return 0;
+}
+
+/*Runs pinned to a single cpu so every pop sees the pushes of the same thread*/
+static AK_THREAD_CALLBACK_DEFINE(PerCPU_List_LIFO_Thread) {
+	percpu_list_data* Data = (percpu_list_data*)UserData;
+	uint32_t i;
+	(void)Thread;
+	Data->LIFOResult = 1;
+	for(i = 0; i < 3; i++) AK_PerCPU_List_Push(Data->List, &Data->Items[i].Node);
+	for(i = 3; i > 0; i--) {
+		if(AK_PerCPU_List_Pop(Data->List) != &Data->Items[i-1].Node) Data->LIFOResult = 0;
+	}
+	if(AK_PerCPU_List_Pop(Data->List) != NULL) Data->LIFOResult = 0;
+	return 0;
+}
+
+UTEST(PerCPU, List) {
+	ak_percpu_list List;
+	percpu_list_data Data;
+	ak_thread* Threads[PERCPU_THREAD_COUNT];
+	ak_thread_create_info CreateInfo;
+	ak_cpu_topology Topology;
+	percpu_list_item* Items = (percpu_list_item*)Allocate_Memory(sizeof(percpu_list_item)*PERCPU_NODE_COUNT);
+	uint32_t i;
+
+	ASSERT_TRUE(AK_PerCPU_List_Create(&List));
+	Memory_Clear(Items, sizeof(percpu_list_item)*PERCPU_NODE_COUNT);
+	Memory_Clear(&Data, sizeof(percpu_list_data));
+	Data.List = &List;
+	Data.Items = Items;
+
+	Memory_Clear(&CreateInfo, sizeof(ak_thread_create_info));
+	if(AK_Get_CPU_Topology(&Topology)) {
+		if(Topology.CPUs[0].ID < 64) CreateInfo.AffinityMask = 1ull << Topology.CPUs[0].ID;
+		AK_Free_CPU_Topology(&Topology);
+	}
+	AK_Thread_Delete(AK_Thread_Create_Ex(PerCPU_List_LIFO_Thread, &Data, &CreateInfo));
+	ASSERT_TRUE(Data.LIFOResult == 1);
+
+	for(i = 0; i < PERCPU_NODE_COUNT; i++) AK_PerCPU_List_Push(&List, &Items[i].Node);
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(PerCPU_List_Thread, &Data);
+	}
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Data.ErrorCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 0);
+
+	AK_PerCPU_List_Delete(&List);
+	Free_Memory(Items);
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Sharded_Counter_Thread) {
+	ak_sharded_counter* Counter = (ak_sharded_counter*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < PERCPU_ITERATIONS; i++) AK_Sharded_Counter_Add(Counter, 2);
+	return 0;
+}
+
+UTEST(ShardedCounter, Add) {
+	ak_sharded_counter Counter;
+	ak_thread* Threads[PERCPU_THREAD_COUNT];
+	uint32_t i;
+
+	/*Rounded up to four cells*/
+	ASSERT_TRUE(AK_Sharded_Counter_Create(&Counter, 3));
+	ASSERT_TRUE(Counter.CellMask == 3);
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Sharded_Counter_Thread, &Counter);
+	}
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+
+	ASSERT_TRUE(AK_Sharded_Counter_Load(&Counter) == (uint64_t)PERCPU_THREAD_COUNT*PERCPU_ITERATIONS*2);
+	AK_Sharded_Counter_Delete(&Counter);
+}
+
+static AK_THREAD_CALLBACK_DEFINE(Adaptive_Counter_Thread) {
+	ak_adaptive_counter* Counter = (ak_adaptive_counter*)UserData;
+	uint32_t i;
+	(void)Thread;
+	for(i = 0; i < PERCPU_ITERATIONS; i++) AK_Adaptive_Counter_Add(Counter, 1);
+	return 0;
+}
+
+UTEST(AdaptiveCounter, Add) {
+	ak_adaptive_counter Counter;
+	ak_thread* Threads[PERCPU_THREAD_COUNT];
+	uint32_t i;
+
+	/*Without contention the counter never inflates*/
+	AK_Adaptive_Counter_Create(&Counter, 0, 1);
+	for(i = 0; i < 1000; i++) AK_Adaptive_Counter_Add(&Counter, 1);
+	ASSERT_FALSE(AK_Adaptive_Counter_Is_Inflated(&Counter));
+	ASSERT_TRUE(AK_Adaptive_Counter_Load(&Counter) == 1000);
+
+	/*Whether it inflates depends on the scheduling, the total must be exact either way*/
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) {
+		Threads[i] = AK_Thread_Create(Adaptive_Counter_Thread, &Counter);
+	}
+	for(i = 0; i < PERCPU_THREAD_COUNT; i++) AK_Thread_Delete(Threads[i]);
+	ASSERT_TRUE(AK_Adaptive_Counter_Load(&Counter) == 1000 + (uint64_t)PERCPU_THREAD_COUNT*PERCPU_ITERATIONS);
+
+	AK_Adaptive_Counter_Delete(&Counter);
+}
+
+#ifdef AK_ATOMIC_FIBERS
+typedef struct {
+	ak_atomic_u32* LeafCount;
+	uint32_t 	   Depth;
+} fiber_tree_node;
+
+static AK_FIBER_JOB_CALLBACK_DEFINE(Fiber_Tree_Job) {
+	fiber_tree_node* Node = (fiber_tree_node*)UserData;
+	if(Node->Depth == 0) {
+		AK_Atomic_Increment_U32(Node->LeafCount, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	} else {
+		ak_atomic_u32 Counter;
+		fiber_tree_node Children[2];
+		Children[0].LeafCount = Node->LeafCount;
+		Children[0].Depth = Node->Depth-1;
+		Children[1] = Children[0];
+
+		AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+		AK_Fiber_Job_System_Submit(JobSystem, Fiber_Tree_Job, &Children[0], &Counter);
+		AK_Fiber_Job_System_Submit(JobSystem, Fiber_Tree_Job, &Children[1], &Counter);
+		AK_Fiber_Job_System_Wait(JobSystem, &Counter);
+	}
+}
+
+UTEST(FiberJobSystem, Nested_Wait) {
+	ak_atomic_u32 LeafCount;
+	ak_atomic_u32 Counter;
+	fiber_tree_node Root;
+	/*Fewer fibers than tree nodes so jobs also have to fall back to running inline*/
+	ak_fiber_job_system* JobSystem = AK_Fiber_Job_System_Create(4, 32, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	AK_Atomic_Store_U32(&LeafCount, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Root.LeafCount = &LeafCount;
+	Root.Depth = 10;
+
+	AK_Fiber_Job_System_Submit(JobSystem, Fiber_Tree_Job, &Root, &Counter);
+	AK_Fiber_Job_System_Wait(JobSystem, &Counter);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&LeafCount, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 1024u);
+
+	AK_Fiber_Job_System_Delete(JobSystem);
+}
+
+typedef struct {
+	ak_atomic_u32* Gate;
+	ak_atomic_u32* Ran;
+} fiber_gate_data;
+
+static AK_FIBER_JOB_CALLBACK_DEFINE(Fiber_Gate_Wait_Job) {
+	fiber_gate_data* Data = (fiber_gate_data*)UserData;
+	AK_Fiber_Job_System_Wait(JobSystem, Data->Gate);
+	AK_Atomic_Increment_U32(Data->Ran, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+}
+
+static AK_FIBER_JOB_CALLBACK_DEFINE(Fiber_Gate_Run_Job) {
+	fiber_gate_data* Data = (fiber_gate_data*)UserData;
+	AK_Atomic_Increment_U32(Data->Ran, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	(void)JobSystem;
+}
+
+UTEST(FiberJobSystem, Wait_Yields_Worker) {
+	ak_atomic_u32 Gate, Ran, Counter;
+	fiber_gate_data Data;
+	int Iterations = 0;
+	/*A single worker must still run the second job while the first one is blocked*/
+	ak_fiber_job_system* JobSystem = AK_Fiber_Job_System_Create(1, 0, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	AK_Atomic_Store_U32(&Gate, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Ran, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Data.Gate = &Gate;
+	Data.Ran = &Ran;
+
+	AK_Fiber_Job_System_Submit(JobSystem, Fiber_Gate_Wait_Job, &Data, &Counter);
+	AK_Fiber_Job_System_Submit(JobSystem, Fiber_Gate_Run_Job, &Data, NULL);
+
+	while(AK_Atomic_Load_U32(&Ran, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 0 && Iterations++ < 10000) {
+		AK_Sleep(1);
+	}
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Ran, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 1u);
+
+	AK_Fiber_Job_System_Decrement(JobSystem, &Gate);
+	AK_Fiber_Job_System_Wait(JobSystem, &Counter);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Ran, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 2u);
+
+	AK_Fiber_Job_System_Delete(JobSystem);
+}
+
+UTEST(FiberJobSystem, Decrement_Wakes_All_Waiters) {
+	ak_atomic_u32 Gate, Ran, Counter;
+	fiber_gate_data Data;
+	int Iterations = 0;
+	uint32_t i;
+	/*More waiters than workers, all parked on the same counter until it is released*/
+	ak_fiber_job_system* JobSystem = AK_Fiber_Job_System_Create(2, 16, 0);
+	ASSERT_TRUE(JobSystem != NULL);
+
+	AK_Atomic_Store_U32(&Gate, 1, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Ran, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	AK_Atomic_Store_U32(&Counter, 0, AK_ATOMIC_MEMORY_ORDER_RELAXED);
+	Data.Gate = &Gate;
+	Data.Ran = &Ran;
+
+	for(i = 0; i < 8; i++) AK_Fiber_Job_System_Submit(JobSystem, Fiber_Gate_Wait_Job, &Data, &Counter);
+	AK_Fiber_Job_System_Submit(JobSystem, Fiber_Gate_Run_Job, &Data, NULL);
+
+	while(AK_Atomic_Load_U32(&Ran, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 0 && Iterations++ < 10000) {
+		AK_Sleep(1);
+	}
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Ran, AK_ATOMIC_MEMORY_ORDER_ACQUIRE) == 1u);
+
+	AK_Fiber_Job_System_Decrement(JobSystem, &Gate);
+	AK_Fiber_Job_System_Wait(JobSystem, &Counter);
+	ASSERT_TRUE(AK_Atomic_Load_U32(&Ran, AK_ATOMIC_MEMORY_ORDER_RELAXED) == 9u);
+
+	AK_Fiber_Job_System_Delete(JobSystem);
+}
+#endif
+
 #ifndef __ANDROID__
 UTEST_MAIN();
 #endif